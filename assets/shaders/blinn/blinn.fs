@@ -1,4 +1,4 @@
-#version 330
+#version 460
 out vec4 frag_color;
 in vec3 vs_normal;
 in vec2 vs_texcoord;
@@ -6,57 +6,9 @@ in vec3 world_position;
 
 // ********** LIGHTNING **********
 
-struct Material{
-    vec3 ambient_color;
-    vec3 diffuse_color;
-    vec3 specular_color;
-    float specular_shininess;
-};
-
-struct Intensity{
-    float ambient;
-    float diffuse;
-    float specular;
-};
-
-struct PointLight{
-    vec3 position;
-    vec3 color;
-    Intensity intensity;
-    float illumination_radius;
-};
-
-struct DirectionalLight{
-    vec3 direction;
-    vec3 color;
-    Intensity intensity;
-};
-
-struct SpotLight{
-    vec3 position;
-    vec3 direction;
-    vec3 color;
-    Intensity intensity;
-    float illumination_radius;
-    float inner_cone_angle_degrees;
-    float outer_cone_angle_degrees;
-};
-
-#define MAX_POINT_LIGHTS 4
-#define MAX_DIRECTIONAL_LIGHTS 1
-#define MAX_SPOT_LIGHTS 4
-
-struct Light{
-    PointLight point_lights[MAX_POINT_LIGHTS];
-    DirectionalLight directional_lights[MAX_DIRECTIONAL_LIGHTS];
-    SpotLight spot_lights[MAX_SPOT_LIGHTS];
-    int num_point_lights;
-    int num_directional_lights;
-    int num_spot_lights;
-};
-
-uniform Light light;
-uniform Material material;
+#include "../common/materials.glsl"
+
+#include "../common/entity_lights.glsl"
 
 vec3 point_light_ambient(PointLight light){
     return light.intensity.ambient * light.color * material.ambient_color;
@@ -166,16 +118,19 @@ vec3 spot_light(SpotLight light, vec3 normal, vec3 light_direction, vec3 view_di
 
 vec3 all_lights(vec3 normal, vec3 view_direction, vec3 world_position){
     vec3 light_color = vec3(0.0f);
-    for (int i = 0; i < light.num_point_lights; i++) {
-        vec3 light_direction = normalize(light.point_lights[i].position - world_position);
-        light_color += point_light(light.point_lights[i], normal, light_direction, view_direction, world_position);
+    uvec4 lights = fragment_lights(world_position);
+    for (uint i = 0; i < lights.y; i++) {
+        PointLight point = list_point_light(lights, i);
+        vec3 light_direction = normalize(point.position - world_position);
+        light_color += point_light(point, normal, light_direction, view_direction, world_position);
     }
     for (int i = 0; i < light.num_directional_lights; i++) {
         light_color += directional_light(light.directional_lights[i], normal, view_direction);
     }
-    for (int i = 0; i < light.num_spot_lights; i++) {
-        vec3 light_direction = normalize(light.spot_lights[i].position - world_position);
-        light_color += spot_light(light.spot_lights[i], normal, light_direction, view_direction, world_position);
+    for (uint i = 0; i < lights.z; i++) {
+        SpotLight spot = list_spot_light(lights, i);
+        vec3 light_direction = normalize(spot.position - world_position);
+        light_color += spot_light(spot, normal, light_direction, view_direction, world_position);
     }
 
     return light_color;
@@ -184,31 +139,35 @@ vec3 all_lights(vec3 normal, vec3 view_direction, vec3 world_position){
 
 // ********** LIGHTNING **********
 
-uniform vec3 camera_position;
-uniform mat3 normal_matrix;
+#include "../common/frame.glsl"
+flat in mat3 normal_matrix;
 
 void main () {
+    material = materials[material_index];
     vec3 normal = normalize(normal_matrix * vs_normal);
     vec3 view_direction = normalize(camera_position - world_position);
-    vec3 light_direction = normalize(light.point_lights[0].position - world_position);
-    vec3 half_direction = normalize(light_direction + view_direction);
+    uvec4 lights = fragment_lights(world_position);
 
     vec3 blinn_color = vec3(0.0f);
 
-    for (int i = 0; i < light.num_point_lights; i++) {
-        vec3 ambient_light = point_light_ambient(light.point_lights[i]);
-        vec3 diffuse_light = point_light_diffuse(light.point_lights[i], normal, light_direction);
+    for (uint i = 0; i < lights.y; i++) {
+        PointLight point = list_point_light(lights, i);
+        vec3 light_direction = normalize(point.position - world_position);
+        vec3 half_direction = normalize(light_direction + view_direction);
+        vec3 ambient_light = point_light_ambient(point);
+        vec3 diffuse_light = point_light_diffuse(point, normal, light_direction);
 
         float specular_factor = pow(max(dot(normal, half_direction), 0.0f), material.specular_shininess);
-        vec3 specular_light = specular_factor * light.point_lights[i].intensity.specular * light.point_lights[i].color * material.specular_color;
+        vec3 specular_light = specular_factor * point.intensity.specular * point.color * material.specular_color;
 
-        float attenuation = point_light_attenuation(light.point_lights[i], world_position);
+        float attenuation = point_light_attenuation(point, world_position);
 
         blinn_color += attenuation * (ambient_light + diffuse_light + specular_light);
         
     }
 
     for (int i = 0; i < light.num_directional_lights; i++) {
+        vec3 half_direction = normalize(-light.directional_lights[i].direction + view_direction);
         vec3 ambient_light = directional_light_ambient(light.directional_lights[i]);
         vec3 diffuse_light = directional_light_diffuse(light.directional_lights[i], normal);
 
@@ -218,15 +177,18 @@ void main () {
         blinn_color += ambient_light + diffuse_light + specular_light;
     }
 
-    for (int i = 0; i < light.num_spot_lights; i++) {
-        vec3 ambient_light = spot_light_ambient(light.spot_lights[i]);
-        vec3 diffuse_light = spot_light_diffuse(light.spot_lights[i], normal, light_direction);
+    for (uint i = 0; i < lights.z; i++) {
+        SpotLight spot = list_spot_light(lights, i);
+        vec3 light_direction = normalize(spot.position - world_position);
+        vec3 half_direction = normalize(light_direction + view_direction);
+        vec3 ambient_light = spot_light_ambient(spot);
+        vec3 diffuse_light = spot_light_diffuse(spot, normal, light_direction);
 
         float specular_factor = pow(max(dot(normal, half_direction), 0.0f), material.specular_shininess);
-        vec3 specular_light = specular_factor * light.spot_lights[i].intensity.specular * light.spot_lights[i].color * material.specular_color;
+        vec3 specular_light = specular_factor * spot.intensity.specular * spot.color * material.specular_color;
 
-        float attenuation = spot_light_attenuation(light.spot_lights[i], world_position);
-        float cone = spot_light_cone(light.spot_lights[i], light_direction);
+        float attenuation = spot_light_attenuation(spot, world_position);
+        float cone = spot_light_cone(spot, light_direction);
 
         blinn_color += attenuation * cone * (ambient_light + diffuse_light + specular_light);
     }
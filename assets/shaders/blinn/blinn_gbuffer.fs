@@ -0,0 +1,12 @@
+#version 460
+in vec3 vs_normal;
+in vec2 vs_texcoord;
+in vec3 world_position;
+
+#include "../common/gbuffer.glsl"
+
+flat in mat3 normal_matrix;
+
+void main () {
+    write_gbuffer(vec3(1.0f), normal_matrix * vs_normal, LIGHTING_BLINN);
+}
@@ -0,0 +1,24 @@
+// Per entity data, mirrored on the CPU by EntityData in entity_data.hpp, std430 layout.
+// Instances of a draw start at gl_BaseInstance in draw_entities, mirrored by DrawEntityData.
+// x is the index into entities, yzw the light list of the entity, see entity_lights.glsl.
+struct EntityData{
+    mat4 model_matrix;
+    mat3 normal_matrix;
+    int material_index;
+};
+
+layout(std430) readonly buffer EntityBlock{
+    EntityData entities[];
+};
+
+layout(std430) readonly buffer DrawEntityBlock{
+    uvec4 draw_entities[];
+};
+
+EntityData current_entity(){
+    return entities[draw_entities[gl_BaseInstance + gl_InstanceID].x];
+}
+
+uvec3 current_entity_lights(){
+    return draw_entities[gl_BaseInstance + gl_InstanceID].yzw;
+}
@@ -0,0 +1,16 @@
+// Lights of the drawn entity, assigned by LightAssignment in light_assignment.hpp and forwarded by the vertex shader.
+// Fragments loop over the shorter of the entity list and their cluster list, both hold every light that reaches them.
+#include "lights.glsl"
+
+const uint UNASSIGNED_LIGHTS = 0xFFFFFFFFu;
+
+flat in uvec3 entity_lights;
+
+// x is the offset into light_indices, y the number of point lights and z the number of spot lights, same as a cluster
+uvec4 fragment_lights(vec3 world_position){
+    uvec4 cluster = light_cluster(world_position);
+    if (entity_lights.x != UNASSIGNED_LIGHTS and entity_lights.y + entity_lights.z < cluster.y + cluster.z) {
+        return uvec4(entity_lights, 0u);
+    }
+    return cluster;
+}
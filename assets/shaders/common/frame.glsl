@@ -0,0 +1,10 @@
+// Per frame constants, mirrored on the CPU by FrameBlockData in frame_uniforms.hpp, std140 layout.
+
+layout(std140) uniform FrameBlock{
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    mat4 view_projection_matrix;
+    mat4 inverse_view_projection_matrix;
+    vec3 camera_position;
+    float time;
+};
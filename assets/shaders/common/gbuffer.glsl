@@ -0,0 +1,14 @@
+// Outputs of G-buffer shader variants, attachments are created by GBuffer in gbuffer.hpp.
+// Lighting happens later in deferred/deferred_lighting.fs, which switches on the lighting model.
+#include "materials.glsl"
+#include "lighting_models.glsl"
+
+layout(location = 0) out vec4 gbuffer_albedo;
+layout(location = 1) out vec4 gbuffer_normal;
+layout(location = 2) out uvec2 gbuffer_material;
+
+void write_gbuffer(vec3 albedo, vec3 normal, uint lighting_model){
+    gbuffer_albedo = vec4(albedo, 1.0f);
+    gbuffer_normal = vec4(normalize(normal), 0.0f);
+    gbuffer_material = uvec2(uint(material_index), lighting_model);
+}
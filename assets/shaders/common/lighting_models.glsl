@@ -0,0 +1,4 @@
+// Lighting model a G-buffer texel is shaded with, 0 marks texels no geometry was drawn to.
+const uint LIGHTING_PHONG = 1u;
+const uint LIGHTING_BLINN = 2u;
+const uint LIGHTING_LAMBERT = 3u;
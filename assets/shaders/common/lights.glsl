@@ -0,0 +1,82 @@
+// Shared by all lighting shaders, mirrored on the CPU in light_buffer.hpp.
+// LightBlock is std140, the light storage blocks are std430, keep both sides in sync when changing anything here.
+
+#include "frame.glsl"
+
+struct Intensity{
+    float ambient;
+    float diffuse;
+    float specular;
+};
+
+struct PointLight{
+    vec3 position;
+    float illumination_radius;
+    vec3 color;
+    float padding;
+    Intensity intensity;
+};
+
+struct DirectionalLight{
+    vec3 direction;
+    vec3 color;
+    Intensity intensity;
+};
+
+struct SpotLight{
+    vec3 position;
+    float illumination_radius;
+    vec3 direction;
+    float inner_cone_angle_degrees;
+    vec3 color;
+    float outer_cone_angle_degrees;
+    Intensity intensity;
+};
+
+#define MAX_DIRECTIONAL_LIGHTS 4
+
+layout(std140) uniform LightBlock{
+    DirectionalLight directional_lights[MAX_DIRECTIONAL_LIGHTS];
+    int num_directional_lights;
+    int num_point_lights;
+    int num_spot_lights;
+    vec2 cluster_tile_size;
+    float cluster_depth_scale;
+    float cluster_depth_bias;
+} light;
+
+layout(std430) readonly buffer PointLightBlock{
+    PointLight point_lights[];
+};
+
+layout(std430) readonly buffer SpotLightBlock{
+    SpotLight spot_lights[];
+};
+
+// Lights binned into view frustum clusters by LightClusters in light_clusters.hpp.
+// x is the offset into light_indices, y the number of point lights and z the number of spot lights which follow them.
+const uvec3 CLUSTER_GRID = uvec3(16, 9, 24);
+
+layout(std430) readonly buffer LightClusterBlock{
+    uvec4 light_clusters[];
+};
+
+layout(std430) readonly buffer LightIndexBlock{
+    uint light_indices[];
+};
+
+uvec4 light_cluster(vec3 world_position){
+    float depth = -(view_matrix * vec4(world_position, 1.0f)).z;
+    uint slice = uint(clamp(floor(log(depth) * light.cluster_depth_scale + light.cluster_depth_bias), 0.0f, float(CLUSTER_GRID.z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / light.cluster_tile_size), CLUSTER_GRID.xy - 1);
+    return light_clusters[tile.x + CLUSTER_GRID.x * (tile.y + CLUSTER_GRID.y * slice)];
+}
+
+// lights of a cluster or of an entity light list, both are laid out the same in light_indices
+PointLight list_point_light(uvec4 list, uint i){
+    return point_lights[light_indices[list.x + i]];
+}
+
+SpotLight list_spot_light(uvec4 list, uint i){
+    return spot_lights[light_indices[list.x + list.y + i]];
+}
@@ -0,0 +1,13 @@
+// Parameters of every material in the scene, mirrored on the CPU by MaterialParameters in material.hpp, std140 layout.
+#define MAX_MATERIALS 256
+
+struct Material{
+    vec3 ambient_color;
+    vec3 diffuse_color;
+    vec3 specular_color;
+    float specular_shininess;
+};
+
+layout(std140) uniform MaterialBlock{
+    Material materials[MAX_MATERIALS];
+};
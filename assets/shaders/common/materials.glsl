@@ -0,0 +1,6 @@
+// Material of the drawn instance, the vertex shader forwards the per instance index into the MaterialBlock.
+// main() copies the entry into material before lighting.
+#include "material_block.glsl"
+
+flat in int material_index;
+Material material;
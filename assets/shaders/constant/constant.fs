@@ -1,4 +1,4 @@
-#version 330
+#version 460
 out vec4 frag_color;
 in vec3 vs_normal;
 in vec2 vs_texcoord;
@@ -7,19 +7,13 @@ in vec3 world_position;
 uniform sampler2D fs_tex0;
 
 
-struct Material{
-    vec3 ambient_color;
-    vec3 diffuse_color;
-    vec3 specular_color;
-    float specular_shininess;
-};
+#include "../common/materials.glsl"
 
 
-uniform Material material;
-
-uniform mat3 normal_matrix;
+flat in mat3 normal_matrix;
 
 void main () {
+    material = materials[material_index];
     // frag_color = vec4 (point_lights[0].color, 1.0f);
     // frag_color = texture(fs_tex0, vs_texcoord);
 
@@ -0,0 +1,96 @@
+#version 460
+out vec4 frag_color;
+in vec2 screen_texcoord;
+
+// attachments of GBuffer in gbuffer.hpp, units follow the trailing digits
+uniform sampler2D gbuffer_0;
+uniform sampler2D gbuffer_1;
+uniform usampler2D gbuffer_2;
+uniform sampler2D gbuffer_3;
+
+#include "../common/lighting_models.glsl"
+#include "../common/material_block.glsl"
+
+#include "../common/lights.glsl"
+
+Material material;
+uint lighting_model;
+
+float specular_factor(vec3 normal, vec3 light_direction, vec3 view_direction){
+    if (lighting_model == LIGHTING_LAMBERT) {
+        return 0.0f;
+    }
+    if (lighting_model == LIGHTING_BLINN) {
+        vec3 half_direction = normalize(light_direction + view_direction);
+        return pow(max(dot(normal, half_direction), 0.0f), material.specular_shininess);
+    }
+    vec3 reflect_direction = reflect(-light_direction, normal);
+    return pow(max(dot(view_direction, reflect_direction), 0.0f), material.specular_shininess);
+}
+
+vec3 shade(Intensity intensity, vec3 color, vec3 normal, vec3 light_direction, vec3 view_direction){
+    float diffuse_factor = max(dot(normal, light_direction), 0.0f);
+    vec3 ambient_light = intensity.ambient * color * material.ambient_color;
+    vec3 diffuse_light = diffuse_factor * intensity.diffuse * color * material.diffuse_color;
+    vec3 specular_light = specular_factor(normal, light_direction, view_direction) * intensity.specular * color * material.specular_color;
+    return ambient_light + diffuse_light + specular_light;
+}
+
+float attenuation(vec3 light_position, float illumination_radius, vec3 world_position){
+    float distance = length(light_position - world_position);
+    return max(1.0f - distance / illumination_radius * 2.0f, 0.0f);
+}
+
+float spot_light_cone(SpotLight light, vec3 light_direction){
+    float cos_inner_cone_angle = cos(radians(light.inner_cone_angle_degrees));
+    float cos_outer_cone_angle = cos(radians(light.outer_cone_angle_degrees));
+    float cos_angle = dot(light.direction, -light_direction);
+    if (cos_angle >= cos_inner_cone_angle) {
+        return 1.0f;
+    } else if (cos_angle < cos_outer_cone_angle) {
+        return 0.0f;
+    }
+    float t = (cos_angle - cos_outer_cone_angle) / (cos_inner_cone_angle - cos_outer_cone_angle);
+    // the forward blinn shader falls off linearly, the others quadratically
+    return lighting_model == LIGHTING_BLINN ? t : t * t;
+}
+
+void main () {
+    uvec2 material_data = texelFetch(gbuffer_2, ivec2(gl_FragCoord.xy), 0).xy;
+    lighting_model = material_data.y;
+    if (lighting_model == 0u) {
+        discard;
+    }
+    material = materials[material_data.x];
+
+    vec3 albedo = texelFetch(gbuffer_0, ivec2(gl_FragCoord.xy), 0).rgb;
+    vec3 normal = texelFetch(gbuffer_1, ivec2(gl_FragCoord.xy), 0).xyz;
+    float depth = texelFetch(gbuffer_3, ivec2(gl_FragCoord.xy), 0).r;
+
+    vec4 clip_position = vec4(vec3(screen_texcoord, depth) * 2.0f - 1.0f, 1.0f);
+    vec4 world = inverse_view_projection_matrix * clip_position;
+    vec3 world_position = world.xyz / world.w;
+    vec3 view_direction = normalize(camera_position - world_position);
+
+    vec3 light_color = vec3(0.0f);
+    uvec4 cluster = light_cluster(world_position);
+    for (uint i = 0; i < cluster.y; i++) {
+        PointLight point = list_point_light(cluster, i);
+        vec3 light_direction = normalize(point.position - world_position);
+        light_color += attenuation(point.position, point.illumination_radius, world_position)
+            * shade(point.intensity, point.color, normal, light_direction, view_direction);
+    }
+    for (int i = 0; i < light.num_directional_lights; i++) {
+        DirectionalLight directional = light.directional_lights[i];
+        light_color += shade(directional.intensity, directional.color, normal, -normalize(directional.direction), view_direction);
+    }
+    for (uint i = 0; i < cluster.z; i++) {
+        SpotLight spot = list_spot_light(cluster, i);
+        vec3 light_direction = normalize(spot.position - world_position);
+        light_color += attenuation(spot.position, spot.illumination_radius, world_position)
+            * spot_light_cone(spot, light_direction)
+            * shade(spot.intensity, spot.color, normal, light_direction, view_direction);
+    }
+
+    frag_color = vec4(albedo * light_color, 1.0f);
+}
@@ -0,0 +1,9 @@
+#version 460
+// one triangle covering the screen, no vertex buffers needed
+out vec2 screen_texcoord;
+
+void main () {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    screen_texcoord = position;
+    gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
@@ -1,66 +1,18 @@
-#version 330
+#version 460
 out vec4 frag_color;
 
 in vec3 vs_normal;
 in vec2 vs_texcoord;
 in vec3 world_position;
 
-uniform vec3 camera_position;
-uniform mat3 normal_matrix;
+#include "../common/frame.glsl"
+flat in mat3 normal_matrix;
 
 // ********** LIGHTNING **********
 
-struct Material{
-    vec3 ambient_color;
-    vec3 diffuse_color;
-    vec3 specular_color;
-    float specular_shininess;
-};
-
-struct Intensity{
-    float ambient;
-    float diffuse;
-    float specular;
-};
-
-struct PointLight{
-    vec3 position;
-    vec3 color;
-    Intensity intensity;
-    float illumination_radius;
-};
-
-struct DirectionalLight{
-    vec3 direction;
-    vec3 color;
-    Intensity intensity;
-};
-
-struct SpotLight{
-    vec3 position;
-    vec3 direction;
-    vec3 color;
-    Intensity intensity;
-    float illumination_radius;
-    float inner_cone_angle_degrees;
-    float outer_cone_angle_degrees;
-};
-
-#define MAX_POINT_LIGHTS 4
-#define MAX_DIRECTIONAL_LIGHTS 1
-#define MAX_SPOT_LIGHTS 4
-
-struct Light{
-    PointLight point_lights[MAX_POINT_LIGHTS];
-    DirectionalLight directional_lights[MAX_DIRECTIONAL_LIGHTS];
-    SpotLight spot_lights[MAX_SPOT_LIGHTS];
-    int num_point_lights;
-    int num_directional_lights;
-    int num_spot_lights;
-};
-
-uniform Light light;
-uniform Material material;
+#include "../common/materials.glsl"
+
+#include "../common/lights.glsl"
 
 vec3 point_light_ambient(PointLight light){
     return light.intensity.ambient * light.color * material.ambient_color;
@@ -170,16 +122,19 @@ vec3 spot_light(SpotLight light, vec3 normal, vec3 light_direction, vec3 view_di
 
 vec3 all_lights(vec3 normal, vec3 view_direction, vec3 world_position){
     vec3 light_color = vec3(0.0f);
-    for (int i = 0; i < light.num_point_lights; i++) {
-        vec3 light_direction = normalize(light.point_lights[i].position - world_position);
-        light_color += point_light(light.point_lights[i], normal, light_direction, view_direction, world_position);
+    uvec4 cluster = light_cluster(world_position);
+    for (uint i = 0; i < cluster.y; i++) {
+        PointLight point = list_point_light(cluster, i);
+        vec3 light_direction = normalize(point.position - world_position);
+        light_color += point_light(point, normal, light_direction, view_direction, world_position);
     }
     for (int i = 0; i < light.num_directional_lights; i++) {
         light_color += directional_light(light.directional_lights[i], normal, view_direction);
     }
-    for (int i = 0; i < light.num_spot_lights; i++) {
-        vec3 light_direction = normalize(light.spot_lights[i].position - world_position);
-        light_color += spot_light(light.spot_lights[i], normal, light_direction, view_direction, world_position);
+    for (uint i = 0; i < cluster.z; i++) {
+        SpotLight spot = list_spot_light(cluster, i);
+        vec3 light_direction = normalize(spot.position - world_position);
+        light_color += spot_light(spot, normal, light_direction, view_direction, world_position);
     }
 
     return light_color;
@@ -204,6 +159,7 @@ const float grass_width = 1;
 const float density = 512;
 
 void main () {
+    material = materials[material_index];
    vec3 output_grass_color = grass_color;
 
     uvec2 tposu = uvec2(vs_texcoord * density);
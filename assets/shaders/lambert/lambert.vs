@@ -1,4 +1,4 @@
-#version 330
+#version 460
 layout(location=0) in vec3 vertex_position;
 layout(location=1) in vec3 vertex_normal;
 layout(location=2) in vec2 vertex_texcoord;
@@ -6,11 +6,21 @@ out vec3 vs_normal;
 out vec2 vs_texcoord;
 out vec3 world_position;
 
-uniform mat4 mvp_matrix;
-uniform mat4 model_matrix;
+#include "../common/entity.glsl"
+
+flat out mat3 normal_matrix;
+flat out int material_index;
+flat out uvec3 entity_lights;
+
+#include "../common/frame.glsl"
 
 void main () {
-    gl_Position = mvp_matrix * vec4(vertex_position, 1.0);
+    EntityData entity = current_entity();
+    mat4 model_matrix = entity.model_matrix;
+    gl_Position = view_projection_matrix * model_matrix * vec4(vertex_position, 1.0);
+    normal_matrix = entity.normal_matrix;
+    material_index = entity.material_index;
+    entity_lights = current_entity_lights();
     vs_normal = vertex_normal;
     vs_texcoord = vertex_texcoord;
     world_position = (model_matrix * vec4(vertex_position, 1.0)).xyz;
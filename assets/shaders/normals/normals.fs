@@ -1,4 +1,4 @@
-#version 330
+#version 460
 out vec4 frag_colour;
 in vec3 vs_normal;
 void main () {
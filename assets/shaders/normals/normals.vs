@@ -1,11 +1,19 @@
-#version 330
+#version 460
 layout(location=0) in vec3 vertex_position;
 layout(location=1) in vec3 vertex_normal;
 out vec3 vs_normal;
-uniform mat4 mvp_matrix;
-uniform mat4 model_matrix;
+#include "../common/entity.glsl"
+
+flat out mat3 normal_matrix;
+flat out int material_index;
+
+#include "../common/frame.glsl"
 
 void main () {
-    gl_Position = mvp_matrix * vec4(vertex_position, 1.0);
+    EntityData entity = current_entity();
+    mat4 model_matrix = entity.model_matrix;
+    gl_Position = view_projection_matrix * model_matrix * vec4(vertex_position, 1.0);
+    normal_matrix = entity.normal_matrix;
+    material_index = entity.material_index;
     vs_normal = vertex_normal;
 }
\ No newline at end of file
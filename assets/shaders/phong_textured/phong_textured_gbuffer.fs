@@ -0,0 +1,15 @@
+#version 460
+in vec3 vs_normal;
+in vec2 vs_texcoord;
+in vec3 world_position;
+
+uniform sampler2D fs_tex0;
+
+#include "../common/gbuffer.glsl"
+
+flat in mat3 normal_matrix;
+
+void main () {
+    vec3 self_color = texture(fs_tex0, vs_texcoord).xyz;
+    write_gbuffer(self_color, normal_matrix * vs_normal, LIGHTING_PHONG);
+}
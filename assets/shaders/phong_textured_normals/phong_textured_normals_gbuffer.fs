@@ -0,0 +1,17 @@
+#version 460
+in vec3 vs_normal;
+in vec2 vs_texcoord;
+in vec3 world_position;
+in mat3 tbn_matrix;
+
+uniform sampler2D texture_0;
+uniform sampler2D texture_1;
+
+#include "../common/gbuffer.glsl"
+
+void main () {
+    vec3 self_color = texture(texture_0, vs_texcoord).rgb;
+
+    vec3 normal_rgb = texture(texture_1, vs_texcoord).rgb * 2.0f - 1.0f;
+    write_gbuffer(self_color, tbn_matrix * normal_rgb, LIGHTING_PHONG);
+}
@@ -1,4 +1,4 @@
-#version 330
+#version 460
 out vec4 frag_color;
 in vec3 vs_normal;
 in vec2 vs_texcoord;
@@ -15,24 +15,19 @@ struct PointLight{
     float illumination_radius;
 };
 
-struct Material{
-    vec3 ambient_color;
-    vec3 diffuse_color;
-    vec3 specular_color;
-    float specular_shininess;
-};
+#include "../common/materials.glsl"
 
 
 #define MAX_POINT_LIGHTS 4
 uniform int num_point_lights;
 uniform PointLight point_lights[MAX_POINT_LIGHTS];
-uniform Material material;
 
-uniform vec3 camera_position;
-uniform mat3 normal_matrix;
+#include "../common/frame.glsl"
+flat in mat3 normal_matrix;
 
 
 void main () {
+    material = materials[material_index];
     // frag_color = vec4 (point_lights[0].color, 1.0f);
     // frag_color = texture(fs_tex0, vs_texcoord);
 
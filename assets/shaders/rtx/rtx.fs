@@ -1,4 +1,4 @@
-#version 330
+#version 460
 out vec4 frag_color;
 in vec3 vs_normal;
 in vec2 vs_texcoord;
@@ -19,8 +19,8 @@ struct PointLight{
 uniform int num_point_lights;
 uniform PointLight point_lights[MAX_POINT_LIGHTS];
 
-uniform vec3 camera_position;
-uniform mat3 normal_matrix;
+#include "../common/frame.glsl"
+flat in mat3 normal_matrix;
 
 uniform samplerCube skybox;
 
@@ -0,0 +1,312 @@
+#include "animation.hpp"
+#include "mat4_compositor.hpp"
+#include "logger.hpp"
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace yazpgp
+{
+    namespace
+    {
+        // clips sampled by one job, sampling a clip costs a few matrix products per track
+        constexpr uint32_t CLIPS_PER_JOB = 128;
+
+        // pre-multiplied translation, T * m
+        glm::mat4 translated(glm::mat4 m, const glm::vec3& translation)
+        {
+            for (int column = 0; column < 4; column++)
+                m[column] += glm::vec4(translation * m[column].w, 0.0f);
+            return m;
+        }
+
+        // de Casteljau over one curve of the path
+        glm::vec3 bezier(const glm::vec3* points, uint32_t count, float t)
+        {
+            glm::vec3 scratch[Animation::MAX_BEZIER_POINTS];
+            std::copy(points, points + count, scratch);
+            for (uint32_t level = count - 1; level > 0; level--)
+            {
+                for (uint32_t i = 0; i < level; i++)
+                    scratch[i] += t * (scratch[i + 1] - scratch[i]);
+            }
+            return scratch[0];
+        }
+
+        Animation::Track track_of(Animation::TrackType type)
+        {
+            return Animation::Track{ .type = type, .channel = Animation::Channel::Translation, .playback = Animation::Playback::Loop };
+        }
+    }
+
+    Animation& Animation::rotate(const glm::vec3& degrees_per_second, const glm::vec3& initial_degrees)
+    {
+        auto track = track_of(TrackType::Rotate);
+        track.base = initial_degrees;
+        track.rate = degrees_per_second;
+        m_tracks.push_back(track);
+        return *this;
+    }
+
+    Animation& Animation::translate(const glm::vec3& offset, const glm::vec3& velocity)
+    {
+        auto track = track_of(TrackType::Translate);
+        track.base = offset;
+        track.rate = velocity;
+        m_tracks.push_back(track);
+        return *this;
+    }
+
+    Animation& Animation::oscillate(const glm::vec3& amplitude, float frequency, float phase)
+    {
+        auto track = track_of(TrackType::Oscillate);
+        track.base = amplitude;
+        track.frequency = frequency;
+        track.phase = phase;
+        m_tracks.push_back(track);
+        return *this;
+    }
+
+    Animation& Animation::bezier_path(const std::vector<glm::vec3>& points, uint32_t points_per_curve, float duration, Playback playback)
+    {
+        if (points_per_curve < 2 or points_per_curve > MAX_BEZIER_POINTS or points.empty() or points.size() % points_per_curve != 0)
+        {
+            YAZPGP_LOG_WARN("Bezier path of %zu points does not split into curves of %u points, ignoring track", points.size(), points_per_curve);
+            return *this;
+        }
+
+        auto track = track_of(TrackType::BezierPath);
+        track.playback = playback;
+        track.duration = duration;
+        track.first = static_cast<uint32_t>(m_points.size());
+        track.count = static_cast<uint32_t>(points.size());
+        track.points_per_curve = points_per_curve;
+        m_points.insert(m_points.end(), points.begin(), points.end());
+        m_tracks.push_back(track);
+        return *this;
+    }
+
+    Animation& Animation::keyframes(Channel channel, const std::vector<Keyframe>& keyframes)
+    {
+        if (keyframes.empty())
+        {
+            YAZPGP_LOG_WARN("Keyframe track without keyframes, ignoring track");
+            return *this;
+        }
+
+        auto track = track_of(TrackType::Keyframes);
+        track.channel = channel;
+        track.first = static_cast<uint32_t>(m_keyframes.size());
+        track.count = static_cast<uint32_t>(keyframes.size());
+        m_keyframes.insert(m_keyframes.end(), keyframes.begin(), keyframes.end());
+        m_tracks.push_back(track);
+        return *this;
+    }
+
+    bool Animation::empty() const
+    {
+        return m_tracks.empty();
+    }
+
+    const std::vector<Animation::Track>& Animation::tracks() const
+    {
+        return m_tracks;
+    }
+
+    const std::vector<glm::vec3>& Animation::points() const
+    {
+        return m_points;
+    }
+
+    const std::vector<Animation::Keyframe>& Animation::keyframe_values() const
+    {
+        return m_keyframes;
+    }
+
+    void Animator::add(const Animation& animation)
+    {
+        m_animations.push_entity();
+        if (animation.empty())
+            return;
+
+        m_animations.set(static_cast<uint32_t>(m_animations.size() - 1), animation);
+        m_dirty = true;
+    }
+
+    void Animator::set(uint32_t entity, const Animation& animation)
+    {
+        if (entity >= m_animations.size())
+        {
+            YAZPGP_LOG_ERROR("Entity index %u out of range", entity);
+            return;
+        }
+
+        if (animation.empty())
+            m_animations.erase(entity);
+        else
+            m_animations.set(entity, animation);
+        m_dirty = true;
+    }
+
+    void Animator::remove(uint32_t entity)
+    {
+        if (entity >= m_animations.size())
+            return;
+
+        m_animations.remove_entity(entity);
+        m_dirty = true;
+    }
+
+    void Animator::clear()
+    {
+        m_animations.clear();
+        m_dirty = true;
+    }
+
+    void Animator::flatten()
+    {
+        m_clips.clear();
+        m_animated.clear();
+        m_tracks.clear();
+        m_points.clear();
+        m_keyframes.clear();
+
+        const auto& animations = m_animations.values();
+        for (size_t i = 0; i < animations.size(); i++)
+        {
+            const auto& animation = animations[i];
+            const uint32_t entity = m_animations.entities()[i];
+
+            const auto point_offset = static_cast<uint32_t>(m_points.size());
+            const auto keyframe_offset = static_cast<uint32_t>(m_keyframes.size());
+            m_clips.push_back({
+                .entity = entity,
+                .first_track = static_cast<uint32_t>(m_tracks.size()),
+                .track_count = static_cast<uint32_t>(animation.tracks().size())
+            });
+            m_animated.push_back(entity);
+
+            for (auto track : animation.tracks())
+            {
+                if (track.type == Animation::TrackType::BezierPath)
+                    track.first += point_offset;
+                else if (track.type == Animation::TrackType::Keyframes)
+                    track.first += keyframe_offset;
+                m_tracks.push_back(track);
+            }
+            m_points.insert(m_points.end(), animation.points().begin(), animation.points().end());
+            m_keyframes.insert(m_keyframes.end(), animation.keyframe_values().begin(), animation.keyframe_values().end());
+        }
+
+        m_dirty = false;
+    }
+
+    void Animator::sample(double time, const TransformStore& transforms, std::vector<glm::mat4>& local_matrices, JobSystem* jobs)
+    {
+        if (m_dirty)
+            flatten();
+
+        local_matrices.resize(m_clips.size());
+        parallel_for(jobs, static_cast<uint32_t>(m_clips.size()), CLIPS_PER_JOB, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const auto& clip = m_clips[i];
+                glm::mat4 m = transforms.model_matrix(clip.entity);
+                for (uint32_t track = clip.first_track; track < clip.first_track + clip.track_count; track++)
+                    m = apply(m_tracks[track], time, m);
+                local_matrices[i] = m;
+            }
+        });
+    }
+
+    glm::mat4 Animator::apply(const Animation::Track& track, double time, const glm::mat4& m) const
+    {
+        switch (track.type)
+        {
+            case Animation::TrackType::Rotate:
+            {
+                // wrapped in double, large times would eat the float precision of the angle
+                const glm::vec3 angles = track.base + glm::vec3(
+                    std::fmod(track.rate.x * time, 360.0),
+                    std::fmod(track.rate.y * time, 360.0),
+                    std::fmod(track.rate.z * time, 360.0)
+                );
+                return compositor::Rotate{angles}(glm::mat4(1.0f)) * m;
+            }
+            case Animation::TrackType::Translate:
+                return translated(m, track.base + track.rate * static_cast<float>(time));
+            case Animation::TrackType::Oscillate:
+            {
+                const double cycles = std::fmod(track.frequency * time, 1.0);
+                const float wave = std::sin(static_cast<float>(2.0 * glm::pi<double>() * cycles) + track.phase);
+                return translated(m, track.base * wave);
+            }
+            case Animation::TrackType::BezierPath:
+            {
+                const double progress = track.duration > 0.0f ? time / track.duration : 1.0;
+                const float t = track.playback == Animation::Playback::PingPong
+                    ? static_cast<float>(0.5 - 0.5 * std::cos(glm::pi<double>() * std::fmod(progress, 2.0)))
+                    : static_cast<float>(progress - std::floor(progress));
+
+                const uint32_t curve_count = track.count / track.points_per_curve;
+                const float curve_t = t * curve_count;
+                const uint32_t curve = std::min(static_cast<uint32_t>(curve_t), curve_count - 1);
+                const glm::vec3* points = &m_points[track.first + curve * track.points_per_curve];
+                return translated(m, bezier(points, track.points_per_curve, curve_t - curve));
+            }
+            case Animation::TrackType::Keyframes:
+            {
+                const Animation::Keyframe* first = &m_keyframes[track.first];
+                const Animation::Keyframe* last = first + track.count - 1;
+                const float t = last->time > 0.0f ? static_cast<float>(std::fmod(time, static_cast<double>(last->time))) : 0.0f;
+
+                const auto* next = std::upper_bound(first, last + 1, t, [](float t, const Animation::Keyframe& keyframe) { return t < keyframe.time; });
+                glm::vec3 value;
+                if (next == first)
+                    value = first->value;
+                else if (next > last)
+                    value = last->value;
+                else
+                {
+                    const auto* previous = next - 1;
+                    const float span = next->time - previous->time;
+                    value = glm::mix(previous->value, next->value, span > 0.0f ? (t - previous->time) / span : 0.0f);
+                }
+
+                switch (track.channel)
+                {
+                    case Animation::Channel::Translation:
+                        return translated(m, value);
+                    case Animation::Channel::Rotation:
+                        return compositor::Rotate{value}(glm::mat4(1.0f)) * m;
+                    case Animation::Channel::Scale:
+                        return compositor::Scale{value}(glm::mat4(1.0f)) * m;
+                }
+                return m;
+            }
+        }
+        return m;
+    }
+
+    bool Animator::animates(uint32_t entity) const
+    {
+        return m_animations.contains(entity);
+    }
+
+    const std::vector<uint32_t>& Animator::animated() const
+    {
+        return m_animated;
+    }
+
+    size_t Animator::track_count() const
+    {
+        return m_tracks.size();
+    }
+
+    size_t Animator::size() const
+    {
+        return m_animations.size();
+    }
+}
@@ -15,8 +15,8 @@
 #include "application.hpp"
 #include "logger.hpp"
 #include "shader.hpp"
-#include "renderable_entity.hpp"
 #include "io.hpp"
+#include "asset_loader.hpp"
 #include "phong_blinn_material.hpp"
 
 #include "scene.hpp"
@@ -28,12 +28,12 @@
 #include "debug/debug_ui.hpp"
 #include "asset_storage.hpp"
 #include "demo_scenes.hpp"
-#include "bezier_list.hpp"
 namespace yazpgp
 {
     Application::Application(const ApplicationConfig& config)
         : m_config(config)
         , m_window(nullptr)
+        , m_job_system(std::make_unique<JobSystem>())
     {
 
     }
@@ -60,34 +60,38 @@ namespace yazpgp
         if (not m_window)
             return 1;
 
+        // meshes, textures and cubemaps stream in while the scenes already render their placeholders
+        m_asset_loader = std::make_unique<AssetLoader>(*m_job_system);
+        auto& loader = *m_asset_loader;
+
         AssetStorage<Mesh> meshes;
         AssetStorage<Shader> shaders;
         AssetStorage<Texture> textures;
 
-        if (not meshes.add("ball", io::load_mesh_from_file("assets/models/ball.obj"))) return 1;
-        if (not meshes.add("cube", io::load_mesh_from_file("assets/models/cube.obj"))) return 1;
-        if (not meshes.add("tonk", io::load_mesh_from_file("assets/models/tonk.fbx"))) return 1;
-        if (not meshes.add("grid", io::load_mesh_from_file("assets/models/grid20m20x20.obj"))) return 1;
-        if (not meshes.add("mad", io::load_mesh_from_file("assets/models/mad.obj"))) return 1;
-        if (not meshes.add("plane", io::load_mesh_from_file("assets/models/plane.obj"))) return 1;
-        if (not meshes.add("tree", io::load_mesh_from_file("assets/models/tree.obj"))) return 1;
-        if (not meshes.add("bush", io::load_mesh_from_file("assets/models/bush.obj"))) return 1;
-        if (not meshes.add("suzi", io::load_mesh_from_file("assets/models/suzi.obj"))) return 1;
-        if (not meshes.add("rat", io::load_mesh_from_file("assets/models/rat.obj"))) return 1;
-        if (not meshes.add("terrain", io::load_mesh_from_file("assets/models/terrain.obj"))) return 1;
-        if (not meshes.add("backpack", io::load_mesh_from_file("assets/models/backpack.obj"))) return 1;
-
-
-        if (not textures.add("tonk", io::load_texture_from_file("assets/textures/tonk_diff.png"))) return 1;
-        if (not textures.add("tonk_normal", io::load_texture_from_file("assets/textures/tonk_normal.png"))) return 1;
-        if (not textures.add("mad", io::load_texture_from_file("assets/textures/mad.png"))) return 1;
-        if (not textures.add("grass", io::load_texture_from_file("assets/textures/grass.png"))) return 1;
-        if (not textures.add("rat", io::load_texture_from_file("assets/textures/rat_diff.jpg"))) return 1;
-        if (not textures.add("wall", io::load_texture_from_file("assets/textures/brickwall_diff.jpg"))) return 1;
-        if (not textures.add("wall_normal", io::load_texture_from_file("assets/textures/brickwall_normal.jpg"))) return 1;
-        if (not textures.add("rat_normal", io::load_texture_from_file("assets/textures/rat_normal.png"))) return 1;
-        if (not textures.add("backpack", io::load_texture_from_file("assets/textures/backpack_diff.jpg"))) return 1;
-        if (not textures.add("backpack_normal", io::load_texture_from_file("assets/textures/backpack_normal.png"))) return 1;
+        if (not meshes.add("ball", loader.load_mesh("assets/models/ball.obj"))) return 1;
+        if (not meshes.add("cube", loader.load_mesh("assets/models/cube.obj"))) return 1;
+        if (not meshes.add("tonk", loader.load_mesh("assets/models/tonk.fbx"))) return 1;
+        if (not meshes.add("grid", loader.load_mesh("assets/models/grid20m20x20.obj"))) return 1;
+        if (not meshes.add("mad", loader.load_mesh("assets/models/mad.obj"))) return 1;
+        if (not meshes.add("plane", loader.load_mesh("assets/models/plane.obj"))) return 1;
+        if (not meshes.add("tree", loader.load_mesh("assets/models/tree.obj"))) return 1;
+        if (not meshes.add("bush", loader.load_mesh("assets/models/bush.obj"))) return 1;
+        if (not meshes.add("suzi", loader.load_mesh("assets/models/suzi.obj"))) return 1;
+        if (not meshes.add("rat", loader.load_mesh("assets/models/rat.obj"))) return 1;
+        if (not meshes.add("terrain", loader.load_mesh("assets/models/terrain.obj"))) return 1;
+        if (not meshes.add("backpack", loader.load_mesh("assets/models/backpack.obj"))) return 1;
+
+
+        if (not textures.add("tonk", loader.load_texture("assets/textures/tonk_diff.png"))) return 1;
+        if (not textures.add("tonk_normal", loader.load_texture("assets/textures/tonk_normal.png"))) return 1;
+        if (not textures.add("mad", loader.load_texture("assets/textures/mad.png"))) return 1;
+        if (not textures.add("grass", loader.load_texture("assets/textures/grass.png"))) return 1;
+        if (not textures.add("rat", loader.load_texture("assets/textures/rat_diff.jpg"))) return 1;
+        if (not textures.add("wall", loader.load_texture("assets/textures/brickwall_diff.jpg"))) return 1;
+        if (not textures.add("wall_normal", loader.load_texture("assets/textures/brickwall_normal.jpg"))) return 1;
+        if (not textures.add("rat_normal", loader.load_texture("assets/textures/rat_normal.png"))) return 1;
+        if (not textures.add("backpack", loader.load_texture("assets/textures/backpack_diff.jpg"))) return 1;
+        if (not textures.add("backpack_normal", loader.load_texture("assets/textures/backpack_normal.png"))) return 1;
 
 
         if (not shaders.add("white", Shader::create_default_shader(1.f, 1.f, 1.f, 1.f))) return 1;
@@ -148,6 +152,24 @@ namespace yazpgp
             "assets/shaders/grass/grass.fs"
         ))) return 1;
 
+        if (not shaders.add("deferred_lighting", io::load_shader_from_file(
+            "assets/shaders/deferred/deferred_lighting.vs",
+            "assets/shaders/deferred/deferred_lighting.fs"
+        ))) return 1;
+
+        // G-buffer variants reuse the vertex shader of their forward shader
+        for (const std::string name : {"phong", "phong_textured", "phong_textured_normals", "blinn", "lambert"})
+        {
+            auto gbuffer_variant = io::load_shader_from_file(
+                "assets/shaders/" + name + "/" + name + ".vs",
+                "assets/shaders/" + name + "/" + name + "_gbuffer.fs"
+            );
+            if (not gbuffer_variant)
+                return 1;
+
+            shaders[name]->set_gbuffer_variant(gbuffer_variant);
+        }
+
         // auto cubemap_ocean = io::load_cubemap_from_files({
         //     "assets/textures/skybox_ocean/right.jpg",
         //     "assets/textures/skybox_ocean/left.jpg",
@@ -159,7 +181,7 @@ namespace yazpgp
         // if (not cubemap_ocean)
         //     return 1;
 
-        auto cubemap_factory = io::load_cubemap_from_files({
+        auto cubemap_factory = loader.load_cubemap({
             "assets/textures/skybox_factory/face0.png",
             "assets/textures/skybox_factory/face1.png",
             "assets/textures/skybox_factory/face2.png",
@@ -170,7 +192,7 @@ namespace yazpgp
         if (not cubemap_factory)
             return 1;
 
-        auto cubemap_forest = io::load_cubemap_from_files({
+        auto cubemap_forest = loader.load_cubemap({
             "assets/textures/skybox_forest/face0.png",
             "assets/textures/skybox_forest/face1.png",
             "assets/textures/skybox_forest/face2.png",
@@ -179,7 +201,7 @@ namespace yazpgp
             "assets/textures/skybox_forest/face5.png",
         });
 
-        auto cubemap_nightsky = io::load_cubemap_from_files({
+        auto cubemap_nightsky = loader.load_cubemap({
             "assets/textures/skybox_nightsky/face0.png",
             "assets/textures/skybox_nightsky/face1.png",
             "assets/textures/skybox_nightsky/face2.png",
@@ -198,10 +220,12 @@ namespace yazpgp
 
         // Solar system scene
         scenes.push_back(DemoScenes::phong_four_balls(meshes, shaders));
-        scenes.push_back(DemoScenes::solar_system(meshes, shaders, *m_window));
+        scenes.push_back(DemoScenes::solar_system(meshes, shaders));
         // scenes.push_back(DemoScenes::ball_between_light_and_camera(meshes, shaders));
         scenes.push_back(DemoScenes::squish_test(meshes, shaders, textures));
-        scenes.emplace_back(std::move(DemoScenes::forest(meshes, shaders, textures).set_skybox(skybox_nightsky)));
+        scenes.emplace_back(std::move(DemoScenes::forest(meshes, shaders, textures)
+            .set_skybox(skybox_nightsky)
+            .set_deferred_shading(shaders["deferred_lighting"])));
         scenes.emplace_back(std::move(DemoScenes::normal_mapping(meshes, shaders, textures).set_skybox(skybox_factory)));
         scenes.emplace_back(std::move(DemoScenes::shell_texturing(meshes, shaders, textures).set_skybox(skybox_forest)));
         scenes.emplace_back(std::move(DemoScenes::terrain(meshes, shaders, textures).set_skybox(skybox_forest)));
@@ -269,43 +293,45 @@ namespace yazpgp
         );
         scenes[current_scene].invoke_distributors();
 
-        constexpr auto bezier_points = 4;
+        constexpr uint32_t bezier_points = 4;
         std::vector<glm::vec3> current_bezier_points;
-        BezierList<bezier_points> bezier_list;
+        // every finished curve, bezier_points control points each
+        std::vector<glm::vec3> bezier_path_points;
+        const size_t bezier_scene = scenes.size();
         Scene s;
         s.add_entity(Scene::SceneRenderableEntity{
             .shader = shaders["phong"],
             .mesh = meshes["ball"],
             .material = PhongBlinnMaterial::default_material(),
-            .transform_modifier = [&](const glm::mat4& m) {
-                static float dt = 0.f;
-                dt += 0.01f;
-
-                float t = std::sin(dt) * 0.5f + 0.5f;
-
-                glm::vec3 position = bezier_list(t);
-
-                return Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Translate(position),
-                })(m);
-            }
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = shaders["phong_textured"],
             .mesh = meshes["terrain"],
             .textures = {textures["grass"]},
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_light(DirectionalLight().set_direction({0.f, -1.f, 0.f}))
         .set_skybox(skybox_forest)
         .camera().move_up(5.f);
         scenes.push_back(std::move(s));
+
+        for (auto& scene : scenes)
+            scene.set_job_system(m_job_system.get());
         
 
+        // a few uploads per frame keep the window responsive while large batches arrive
+        constexpr size_t max_uploads_per_frame = 4;
         while (m_window->is_running())
         {
             auto& scene = scenes[current_scene];
             m_window->pool_events();
+            loader.process_uploads(max_uploads_per_frame);
+            if (loader.pending() > 0)
+            {
+                ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+                ImGui::Text("Loading assets: %zu", loader.pending());
+                ImGui::End();
+            }
             scene.update(m_window->input_manager(), m_window->delta_time());
             scene.render(projection_matrix);
             DebugUI::scene_window(scene);
@@ -316,22 +342,32 @@ namespace yazpgp
             // ImGui::End();
             auto& input_manager = this->m_window->input_manager();
 
-            uint32_t entity_id_under_mouse = m_window->get_stencil_value(input_manager.mouse_x(), input_manager.mouse_y());
-            if (entity_id_under_mouse > 0 and not m_window->mouse_is_relative())
+            uint32_t stencil_under_mouse = m_window->get_stencil_value(input_manager.mouse_x(), input_manager.mouse_y());
+            std::optional<size_t> entity_id_under_mouse;
+            if (stencil_under_mouse > 0 and not m_window->mouse_is_relative())
+            {
+                float depth_at = m_window->get_depth_value(input_manager.mouse_x(), input_manager.mouse_y());
+                glm::vec3 screen_position = glm::vec3(input_manager.mouse_x(), m_window->height() - input_manager.mouse_y(), depth_at);
+                glm::vec4 viewport = glm::vec4(0, 0, m_window->width(), m_window->height());
+                auto world_position = glm::unProject(screen_position, scene.camera().view_matrix(), projection_matrix, viewport);
+                entity_id_under_mouse = scene.pick(stencil_under_mouse, world_position);
+            }
+
+            if (entity_id_under_mouse)
             {
-                auto& entity = scene.entities()[entity_id_under_mouse - 1];
+                const auto transform = scene.transform(*entity_id_under_mouse);
                 ImGui::Begin("Entity Info", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse);
                 ImGui::SetWindowPos({static_cast<float>(input_manager.mouse_x()), static_cast<float>(input_manager.mouse_y())});
-                ImGui::Text("Entity ID: %d", entity_id_under_mouse - 1);
-                ImGui::Text("Entity Position: (%f, %f, %f)", entity->transform().position_data.x, entity->transform().position_data.y, entity->transform().position_data.z);
-                ImGui::Text("Entity Rotation: (%f, %f, %f)", entity->transform().rotation_data.x, entity->transform().rotation_data.y, entity->transform().rotation_data.z);
-                ImGui::Text("Entity Scale: (%f, %f, %f)", entity->transform().scale_data.x, entity->transform().scale_data.y, entity->transform().scale_data.z);
+                ImGui::Text("Entity ID: %zu", *entity_id_under_mouse);
+                ImGui::Text("Entity Position: (%f, %f, %f)", transform.position_data.x, transform.position_data.y, transform.position_data.z);
+                ImGui::Text("Entity Rotation: (%f, %f, %f)", transform.rotation_data.x, transform.rotation_data.y, transform.rotation_data.z);
+                ImGui::Text("Entity Scale: (%f, %f, %f)", transform.scale_data.x, transform.scale_data.y, transform.scale_data.z);
                 ImGui::End();
             }
 
-            if (entity_id_under_mouse > 0 and input_manager.get_key_down(Key::T) and not m_window->mouse_is_relative())
+            if (entity_id_under_mouse and input_manager.get_key_down(Key::T))
             {
-                scene.entities().erase(scene.entities().begin() + entity_id_under_mouse - 1);
+                scene.remove_entity(*entity_id_under_mouse);
             }
 
 
@@ -353,19 +389,17 @@ namespace yazpgp
                         .textures = {textures["mad"]},
                         .transform = Transform::default_transform().translate(unprojected),
                         .material = PhongBlinnMaterial::default_material(),
-                    }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+                    });
                 }
 
                 if (input_manager.get_key_down(Key::B))
                 {
                     current_bezier_points.push_back(unprojected);
-                    if (current_bezier_points.size() % 4 == 0)
+                    if (current_bezier_points.size() % bezier_points == 0)
                     {
-                        std::array<glm::vec3, bezier_points> points;
-                        for (size_t i = 0; i < bezier_points; i++)
-                            points[i] = current_bezier_points[i];
-                        
-                        bezier_list.add_curve(BezierCurve<bezier_points>(points));
+                        bezier_path_points.insert(bezier_path_points.end(), current_bezier_points.begin(), current_bezier_points.end());
+                        const float duration = 5.0f * (bezier_path_points.size() / bezier_points);
+                        scenes[bezier_scene].set_animation(0, Animation().bezier_path(bezier_path_points, bezier_points, duration));
                         current_bezier_points.clear();
                         current_bezier_points.push_back(unprojected);
                     }
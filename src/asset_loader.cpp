@@ -0,0 +1,152 @@
+#include "asset_loader.hpp"
+#include "io.hpp"
+#include "mesh_cache.hpp"
+#include "texture_cache.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace yazpgp
+{
+    namespace
+    {
+        void resume_on_worker(void* context, uint32_t, uint32_t)
+        {
+            std::coroutine_handle<>::from_address(context).resume();
+        }
+    }
+
+    void AssetLoader::WorkerAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        // off the deques wait() drains, a frame waiting on its own jobs must not run an import
+        loader.m_jobs.run_background(&resume_on_worker, handle.address(), loader.m_worker_hops);
+    }
+
+    void AssetLoader::RenderThreadAwaiter::await_suspend(std::coroutine_handle<> handle)
+    {
+        this->handle = handle;
+        // the render thread may resume and free the frame right after the exchange, nothing touches this afterwards
+        RenderThreadAwaiter* head = loader.m_upload_head.load(std::memory_order_relaxed);
+        do
+        {
+            next = head;
+        } while (not loader.m_upload_head.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    AssetLoader::AssetLoader(JobSystem& jobs)
+        : m_jobs(jobs)
+    {
+    }
+
+    AssetLoader::~AssetLoader()
+    {
+        while (pending() > 0)
+        {
+            m_jobs.wait(m_worker_hops);
+            process_uploads(SIZE_MAX);
+        }
+    }
+
+    std::shared_ptr<Mesh> AssetLoader::load_mesh(const std::string& path)
+    {
+        std::shared_ptr<Mesh> mesh = Mesh::create_placeholder();
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        mesh_task(mesh, path);
+        return mesh;
+    }
+
+    std::shared_ptr<Texture2D> AssetLoader::load_texture(const std::string& path)
+    {
+        constexpr char white[] = { '\xff', '\xff', '\xff', '\xff' };
+        auto texture = std::make_shared<Texture2D>(white, 1, 1, 4);
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        texture_task(texture, path);
+        return texture;
+    }
+
+    std::shared_ptr<CubeMap> AssetLoader::load_cubemap(const std::array<std::string, 6>& paths)
+    {
+        // rows of 3 bytes are padded to the default unpack alignment of 4
+        constexpr char black[] = { 0, 0, 0, 0 };
+        const CubeMap::CubeMapDataPart face{ .bytes = black, .width = 1, .height = 1, .channels = 3 };
+        auto cubemap = std::make_shared<CubeMap>(std::array<CubeMap::CubeMapDataPart, 6>{ face, face, face, face, face, face });
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        cubemap_task(cubemap, paths);
+        return cubemap;
+    }
+
+    AssetLoader::WorkerAwaiter AssetLoader::on_worker()
+    {
+        return WorkerAwaiter{ *this };
+    }
+
+    AssetLoader::RenderThreadAwaiter AssetLoader::on_render_thread()
+    {
+        return RenderThreadAwaiter{ *this };
+    }
+
+    size_t AssetLoader::process_uploads(size_t max_uploads)
+    {
+        // the stack is newest first, reversed so uploads run in the order the loads finished
+        const size_t first_new = m_ready_uploads.size();
+        for (auto* awaiter = m_upload_head.exchange(nullptr, std::memory_order_acquire); awaiter; awaiter = awaiter->next)
+            m_ready_uploads.push_back(awaiter);
+        std::reverse(m_ready_uploads.begin() + first_new, m_ready_uploads.end());
+
+        size_t uploads = 0;
+        while (uploads < max_uploads and not m_ready_uploads.empty())
+        {
+            // resuming may free the awaiter together with its coroutine frame
+            const auto handle = m_ready_uploads.front()->handle;
+            m_ready_uploads.pop_front();
+            handle.resume();
+            uploads++;
+        }
+        return uploads;
+    }
+
+    size_t AssetLoader::pending() const
+    {
+        return m_pending.load(std::memory_order_relaxed);
+    }
+
+    AssetLoader::Task AssetLoader::mesh_task(std::shared_ptr<Mesh> mesh, std::string path)
+    {
+        co_await on_worker();
+        auto blob = io::read_cached_mesh(path);
+
+        co_await on_render_thread();
+        if (blob.has_value())
+            mesh->replace(blob->vertices, blob->indices, blob->bounds, blob->bounding_sphere, blob->layout, blob->lods, blob->meshlets);
+        else
+            YAZPGP_LOG_ERROR("Keeping the placeholder of mesh %s", path.c_str());
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    AssetLoader::Task AssetLoader::texture_task(std::shared_ptr<Texture2D> texture, std::string path)
+    {
+        co_await on_worker();
+        auto cooked = io::read_cooked_texture(path);
+
+        co_await on_render_thread();
+        if (cooked.has_value())
+            texture->upload_levels(cooked->internal_format, cooked->format, cooked->levels);
+        else
+            YAZPGP_LOG_ERROR("Keeping the placeholder of texture %s", path.c_str());
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    AssetLoader::Task AssetLoader::cubemap_task(std::shared_ptr<CubeMap> cubemap, std::array<std::string, 6> paths)
+    {
+        co_await on_worker();
+        auto cooked = io::read_cooked_cubemap(paths);
+
+        co_await on_render_thread();
+        if (cooked.has_value())
+            cubemap->upload_levels(cooked->internal_format, cooked->format, cooked->level_count, cooked->levels);
+        else
+            YAZPGP_LOG_ERROR("Keeping the placeholder of cubemap %s", paths[0].c_str());
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
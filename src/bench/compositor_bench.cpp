@@ -0,0 +1,157 @@
+// Evaluates the moon orbit of the solar system demo with the variant based compositor the transform
+// modifiers used before, with compositor::chain and with Mat4InstructionList.
+// Build with -DYAZPGP_BUILD_BENCHMARKS=ON and a Release build type.
+
+#include "mat4_compositor.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <variant>
+#include <vector>
+
+namespace
+{
+    size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations++;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    // the compositor as Transform::Mat4Compositor implemented it, kept as the baseline
+    struct LegacyCompositor
+    {
+        struct TranslateData
+        {
+            glm::vec3 translation;
+        };
+        struct RotateData
+        {
+            glm::vec3 rotation;
+        };
+        using Mat4Data = glm::mat4;
+        struct CompositeData
+        {
+            std::vector<LegacyCompositor> compositor;
+        };
+
+        std::variant<TranslateData, RotateData, CompositeData, Mat4Data> compositor;
+
+        LegacyCompositor(const TranslateData& translate) : compositor(translate) {}
+        LegacyCompositor(const RotateData& rotate) : compositor(rotate) {}
+        LegacyCompositor(const CompositeData& composite) : compositor(composite) {}
+        LegacyCompositor(const Mat4Data& mat4 = glm::mat4(1.0f)) : compositor(mat4) {}
+
+        glm::mat4 operator()(glm::mat4 transform = glm::mat4(1.0f)) const
+        {
+            return std::visit(Visitor{transform}, compositor);
+        }
+
+        struct Visitor
+        {
+            glm::mat4& transform;
+            glm::mat4 operator()(const TranslateData& translate) const
+            {
+                return glm::translate(transform, translate.translation);
+            }
+            glm::mat4 operator()(const RotateData& rotate) const
+            {
+                return glm::rotate(transform, glm::radians(rotate.rotation.x), {1, 0, 0}) *
+                       glm::rotate(transform, glm::radians(rotate.rotation.y), {0, 1, 0}) *
+                       glm::rotate(transform, glm::radians(rotate.rotation.z), {0, 0, 1});
+            }
+            glm::mat4 operator()(const Mat4Data& mat4) const
+            {
+                return mat4 * transform;
+            }
+            glm::mat4 operator()(const CompositeData& composite) const
+            {
+                glm::mat4 result = transform;
+                for (const auto& compositor : composite.compositor)
+                    result = compositor(result);
+                return result;
+            }
+        };
+
+        static LegacyCompositor Translate(const glm::vec3& translation) { return LegacyCompositor(TranslateData{translation}); }
+        static LegacyCompositor Rotate(const glm::vec3& rotation) { return LegacyCompositor(RotateData{rotation}); }
+        static LegacyCompositor Composite(std::initializer_list<LegacyCompositor> compositor) { return LegacyCompositor(CompositeData{compositor}); }
+    };
+
+    constexpr size_t ITERATIONS = 1000000;
+
+    template<class Evaluate>
+    void run(const char* name, Evaluate evaluate)
+    {
+        const glm::mat4 parent = glm::translate(glm::mat4(1.0f), {5.0f, 0.0f, 0.0f});
+        float checksum = 0.0f;
+
+        const size_t allocations_before = g_allocations;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ITERATIONS; i++)
+        {
+            const float angle = static_cast<float>(i) * 0.001f;
+            checksum += evaluate(angle, parent)[3][0];
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+        const double allocations = static_cast<double>(g_allocations - allocations_before) / ITERATIONS;
+        std::printf("%-24s %8.2f ns/eval %6.2f allocations/eval (checksum %g)\n", name, nanoseconds, allocations, checksum);
+    }
+}
+
+int main()
+{
+    using namespace yazpgp;
+
+    run("variant compositor", [](float angle, const glm::mat4& parent)
+    {
+        return LegacyCompositor::Composite({
+            LegacyCompositor::Composite({
+                LegacyCompositor::Rotate({0, angle, 0}),
+                LegacyCompositor::Translate({0, 0, 8}),
+            }),
+            parent,
+        })();
+    });
+
+    run("compositor::chain", [](float angle, const glm::mat4& parent)
+    {
+        return compositor::chain(
+            compositor::Rotate{{0, angle, 0}},
+            compositor::Translate{{0, 0, 8}},
+            compositor::Multiply{parent}
+        )();
+    });
+
+    // data driven chains are built once, the animated angle is the input matrix here
+    Mat4InstructionList instructions;
+    instructions.translate({0, 0, 8}).multiply(glm::translate(glm::mat4(1.0f), {5.0f, 0.0f, 0.0f}));
+    run("Mat4InstructionList", [&instructions](float angle, const glm::mat4&)
+    {
+        return instructions(glm::rotate(glm::mat4(1.0f), glm::radians(angle), {0, 1, 0}));
+    });
+
+    return 0;
+}
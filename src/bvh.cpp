@@ -0,0 +1,705 @@
+#include "bvh.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <array>
+
+namespace yazpgp
+{
+    namespace
+    {
+        constexpr int SAH_BIN_COUNT = 16;
+        // smaller subtrees are built on the thread that split them, a job would cost more than it saves
+        constexpr size_t PARALLEL_BUILD_THRESHOLD = 1024;
+
+        bool ray_intersects(const AABB& aabb, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance, float& distance)
+        {
+            const glm::vec3 t1 = (aabb.min - origin) * inverse_direction;
+            const glm::vec3 t2 = (aabb.max - origin) * inverse_direction;
+            const glm::vec3 t_near = glm::min(t1, t2);
+            const glm::vec3 t_far = glm::max(t1, t2);
+            const float t_enter = std::max({t_near.x, t_near.y, t_near.z, 0.0f});
+            const float t_exit = std::min({t_far.x, t_far.y, t_far.z, max_distance});
+            distance = t_enter;
+            return t_enter <= t_exit;
+        }
+    }
+
+    Bvh::Bvh(float margin)
+        : m_root(NULL_NODE)
+        , m_free_list(NULL_NODE)
+        , m_leaf_count(0)
+        , m_margin(margin)
+    {
+    }
+
+    int32_t Bvh::allocate_node()
+    {
+        if (m_free_list == NULL_NODE)
+        {
+            const size_t old_size = m_nodes.size();
+            const size_t new_size = std::max<size_t>(16, old_size * 2);
+            m_nodes.resize(new_size);
+            for (size_t i = old_size; i < new_size; i++)
+            {
+                m_nodes[i].parent = i + 1 < new_size ? static_cast<int32_t>(i + 1) : NULL_NODE;
+                m_nodes[i].height = -1;
+            }
+            m_free_list = static_cast<int32_t>(old_size);
+        }
+
+        const int32_t node = m_free_list;
+        m_free_list = m_nodes[node].parent;
+        m_nodes[node] = Node{};
+        m_nodes[node].height = 0;
+        return node;
+    }
+
+    void Bvh::free_node(int32_t node)
+    {
+        m_nodes[node].parent = m_free_list;
+        m_nodes[node].height = -1;
+        m_free_list = node;
+    }
+
+    AABB Bvh::fatten(const AABB& aabb) const
+    {
+        const glm::vec3 margin = glm::vec3(m_margin) + aabb.extents() * m_margin;
+        return AABB{ aabb.min - margin, aabb.max + margin };
+    }
+
+    Bvh::ProxyId Bvh::insert(const AABB& aabb, uint32_t user_data)
+    {
+        const int32_t leaf = allocate_node();
+        m_nodes[leaf].aabb = fatten(aabb);
+        m_nodes[leaf].user_data = user_data;
+        insert_leaf(leaf);
+        m_leaf_count++;
+        return leaf;
+    }
+
+    void Bvh::remove(ProxyId proxy)
+    {
+        if (proxy < 0 or static_cast<size_t>(proxy) >= m_nodes.size() or not m_nodes[proxy].is_leaf() or m_nodes[proxy].height < 0)
+        {
+            YAZPGP_LOG_ERROR("Bvh::remove: invalid proxy %d", proxy);
+            return;
+        }
+        remove_leaf(proxy);
+        free_node(proxy);
+        m_leaf_count--;
+    }
+
+    bool Bvh::update(ProxyId proxy, const AABB& aabb)
+    {
+        if (m_nodes[proxy].aabb.contains(aabb))
+            return false;
+
+        remove_leaf(proxy);
+        m_nodes[proxy].aabb = fatten(aabb);
+        insert_leaf(proxy);
+        return true;
+    }
+
+    void Bvh::insert_leaf(int32_t leaf)
+    {
+        if (m_root == NULL_NODE)
+        {
+            m_root = leaf;
+            m_nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // walk down choosing the child with the smallest SAH cost increase
+        const AABB leaf_aabb = m_nodes[leaf].aabb;
+        int32_t index = m_root;
+        while (not m_nodes[index].is_leaf())
+        {
+            const Node& node = m_nodes[index];
+            const float area = node.aabb.surface_area();
+            const float combined_area = AABB::merge(node.aabb, leaf_aabb).surface_area();
+            const float cost = 2.0f * combined_area;
+            const float inheritance_cost = 2.0f * (combined_area - area);
+
+            auto descend_cost = [&](int32_t child) {
+                const AABB& child_aabb = m_nodes[child].aabb;
+                const float merged_area = AABB::merge(child_aabb, leaf_aabb).surface_area();
+                if (m_nodes[child].is_leaf())
+                    return merged_area + inheritance_cost;
+                return merged_area - child_aabb.surface_area() + inheritance_cost;
+            };
+
+            const float left_cost = descend_cost(node.left);
+            const float right_cost = descend_cost(node.right);
+            if (cost < left_cost and cost < right_cost)
+                break;
+
+            index = left_cost < right_cost ? node.left : node.right;
+        }
+
+        const int32_t sibling = index;
+        const int32_t old_parent = m_nodes[sibling].parent;
+        const int32_t new_parent = allocate_node();
+        m_nodes[new_parent].parent = old_parent;
+        m_nodes[new_parent].aabb = AABB::merge(leaf_aabb, m_nodes[sibling].aabb);
+        m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+        m_nodes[new_parent].left = sibling;
+        m_nodes[new_parent].right = leaf;
+        m_nodes[sibling].parent = new_parent;
+        m_nodes[leaf].parent = new_parent;
+
+        if (old_parent == NULL_NODE)
+            m_root = new_parent;
+        else if (m_nodes[old_parent].left == sibling)
+            m_nodes[old_parent].left = new_parent;
+        else
+            m_nodes[old_parent].right = new_parent;
+
+        fix_upwards(m_nodes[leaf].parent);
+    }
+
+    void Bvh::remove_leaf(int32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = NULL_NODE;
+            return;
+        }
+
+        const int32_t parent = m_nodes[leaf].parent;
+        const int32_t grand_parent = m_nodes[parent].parent;
+        const int32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+        if (grand_parent == NULL_NODE)
+        {
+            m_root = sibling;
+            m_nodes[sibling].parent = NULL_NODE;
+            free_node(parent);
+            return;
+        }
+
+        if (m_nodes[grand_parent].left == parent)
+            m_nodes[grand_parent].left = sibling;
+        else
+            m_nodes[grand_parent].right = sibling;
+        m_nodes[sibling].parent = grand_parent;
+        free_node(parent);
+
+        fix_upwards(grand_parent);
+    }
+
+    void Bvh::fix_upwards(int32_t node)
+    {
+        while (node != NULL_NODE)
+        {
+            node = balance(node);
+            Node& current = m_nodes[node];
+            current.height = 1 + std::max(m_nodes[current.left].height, m_nodes[current.right].height);
+            current.aabb = AABB::merge(m_nodes[current.left].aabb, m_nodes[current.right].aabb);
+            node = current.parent;
+        }
+    }
+
+    int32_t Bvh::balance(int32_t index_a)
+    {
+        Node& a = m_nodes[index_a];
+        if (a.is_leaf() or a.height < 2)
+            return index_a;
+
+        const int32_t index_b = a.left;
+        const int32_t index_c = a.right;
+        Node& b = m_nodes[index_b];
+        Node& c = m_nodes[index_c];
+        const int32_t balance_factor = c.height - b.height;
+
+        auto replace_in_parent = [&](int32_t parent, int32_t old_child, int32_t new_child) {
+            if (parent == NULL_NODE)
+                m_root = new_child;
+            else if (m_nodes[parent].left == old_child)
+                m_nodes[parent].left = new_child;
+            else
+                m_nodes[parent].right = new_child;
+        };
+
+        // rotate c up
+        if (balance_factor > 1)
+        {
+            const int32_t index_f = c.left;
+            const int32_t index_g = c.right;
+            Node& f = m_nodes[index_f];
+            Node& g = m_nodes[index_g];
+
+            c.left = index_a;
+            c.parent = a.parent;
+            a.parent = index_c;
+            replace_in_parent(c.parent, index_a, index_c);
+
+            if (f.height > g.height)
+            {
+                c.right = index_f;
+                a.right = index_g;
+                g.parent = index_a;
+                a.aabb = AABB::merge(b.aabb, g.aabb);
+                c.aabb = AABB::merge(a.aabb, f.aabb);
+                a.height = 1 + std::max(b.height, g.height);
+                c.height = 1 + std::max(a.height, f.height);
+            }
+            else
+            {
+                c.right = index_g;
+                a.right = index_f;
+                f.parent = index_a;
+                a.aabb = AABB::merge(b.aabb, f.aabb);
+                c.aabb = AABB::merge(a.aabb, g.aabb);
+                a.height = 1 + std::max(b.height, f.height);
+                c.height = 1 + std::max(a.height, g.height);
+            }
+            return index_c;
+        }
+
+        // rotate b up
+        if (balance_factor < -1)
+        {
+            const int32_t index_d = b.left;
+            const int32_t index_e = b.right;
+            Node& d = m_nodes[index_d];
+            Node& e = m_nodes[index_e];
+
+            b.left = index_a;
+            b.parent = a.parent;
+            a.parent = index_b;
+            replace_in_parent(b.parent, index_a, index_b);
+
+            if (d.height > e.height)
+            {
+                b.right = index_d;
+                a.left = index_e;
+                e.parent = index_a;
+                a.aabb = AABB::merge(c.aabb, e.aabb);
+                b.aabb = AABB::merge(a.aabb, d.aabb);
+                a.height = 1 + std::max(c.height, e.height);
+                b.height = 1 + std::max(a.height, d.height);
+            }
+            else
+            {
+                b.right = index_e;
+                a.left = index_d;
+                d.parent = index_a;
+                a.aabb = AABB::merge(c.aabb, d.aabb);
+                b.aabb = AABB::merge(a.aabb, e.aabb);
+                a.height = 1 + std::max(c.height, d.height);
+                b.height = 1 + std::max(a.height, e.height);
+            }
+            return index_b;
+        }
+
+        return index_a;
+    }
+
+    void Bvh::build(const std::vector<Item>& items, std::vector<ProxyId>& proxies, JobSystem* jobs)
+    {
+        clear();
+        proxies.assign(items.size(), NULL_NODE);
+        if (items.empty())
+            return;
+
+        std::vector<BuildReference> references(items.size());
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            references[i] = BuildReference{
+                .aabb = items[i].aabb,
+                .centroid = items[i].aabb.center(),
+                .item_index = static_cast<uint32_t>(i),
+                .user_data = items[i].user_data
+            };
+        }
+
+        // a binary tree with n leaves always has 2n - 1 nodes, so every subtree knows its node range up front
+        m_nodes.assign(2 * items.size() - 1, Node{});
+        build_recursive(0, references.data(), references.data() + references.size(), proxies, jobs);
+
+        m_root = 0;
+        m_nodes[m_root].parent = NULL_NODE;
+        m_leaf_count = items.size();
+    }
+
+    void Bvh::build_recursive(int32_t node_index, BuildReference* begin, BuildReference* end, std::vector<ProxyId>& proxies, JobSystem* jobs)
+    {
+        const size_t count = end - begin;
+        if (count == 1)
+        {
+            Node& leaf = m_nodes[node_index];
+            leaf.aabb = fatten(begin->aabb);
+            leaf.user_data = begin->user_data;
+            leaf.left = NULL_NODE;
+            leaf.right = NULL_NODE;
+            leaf.height = 0;
+            proxies[begin->item_index] = node_index;
+            return;
+        }
+
+        AABB centroid_bounds;
+        for (auto* reference = begin; reference != end; reference++)
+            centroid_bounds.expand(reference->centroid);
+
+        const glm::vec3 centroid_size = centroid_bounds.max - centroid_bounds.min;
+        int axis = 0;
+        if (centroid_size.y > centroid_size[axis])
+            axis = 1;
+        if (centroid_size.z > centroid_size[axis])
+            axis = 2;
+
+        BuildReference* middle = nullptr;
+        if (centroid_size[axis] > 1e-6f)
+        {
+            struct Bin
+            {
+                AABB aabb;
+                size_t count = 0;
+            };
+
+            std::array<Bin, SAH_BIN_COUNT> bins;
+            const float bin_scale = SAH_BIN_COUNT / centroid_size[axis];
+            auto bin_of = [&](const BuildReference& reference) {
+                int bin = static_cast<int>((reference.centroid[axis] - centroid_bounds.min[axis]) * bin_scale);
+                return std::clamp(bin, 0, SAH_BIN_COUNT - 1);
+            };
+
+            for (auto* reference = begin; reference != end; reference++)
+            {
+                Bin& bin = bins[bin_of(*reference)];
+                bin.aabb = AABB::merge(bin.aabb, reference->aabb);
+                bin.count++;
+            }
+
+            std::array<float, SAH_BIN_COUNT - 1> right_area;
+            std::array<size_t, SAH_BIN_COUNT - 1> right_count;
+            AABB accumulated;
+            size_t accumulated_count = 0;
+            for (int i = SAH_BIN_COUNT - 1; i > 0; i--)
+            {
+                accumulated = AABB::merge(accumulated, bins[i].aabb);
+                accumulated_count += bins[i].count;
+                right_area[i - 1] = accumulated.surface_area();
+                right_count[i - 1] = accumulated_count;
+            }
+
+            accumulated = AABB{};
+            accumulated_count = 0;
+            int best_split = -1;
+            float best_cost = std::numeric_limits<float>::max();
+            for (int i = 0; i < SAH_BIN_COUNT - 1; i++)
+            {
+                accumulated = AABB::merge(accumulated, bins[i].aabb);
+                accumulated_count += bins[i].count;
+                if (accumulated_count == 0 or right_count[i] == 0)
+                    continue;
+
+                const float cost = accumulated_count * accumulated.surface_area() + right_count[i] * right_area[i];
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_split = i;
+                }
+            }
+
+            if (best_split >= 0)
+                middle = std::partition(begin, end, [&](const BuildReference& reference) { return bin_of(reference) <= best_split; });
+        }
+
+        if (middle == nullptr or middle == begin or middle == end)
+        {
+            middle = begin + count / 2;
+            std::nth_element(begin, middle, end, [axis](const BuildReference& a, const BuildReference& b) {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+        }
+
+        const size_t left_count = middle - begin;
+        const int32_t left_index = node_index + 1;
+        const int32_t right_index = node_index + static_cast<int32_t>(2 * left_count);
+
+        // subtrees own disjoint node ranges and proxies, idle workers steal the left one
+        if (jobs and count >= PARALLEL_BUILD_THRESHOLD)
+        {
+            JobSystem::Counter left_done;
+            const auto build_left = [&]() {
+                build_recursive(left_index, begin, middle, proxies, jobs);
+            };
+            jobs->spawn(build_left, left_done);
+            build_recursive(right_index, middle, end, proxies, jobs);
+            jobs->wait(left_done);
+        }
+        else
+        {
+            build_recursive(left_index, begin, middle, proxies, jobs);
+            build_recursive(right_index, middle, end, proxies, jobs);
+        }
+
+        Node& node = m_nodes[node_index];
+        node.left = left_index;
+        node.right = right_index;
+        node.aabb = AABB::merge(m_nodes[left_index].aabb, m_nodes[right_index].aabb);
+        node.height = 1 + std::max(m_nodes[left_index].height, m_nodes[right_index].height);
+        m_nodes[left_index].parent = node_index;
+        m_nodes[right_index].parent = node_index;
+    }
+
+    void Bvh::clear()
+    {
+        m_nodes.clear();
+        m_root = NULL_NODE;
+        m_free_list = NULL_NODE;
+        m_leaf_count = 0;
+    }
+
+    uint32_t Bvh::user_data(ProxyId proxy) const
+    {
+        return m_nodes[proxy].user_data;
+    }
+
+    void Bvh::set_user_data(ProxyId proxy, uint32_t user_data)
+    {
+        m_nodes[proxy].user_data = user_data;
+    }
+
+    const AABB& Bvh::fat_aabb(ProxyId proxy) const
+    {
+        return m_nodes[proxy].aabb;
+    }
+
+    size_t Bvh::size() const
+    {
+        return m_leaf_count;
+    }
+
+    int32_t Bvh::height() const
+    {
+        return m_root == NULL_NODE ? 0 : m_nodes[m_root].height;
+    }
+
+    void Bvh::query_frustum(const Frustum& frustum, std::vector<uint32_t>& inside, std::vector<uint32_t>& intersecting) const
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        struct Entry
+        {
+            int32_t node;
+            bool fully_inside;
+        };
+
+        std::vector<Entry> stack;
+        stack.reserve(64);
+        stack.push_back({m_root, false});
+        while (not stack.empty())
+        {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            const Node& node = m_nodes[entry.node];
+
+            bool fully_inside = entry.fully_inside;
+            if (not fully_inside)
+            {
+                const auto containment = frustum.classify(node.aabb);
+                if (containment == Frustum::Containment::Outside)
+                    continue;
+                fully_inside = containment == Frustum::Containment::Inside;
+            }
+
+            if (node.is_leaf())
+            {
+                (fully_inside ? inside : intersecting).push_back(node.user_data);
+                continue;
+            }
+
+            stack.push_back({node.left, fully_inside});
+            stack.push_back({node.right, fully_inside});
+        }
+    }
+
+    void Bvh::query_aabb(const AABB& aabb, std::vector<uint32_t>& result) const
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+        while (not stack.empty())
+        {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+            if (not node.aabb.intersects(aabb))
+                continue;
+
+            if (node.is_leaf())
+            {
+                result.push_back(node.user_data);
+                continue;
+            }
+
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    void Bvh::query_sphere(const BoundingSphere& sphere, std::vector<uint32_t>& result) const
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        const float radius_squared = sphere.radius * sphere.radius;
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+        while (not stack.empty())
+        {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+            if (node.aabb.distance_squared(sphere.center) > radius_squared)
+                continue;
+
+            if (node.is_leaf())
+            {
+                result.push_back(node.user_data);
+                continue;
+            }
+
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    void Bvh::query_ray(const Ray& ray, std::vector<RayHit>& result) const
+    {
+        if (m_root == NULL_NODE)
+            return;
+
+        const size_t first_hit = result.size();
+        const glm::vec3 inverse_direction = 1.0f / ray.direction;
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+        while (not stack.empty())
+        {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            float distance;
+            if (not ray_intersects(node.aabb, ray.origin, inverse_direction, ray.max_distance, distance))
+                continue;
+
+            if (node.is_leaf())
+            {
+                result.push_back({node.user_data, distance});
+                continue;
+            }
+
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+
+        std::sort(result.begin() + first_hit, result.end(), [](const RayHit& a, const RayHit& b) { return a.distance < b.distance; });
+    }
+
+    std::optional<Bvh::RayHit> Bvh::raycast(const Ray& ray) const
+    {
+        if (m_root == NULL_NODE)
+            return std::nullopt;
+
+        const glm::vec3 inverse_direction = 1.0f / ray.direction;
+        std::optional<RayHit> closest;
+        float closest_distance = ray.max_distance;
+
+        // front to back traversal, subtrees farther than the closest hit are skipped
+        std::vector<std::pair<int32_t, float>> stack;
+        stack.reserve(64);
+        float root_distance;
+        if (not ray_intersects(m_nodes[m_root].aabb, ray.origin, inverse_direction, closest_distance, root_distance))
+            return std::nullopt;
+        stack.push_back({m_root, root_distance});
+
+        while (not stack.empty())
+        {
+            const auto [index, entry_distance] = stack.back();
+            stack.pop_back();
+            if (entry_distance > closest_distance)
+                continue;
+
+            const Node& node = m_nodes[index];
+            if (node.is_leaf())
+            {
+                closest_distance = entry_distance;
+                closest = RayHit{node.user_data, entry_distance};
+                continue;
+            }
+
+            float left_distance, right_distance;
+            const bool hit_left = ray_intersects(m_nodes[node.left].aabb, ray.origin, inverse_direction, closest_distance, left_distance);
+            const bool hit_right = ray_intersects(m_nodes[node.right].aabb, ray.origin, inverse_direction, closest_distance, right_distance);
+
+            // push the farther child first, so the nearer one is popped first
+            if (hit_left and hit_right)
+            {
+                if (left_distance < right_distance)
+                {
+                    stack.push_back({node.right, right_distance});
+                    stack.push_back({node.left, left_distance});
+                }
+                else
+                {
+                    stack.push_back({node.left, left_distance});
+                    stack.push_back({node.right, right_distance});
+                }
+            }
+            else if (hit_left)
+                stack.push_back({node.left, left_distance});
+            else if (hit_right)
+                stack.push_back({node.right, right_distance});
+        }
+
+        return closest;
+    }
+
+    void Bvh::query_k_nearest(const glm::vec3& point, size_t k, std::vector<uint32_t>& result) const
+    {
+        if (m_root == NULL_NODE or k == 0)
+            return;
+
+        using Candidate = std::pair<float, int32_t>;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> open;
+        // max heap of the best k leaves found so far
+        std::priority_queue<Candidate> best;
+
+        open.push({m_nodes[m_root].aabb.distance_squared(point), m_root});
+        while (not open.empty())
+        {
+            const auto [distance, index] = open.top();
+            open.pop();
+            if (best.size() == k and distance > best.top().first)
+                break;
+
+            const Node& node = m_nodes[index];
+            if (node.is_leaf())
+            {
+                best.push({distance, index});
+                if (best.size() > k)
+                    best.pop();
+                continue;
+            }
+
+            open.push({m_nodes[node.left].aabb.distance_squared(point), node.left});
+            open.push({m_nodes[node.right].aabb.distance_squared(point), node.right});
+        }
+
+        const size_t first = result.size();
+        result.resize(first + best.size());
+        for (size_t i = result.size(); i > first; i--)
+        {
+            result[i - 1] = m_nodes[best.top().second].user_data;
+            best.pop();
+        }
+    }
+}
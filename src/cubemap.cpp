@@ -6,6 +6,28 @@ namespace yazpgp
     CubeMap::CubeMap(const std::array<CubeMapDataPart, 6>& data)
     {
         glGenTextures(1, &m_texture);
+        upload(data);
+    }
+
+    CubeMap::CubeMap(GLenum internal_format, GLenum format, uint32_t level_count, std::span<const TextureLevel> levels)
+    {
+        glGenTextures(1, &m_texture);
+        upload_levels(internal_format, format, level_count, levels);
+    }
+
+    void CubeMap::reset_immutable()
+    {
+        if (not m_immutable)
+            return;
+
+        glDeleteTextures(1, &m_texture);
+        glGenTextures(1, &m_texture);
+        m_immutable = false;
+    }
+
+    void CubeMap::upload(const std::array<CubeMapDataPart, 6>& data)
+    {
+        reset_immutable();
         glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
 
         for (size_t i = 0; i < 6; i++)
@@ -38,6 +60,30 @@ namespace yazpgp
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);  
     }
 
+    void CubeMap::upload_levels(GLenum internal_format, GLenum format, uint32_t level_count, std::span<const TextureLevel> levels)
+    {
+        reset_immutable();
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+        glTexStorage2D(GL_TEXTURE_CUBE_MAP, level_count, internal_format, levels[0].width, levels[0].height);
+        for (size_t face = 0; face < 6; face++)
+        {
+            for (size_t level = 0; level < level_count; level++)
+            {
+                const TextureLevel& data = levels[face * level_count + level];
+                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, data.width, data.height, format, GL_UNSIGNED_BYTE, data.bytes);
+            }
+        }
+        m_immutable = true;
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        YAZPGP_LOG_DEBUG("Cubemap loaded: %d (%dx%d, %u levels)", m_texture, levels[0].width, levels[0].height, level_count);
+    }
+
     CubeMap::~CubeMap()
     {
         glDeleteTextures(1, &m_texture);
@@ -16,13 +16,51 @@ namespace yazpgp
             // ImGui::SetWindowSize(ImVec2(300, 300), ImGuiCond_Once);
             ImGui::SetWindowCollapsed(true, ImGuiCond_Once); 
 
+            render_stats_component(scene);
             camera_component(scene.m_camera);   
             lights_component(*scene.m_point_lights);
-            entities_component(scene.m_entities);
+            entities_component(scene);
         }   
         ImGui::End();
     }
 
+    void DebugUI::render_stats_component(Scene& scene)
+    {
+        ImGui::Text("Rendering");
+        ImGui::Separator();
+        ImGui::Checkbox("Frustum Culling", &scene.m_frustum_culling);
+        ImGui::Checkbox("Multi Draw Indirect", &scene.m_multi_draw_indirect);
+        ImGui::Checkbox("Meshlet Culling", &scene.m_meshlet_culling);
+        if (scene.m_deferred_lighting_shader)
+            ImGui::Checkbox("Deferred Shading", &scene.m_deferred_shading);
+        ImGui::SliderFloat("LOD pixel error", &scene.m_lod_pixel_error, 0.0f, 8.0f);
+        ImGui::Text("Drawn: %zu", scene.m_render_stats.drawn);
+        ImGui::Text("Triangles: %zu, reduced LODs: %zu", scene.m_render_stats.triangles, scene.m_render_stats.reduced_lods);
+        ImGui::Text("Meshlets: %zu drawn, %zu culled", scene.m_render_stats.meshlets_drawn, scene.m_render_stats.meshlets_culled);
+        ImGui::Text("Culled: %zu", scene.m_render_stats.culled);
+        ImGui::Text("Sphere tests: %zu", scene.m_render_stats.sphere_tests);
+        ImGui::Text("Draw calls: %zu, indirect commands: %zu", scene.m_render_stats.draw_calls, scene.m_render_stats.indirect_commands);
+        ImGui::Text("G-buffer draw calls: %zu", scene.m_render_stats.gbuffer_draw_calls);
+        ImGui::Text("Entity uploads: %zu", scene.m_render_stats.entity_uploads);
+        ImGui::Text("Transform updates: %zu, animated entities: %zu", scene.m_update_stats.transform_updates, scene.m_update_stats.animated_entities);
+        ImGui::Text("Light buffer uploads: %zu, light indices: %zu in clusters, %zu in entity lists",
+            scene.m_light_buffer->upload_count(),
+            scene.m_light_buffer->light_index_count(),
+            scene.m_light_buffer->entity_light_index_count()
+        );
+        ImGui::Text("Binds: %zu programs, %zu VAOs, %zu textures",
+            scene.m_render_stats.program_binds,
+            scene.m_render_stats.vao_binds,
+            scene.m_render_stats.texture_binds
+        );
+        ImGui::Text("Materials: %zu entries, %zu uploads",
+            scene.m_material_registry->entry_count(),
+            scene.m_material_registry->upload_count()
+        );
+        ImGui::Text("BVH: %zu leaves, height %d", scene.m_bvh.size(), scene.m_bvh.height());
+        ImGui::Separator();
+    }
+
     void DebugUI::camera_component(Camera& camera)
     {
         ImGui::Text("Camera");
@@ -61,29 +99,37 @@ namespace yazpgp
         }
     }
 
-    void DebugUI::entities_component(std::vector<std::unique_ptr<RenderableEntity>>& entities)
+    void DebugUI::entities_component(Scene& scene)
     {
         ImGui::Text("Entities");
         ImGui::Separator();
         if (ImGui::TreeNode("Renderable Entities"))
         {
-            for (size_t i = 0; i < entities.size(); i++)
+            for (size_t i = 0; i < scene.entity_count(); i++)
             {
-                auto& entity = entities[i];
-                ImGui::PushID(&entity);
+                ImGui::PushID(static_cast<int>(i));
 
                 if (ImGui::TreeNode((void*)(intptr_t)i, "Entity %zu", i))
                 {
-                    ImGui::DragFloat3("Position", (float*)&entity->transform().position_data);
-                    ImGui::DragFloat3("Rotation", (float*)&entity->transform().rotation_data);
-                    ImGui::DragFloat3("Scale", (float*)&entity->transform().scale_data);
-
-                    if (entity->m_material)
+                    auto transform = scene.transform(i);
+                    bool moved = false;
+                    moved |= ImGui::DragFloat3("Position", (float*)&transform.position_data);
+                    moved |= ImGui::DragFloat3("Rotation", (float*)&transform.rotation_data);
+                    moved |= ImGui::DragFloat3("Scale", (float*)&transform.scale_data);
+                    if (moved)
+                        scene.set_transform(i, transform);
+
+                    const auto& material = scene.m_entities.material(i);
+                    if (material)
                     {
                         if (ImGui::TreeNode("Material"))
                         {
-                            if (entity->m_material->kind() == Material::Kind::PhongBlinn)
-                                phong_blinn_material_component(*std::static_pointer_cast<PhongBlinnMaterial>(entity->m_material));
+                            bool changed = false;
+                            if (material->kind() == Material::Kind::PhongBlinn)
+                                changed = phong_blinn_material_component(*std::static_pointer_cast<PhongBlinnMaterial>(material));
+
+                            if (changed)
+                                scene.m_material_registry->mark_dirty();
 
                             ImGui::TreePop();
                         }
@@ -97,15 +143,17 @@ namespace yazpgp
         }
     }
 
-    void DebugUI::phong_blinn_material_component(PhongBlinnMaterial& material)
+    bool DebugUI::phong_blinn_material_component(PhongBlinnMaterial& material)
     {
         ImGui::Text("Phong Blinn Material");
         ImGui::Separator();
-        ImGui::ColorEdit3("Ambient Color", (float*)&material.m_ambient_color);
-        ImGui::ColorEdit3("Diffuse Color", (float*)&material.m_diffuse_color);
-        ImGui::ColorEdit3("Specular Color", (float*)&material.m_specular_color);
+        bool changed = false;
+        changed |= ImGui::ColorEdit3("Ambient Color", (float*)&material.m_ambient_color);
+        changed |= ImGui::ColorEdit3("Diffuse Color", (float*)&material.m_diffuse_color);
+        changed |= ImGui::ColorEdit3("Specular Color", (float*)&material.m_specular_color);
 
-        ImGui::SliderFloat("Specular Shininess", &material.m_specular_shininess, 1.0f, 512.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        changed |= ImGui::SliderFloat("Specular Shininess", &material.m_specular_shininess, 1.0f, 512.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        return changed;
     }
 
 }
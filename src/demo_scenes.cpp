@@ -17,25 +17,25 @@ namespace yazpgp::DemoScenes
                 .mesh = ball_mesh,
                 .transform = Transform::default_transform().translate({0.0f, 0.0f, 3.0f}),
                 .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
                 .shader = phong_shader,
                 .mesh = ball_mesh,
                 .transform = Transform::default_transform().translate({0.0f, 0.0f, -3.0f}),
                 .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
                 .shader = phong_shader,
                 .mesh = ball_mesh,
                 .transform = Transform::default_transform().translate({0.0f, -3.0f, 0.0f}),
                 .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
                 .shader = phong_shader,
                 .mesh = ball_mesh,
                 .transform = Transform::default_transform().translate({0.0f, 3.0f, 0.0f}),
                 .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_light(
             DirectionalLight().set_direction({0.f, -1.f, 0.f})
         );
@@ -43,7 +43,7 @@ namespace yazpgp::DemoScenes
         return s;
     }
 
-    Scene solar_system(const AssetStorage<Mesh>& meshes, const AssetStorage<Shader>& shaders, const Window& window)
+    Scene solar_system(const AssetStorage<Mesh>& meshes, const AssetStorage<Shader>& shaders)
     {
         Scene s;
         const auto constant_shader = shaders["constant"];
@@ -52,84 +52,62 @@ namespace yazpgp::DemoScenes
         const auto grid_mesh = meshes["grid"];
         const auto white_shader = shaders["white"];
 
-        static Transform::Mat4Compositor center_planet;
-        static Transform::Mat4Compositor first_planet;
-        static Transform::Mat4Compositor second_planet;
+        // rotation around the parent, the entity transform is applied before it
+        const auto orbit = [](float degrees_per_second, float distance)
+        {
+            return Animation()
+                .translate({0.0f, 0.0f, distance})
+                .rotate({0.0f, degrees_per_second, 0.0f});
+        };
 
         s.add_entity(Scene::SceneRenderableEntity{
             .shader = white_shader,
             .mesh = grid_mesh,
             .transform = Transform::default_transform().translate({0.f, -10.f, 0.f}).scale({5.f, 5.f, 5.f})
-        })
-        .add_entity(Scene::SceneRenderableEntity{
+        });
+
+        const size_t center_planet = s.entity_count();
+        s.add_entity(Scene::SceneRenderableEntity{
             .shader = constant_shader,
             .mesh = ball_mesh,
-            .material = PhongBlinnMaterial::create_shared({1.f, 1.f, 0.0f}),
-            .transform_modifier = [&](const glm::mat4& m) {
-                center_planet = m;
-                return m;
-            }
-        })
-        .add_entity(Scene::SceneRenderableEntity{
+            .material = PhongBlinnMaterial::create_shared({1.f, 1.f, 0.0f})
+        });
+
+        const size_t first_planet = s.entity_count();
+        s.add_entity(Scene::SceneRenderableEntity{
             .shader = blinn_shader,
             .mesh = ball_mesh,
             .material = PhongBlinnMaterial::create_shared({0.8f, 0.0f, 0.f}),
-            .transform_modifier = [&](const glm::mat4& m) {
-                float angle = window.time() * 100;
-                first_planet = Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Rotate({0, angle, 0}),
-                    Transform::Mat4Compositor::Translate({0, 0, 5}),
-                    center_planet,
-                })(m);
-                return first_planet.compose();
-            }
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+            .animation = orbit(100.0f, 5.0f),
+            .parent = center_planet
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = blinn_shader,
             .mesh = ball_mesh,
             .transform = Transform::default_transform().scale({0.7f, 0.7f, 0.7f}),
             .material = PhongBlinnMaterial::create_shared({0.0f, 0.0f, 0.4f}),
-            .transform_modifier = [&](const glm::mat4& m) {
-                float angle = window.time() * 150;
-                return Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Composite({
-                        Transform::Mat4Compositor::Rotate({0, angle, 0}),
-                        Transform::Mat4Compositor::Translate({0, 0, 8}),
-                    }),
-                    first_planet,
-                })(m);
-        }}, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
-        .add_entity(Scene::SceneRenderableEntity{
+            .animation = orbit(150.0f, 8.0f),
+            .parent = first_planet
+        });
+
+        // moons inherit the scale of their planet, 12.5 and 0.875 under 0.8 end up at 10 and 0.7
+        const size_t second_planet = s.entity_count();
+        s.add_entity(Scene::SceneRenderableEntity{
             .shader = blinn_shader,
             .mesh = ball_mesh,
             .transform = Transform::default_transform().scale({0.8f, 0.8f, 0.8f}),
             .material = PhongBlinnMaterial::create_shared({0.0f, 0.6f, 0.0f}),
-            .transform_modifier = [&](const glm::mat4& m) {
-                float angle = window.time() * 10;
-                second_planet = Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Composite({
-                        Transform::Mat4Compositor::Rotate({0, -angle, 0}),
-                        Transform::Mat4Compositor::Translate({0, 0, 20}),
-                    }),
-                    center_planet,
-                })(m);
-                return second_planet.compose();
-        }}, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+            .animation = orbit(-10.0f, 20.0f),
+            .parent = center_planet
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = blinn_shader,
             .mesh = ball_mesh,
-            .transform = Transform::default_transform().scale({0.7f, 0.7f, 0.7f}),
+            .transform = Transform::default_transform().scale({0.875f, 0.875f, 0.875f}),
             .material = PhongBlinnMaterial::create_shared({0.6f, 0.0f, 0.0f}),
-            .transform_modifier = [&](const glm::mat4& m) {
-                float angle = window.time() * 50;
-                return Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Composite({
-                        Transform::Mat4Compositor::Rotate({0, angle, 0}),
-                        Transform::Mat4Compositor::Translate({0, 0, 10}),
-                    }),
-                    second_planet,
-                })(m);
-        }}, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+            .animation = orbit(50.0f, 12.5f),
+            .parent = second_planet
+        })
         .add_light(
             PointLight()
         );
@@ -152,13 +130,13 @@ namespace yazpgp::DemoScenes
             .mesh = ball_mesh,
             .transform = Transform::default_transform().translate({-5.0f, 0.0f, 0.0f}),
             .material = PhongBlinnMaterial::create_shared(glm::vec3(1.f), 1.f)
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = phong_wihout_clip_shader,
             .mesh = ball_mesh,
             .transform = Transform::default_transform().translate({5.0f, 0.0f, 0.0f}),
             .material = PhongBlinnMaterial::create_shared(glm::vec3(1.f), 1.f)
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = white_shader,
             .mesh = grid_mesh,
@@ -187,21 +165,21 @@ namespace yazpgp::DemoScenes
             .mesh = ball_mesh,
             .transform = Transform::default_transform().translate({0.0f, 0.0f, 0.0f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = phong_textured_shader,
             .mesh = tonk_mesh,
             .textures = {tonk_texture},
             .transform = Transform::default_transform().translate({0.f, 3.f, -8.f}).rotate({-90.f, 0.f, 0.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = phong_textured_shader,
             .mesh = mad_mesh,
             .textures = {mad_mesh_texture},
             .transform = Transform::default_transform().translate({0.f, 0.f, 8.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_light(
             PointLight().set_position({0.f, 5.f, 5.f})
         );
@@ -235,7 +213,7 @@ namespace yazpgp::DemoScenes
             .textures = {textures["grass"]},
             .transform = Transform::default_transform().translate({0.f, 0.f, 0.f}).scale({20.f, 1.f, 20.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_light(
             // PointLight().set_position({0.f, 50.f, 50.f}).set_illumination_radius(1000.f)
             // DirectionalLight().set_direction({0.f, -1.f, 0.f})
@@ -261,7 +239,7 @@ namespace yazpgp::DemoScenes
                     .scale({scale, scale, scale})
                     .rotate({0.f, rot_dis(gen), 0.f}),
                 .material = PhongBlinnMaterial::default_material(),
-            }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+            });
         
 
             s.add_entity(Scene::SceneRenderableEntity{
@@ -273,7 +251,7 @@ namespace yazpgp::DemoScenes
                     .scale({scale+1.0f, scale+1.0f, scale+1.0f})
                     .rotate({0.f, rot_dis(gen), 0.f}),
                 .material = PhongBlinnMaterial::default_material(),
-            }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+            });
         
         }
 
@@ -282,7 +260,7 @@ namespace yazpgp::DemoScenes
             .mesh = ball_mesh,
             .transform = Transform::default_transform().translate({0.f, 10.f, 0.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = phong_textured_shader,
             .mesh = tonk_mesh,
@@ -292,32 +270,17 @@ namespace yazpgp::DemoScenes
                 .rotate({-90.f, 0.f, 0.f})
                 .scale({0.3f, 0.3f, 0.3f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = phong_textured_shader,
             .mesh = rat_mesh,
             .textures = {rat_texture},
             .transform = Transform::default_transform().translate({0.f, 0.f, 3.f}),
             .material = PhongBlinnMaterial::default_material(),
-            .transform_modifier = [&](const glm::mat4& m) {
-                // static float angle = 0.f;
-                // angle += 0.5f;
-                // return Transform::Mat4Compositor::Composite({
-                //     Transform::Mat4Compositor::Rotate({0, angle, 0}),
-                //     m
-                // })();
-                static float t = 0.f;
-                t += 0.1f;
-
-                float height = std::sin(t) + 1.f;
-
-                return Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Translate({0, height, 0}),
-                    m
-                })();
-
-            }
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+            .animation = Animation()
+                .translate({0.0f, 1.0f, 0.0f})
+                .oscillate({0.0f, 1.0f, 0.0f}, 1.0f)
+        });
 
 
         constexpr int num_balls = 100;
@@ -336,7 +299,7 @@ namespace yazpgp::DemoScenes
                     .textures = {tree_texture},
                     .transform = Transform::default_transform().translate({pos_x, 2.f, pos_z}).scale({0.3f, 0.3f, 0.3f}),
                     .material = PhongBlinnMaterial::default_material(),
-                }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+                });
             }
             else
             {
@@ -379,14 +342,14 @@ namespace yazpgp::DemoScenes
             .textures = {brick_texture, brick_normal_texture},
             .transform = Transform::default_transform().translate({0.f, 2.f, 0.f}).rotate({90.f, 0.f, 0.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = normal_shader,
             .mesh = plane_mesh,
             .textures = {brick_texture, brick_normal_texture},
             .transform = Transform::default_transform().translate({0.f, 0.f, 0.f}).rotate({90.f, 0.f, 0.f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+        })
         .add_light(
             // DirectionalLight().set_direction({0.f, -1.f, 0.f})
             PointLight().set_position({3.f, 3.f, 2.f}).invoke()
@@ -398,7 +361,7 @@ namespace yazpgp::DemoScenes
                 .textures = {backpack_texture, backpack_normal_texture},
                 .transform = Transform::default_transform(),
                 .material = PhongBlinnMaterial::default_material(),
-            }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader
+            }
         );
         
 
@@ -429,7 +392,7 @@ namespace yazpgp::DemoScenes
             .transform = Transform::default_transform()
                 .scale({plane_scale, 1.f, plane_scale}),
             .material = grass_material,
-        // }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+        // });
         });
 
         for (size_t i = 0; i < shells; i++)
@@ -441,7 +404,7 @@ namespace yazpgp::DemoScenes
                     .translate({0.f, i * high_diff, 0.f})
                     .scale({plane_scale, 1.f, plane_scale}),
                 .material = grass_material,
-            // }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+            // });
             });
         }
 
@@ -451,7 +414,7 @@ namespace yazpgp::DemoScenes
             .textures = {textures["mad"]},
             .transform = Transform::default_transform().scale({0.3f, 0.3f, 0.3f}),
             .material = PhongBlinnMaterial::default_material(),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+        });
 
 
         // s.add_light(
@@ -484,7 +447,7 @@ namespace yazpgp::DemoScenes
                 glm::vec3(1.f),
                 glm::vec3(0.f)
             ),
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader);
+        });
 
         s.add_light(
             DirectionalLight().set_direction({0.f, -1.f, 0.f})
@@ -510,7 +473,7 @@ namespace yazpgp::DemoScenes
         //     {5.f, 0.f, 0.f},
         // }});
 
-        BezierCurve<10> curve({{
+        const std::array<glm::vec3, 10> curve_points = {{
             {0.f, 0.f, 0.f},
             {0.f, 5.f, 0.f},
             {0.f, 5.f, 5.f},
@@ -521,7 +484,8 @@ namespace yazpgp::DemoScenes
             {5.f, 0.f, 0.f},
             {0.f, 0.f, 0.f},
             {0.f, 5.f, 0.f},
-        }});
+        }};
+        BezierCurve<10> curve(curve_points);
 
         Scene s;
         s.add_entity(Scene::SceneRenderableEntity{
@@ -529,19 +493,8 @@ namespace yazpgp::DemoScenes
             .mesh = ball_mesh,
             .transform = Transform::default_transform(),
             .material = PhongBlinnMaterial::default_material(),
-            .transform_modifier = [=](const glm::mat4& m) {
-                static float dt = 0.f;
-                dt += 0.01f;
-
-                float t = std::sin(dt) * 0.5f + 0.5f;
-
-                glm::vec3 position = curve(t);
-
-                return Transform::Mat4Compositor::Composite({
-                    Transform::Mat4Compositor::Translate(position),
-                })(m);
-            },
-        }, Scene::AddEntityOptions::PassLightToShader | Scene::AddEntityOptions::PassCameraPostitionToShader)
+            .animation = Animation().bezier_path({curve_points.begin(), curve_points.end()}, curve_points.size(), 5.0f),
+        })
         .add_entity(Scene::SceneRenderableEntity{
             .shader = white_shader,
             .mesh = grid_mesh,
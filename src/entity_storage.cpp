@@ -0,0 +1,168 @@
+#include "entity_storage.hpp"
+
+#include <algorithm>
+
+namespace yazpgp
+{
+    uint32_t EntityStorage::add(
+        const std::shared_ptr<Shader>& shader,
+        const std::shared_ptr<Mesh>& mesh,
+        const std::vector<std::shared_ptr<Texture>>& textures,
+        const std::shared_ptr<Material>& material
+    )
+    {
+        std::vector<const Texture*> texture_key(textures.size());
+        for (size_t i = 0; i < textures.size(); i++)
+            texture_key[i] = textures[i].get();
+
+        const auto [texture_set, inserted] = m_texture_set_ids.try_emplace(std::move(texture_key), static_cast<uint32_t>(m_texture_sets.size()));
+        if (inserted)
+            m_texture_sets.push_back(textures);
+
+        const uint32_t entity = static_cast<uint32_t>(m_handles.size());
+        m_handles.push_back({
+            .shader = m_shaders.add(shader),
+            .mesh = m_meshes.add(mesh),
+            .texture_set = texture_set->second,
+            .material = m_materials.add(material)
+        });
+        if (m_mesh_generations.size() < m_meshes.resources.size())
+            m_mesh_generations.push_back(mesh->generation());
+
+        // the scene writes the world matrix before the entity is drawn
+        m_model_matrices.push_back(glm::mat4(1.0f));
+        m_normal_matrices.push_back(glm::mat3(1.0f));
+        m_world_aabbs.push_back(mesh->bounds());
+        m_world_bounding_spheres.push_back(mesh->bounding_sphere());
+        return entity;
+    }
+
+    void EntityStorage::remove(uint32_t entity)
+    {
+        if (entity >= m_handles.size())
+            return;
+
+        m_handles.erase(m_handles.begin() + entity);
+        m_model_matrices.erase(m_model_matrices.begin() + entity);
+        m_normal_matrices.erase(m_normal_matrices.begin() + entity);
+        m_world_aabbs.erase(m_world_aabbs.begin() + entity);
+        m_world_bounding_spheres.erase(m_world_bounding_spheres.begin() + entity);
+    }
+
+    size_t EntityStorage::size() const
+    {
+        return m_handles.size();
+    }
+
+    void EntityStorage::set_world_matrix(uint32_t entity, const glm::mat4& model_matrix, const glm::mat3& normal_matrix)
+    {
+        const Mesh& mesh = *m_meshes.resources[m_handles[entity].mesh];
+        m_model_matrices[entity] = model_matrix;
+        m_normal_matrices[entity] = normal_matrix;
+        m_world_aabbs[entity] = mesh.bounds().transformed(model_matrix);
+        m_world_bounding_spheres[entity] = mesh.bounding_sphere().transformed(model_matrix);
+    }
+
+    void EntityStorage::refresh_replaced_meshes(std::vector<std::shared_ptr<Mesh>>& replaced_meshes, std::vector<uint32_t>& refreshed_entities)
+    {
+        // a handful of meshes is checked per update, entities are only visited once one was replaced
+        m_replaced_mesh_ids.assign(m_meshes.resources.size(), 0);
+        bool replaced = false;
+        for (size_t id = 0; id < m_meshes.resources.size(); id++)
+        {
+            const uint32_t generation = m_meshes.resources[id]->generation();
+            if (generation == m_mesh_generations[id])
+                continue;
+
+            m_mesh_generations[id] = generation;
+            m_replaced_mesh_ids[id] = 1;
+            replaced_meshes.push_back(m_meshes.resources[id]);
+            replaced = true;
+        }
+
+        if (not replaced)
+            return;
+
+        for (uint32_t entity = 0; entity < m_handles.size(); entity++)
+        {
+            if (not m_replaced_mesh_ids[m_handles[entity].mesh])
+                continue;
+
+            set_world_matrix(entity, m_model_matrices[entity], m_normal_matrices[entity]);
+            refreshed_entities.push_back(entity);
+        }
+    }
+
+    const RenderHandles& EntityStorage::handles(uint32_t entity) const
+    {
+        return m_handles[entity];
+    }
+
+    const std::vector<RenderHandles>& EntityStorage::handles() const
+    {
+        return m_handles;
+    }
+
+    const glm::mat4& EntityStorage::model_matrix(uint32_t entity) const
+    {
+        return m_model_matrices[entity];
+    }
+
+    const glm::mat3& EntityStorage::normal_matrix(uint32_t entity) const
+    {
+        return m_normal_matrices[entity];
+    }
+
+    const AABB& EntityStorage::world_aabb(uint32_t entity) const
+    {
+        return m_world_aabbs[entity];
+    }
+
+    const std::vector<AABB>& EntityStorage::world_aabbs() const
+    {
+        return m_world_aabbs;
+    }
+
+    const BoundingSphere& EntityStorage::world_bounding_sphere(uint32_t entity) const
+    {
+        return m_world_bounding_spheres[entity];
+    }
+
+    const Shader& EntityStorage::shader(uint32_t entity) const
+    {
+        return *m_shaders.resources[m_handles[entity].shader];
+    }
+
+    const Mesh& EntityStorage::mesh(uint32_t entity) const
+    {
+        return *m_meshes.resources[m_handles[entity].mesh];
+    }
+
+    const std::shared_ptr<Material>& EntityStorage::material(uint32_t entity) const
+    {
+        return m_materials.resources[m_handles[entity].material];
+    }
+
+    void EntityStorage::bind_resources(uint32_t entity, RenderState& state) const
+    {
+        // camera matrices come from the FrameBlock uniform buffer,
+        // transforms and material indices from the EntityBlock
+        const auto& handles = m_handles[entity];
+        state.bind_shader(m_shaders.resources[handles.shader].get());
+
+        // sampler uniforms point to their texture unit since the program was linked
+        const auto& textures = m_texture_sets[handles.texture_set];
+        for (size_t i = 0; i < textures.size(); i++)
+            state.bind_texture(i, textures[i].get());
+    }
+
+    void EntityStorage::render(uint32_t entity, RenderState& state, uint32_t base_instance, uint32_t instance_count, uint32_t lod) const
+    {
+        bind_resources(entity, state);
+        const Mesh& mesh = this->mesh(entity);
+        state.bind_mesh(&mesh);
+        const MeshLod& level = mesh.lods()[std::min<size_t>(lod, mesh.lods().size() - 1)];
+        const auto* offset = reinterpret_cast<const void*>(level.first_index * mesh.index_size());
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, level.index_count, mesh.index_type(), offset, instance_count, base_instance);
+    }
+}
@@ -0,0 +1,155 @@
+#include "frustum.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace yazpgp
+{
+    void SphereBatch::clear()
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+        radius.clear();
+    }
+
+    void SphereBatch::reserve(size_t count)
+    {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+        radius.reserve(count);
+    }
+
+    void SphereBatch::push_back(const BoundingSphere& sphere)
+    {
+        x.push_back(sphere.center.x);
+        y.push_back(sphere.center.y);
+        z.push_back(sphere.center.z);
+        radius.push_back(sphere.radius);
+    }
+
+    size_t SphereBatch::size() const
+    {
+        return x.size();
+    }
+
+    Frustum::Frustum(const glm::mat4& view_projection_matrix)
+    {
+        // Gribb & Hartmann plane extraction, glm matrices are column major
+        auto row = [&](int i) {
+            return glm::vec4(
+                view_projection_matrix[0][i],
+                view_projection_matrix[1][i],
+                view_projection_matrix[2][i],
+                view_projection_matrix[3][i]
+            );
+        };
+
+        m_planes = {
+            row(3) + row(0),
+            row(3) - row(0),
+            row(3) + row(1),
+            row(3) - row(1),
+            row(3) + row(2),
+            row(3) - row(2),
+        };
+
+        for (auto& plane : m_planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    const std::array<glm::vec4, 6>& Frustum::planes() const
+    {
+        return m_planes;
+    }
+
+    bool Frustum::intersects(const BoundingSphere& sphere) const
+    {
+        for (const auto& plane : m_planes)
+        {
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+                return false;
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const AABB& aabb) const
+    {
+        const glm::vec3 center = aabb.center();
+        const glm::vec3 extents = aabb.extents();
+        for (const auto& plane : m_planes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            const float radius = glm::dot(extents, glm::abs(normal));
+            if (glm::dot(normal, center) + plane.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    Frustum::Containment Frustum::classify(const AABB& aabb) const
+    {
+        const glm::vec3 center = aabb.center();
+        const glm::vec3 extents = aabb.extents();
+        Containment result = Containment::Inside;
+        for (const auto& plane : m_planes)
+        {
+            const glm::vec3 normal = glm::vec3(plane);
+            const float radius = glm::dot(extents, glm::abs(normal));
+            const float distance = glm::dot(normal, center) + plane.w;
+            if (distance < -radius)
+                return Containment::Outside;
+            if (distance < radius)
+                result = Containment::Intersects;
+        }
+        return result;
+    }
+
+    size_t Frustum::test_spheres(const SphereBatch& batch, std::vector<uint8_t>& visible) const
+    {
+        const size_t count = batch.size();
+        visible.resize(count);
+        size_t visible_count = 0;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(batch.x.data() + i);
+            const __m128 y = _mm_loadu_ps(batch.y.data() + i);
+            const __m128 z = _mm_loadu_ps(batch.z.data() + i);
+            const __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(batch.radius.data() + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto& plane : m_planes)
+            {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+                );
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+            }
+
+            const int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                visible[i + lane] = (mask >> lane) & 1;
+                visible_count += visible[i + lane];
+            }
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            visible[i] = intersects(BoundingSphere{
+                .center = {batch.x[i], batch.y[i], batch.z[i]},
+                .radius = batch.radius[i]
+            });
+            visible_count += visible[i];
+        }
+
+        return visible_count;
+    }
+}
@@ -0,0 +1,130 @@
+#include "gbuffer.hpp"
+#include "logger.hpp"
+
+namespace yazpgp
+{
+    namespace
+    {
+        constexpr std::array<GLenum, GBuffer::COLOR_ATTACHMENT_COUNT> COLOR_FORMATS = {
+            GL_RGBA8,   // albedo
+            GL_RGBA16F, // world space normal
+            GL_RG16UI,  // material index, lighting model
+        };
+
+        GLuint create_texture(GLenum format, uint32_t width, uint32_t height)
+        {
+            GLuint texture = 0;
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+            glTextureStorage2D(texture, 1, format, width, height);
+            // the lighting pass reads texels 1:1, integer textures cannot be filtered anyway
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            return texture;
+        }
+    }
+
+    GBuffer::~GBuffer()
+    {
+        release();
+        if (m_empty_vertex_array)
+            glDeleteVertexArrays(1, &m_empty_vertex_array);
+    }
+
+    void GBuffer::resize(uint32_t width, uint32_t height)
+    {
+        if (width == m_width and height == m_height and m_framebuffer)
+            return;
+
+        release();
+        m_width = width;
+        m_height = height;
+        if (width == 0 or height == 0)
+            return;
+
+        glCreateFramebuffers(1, &m_framebuffer);
+        if (not m_empty_vertex_array)
+            glCreateVertexArrays(1, &m_empty_vertex_array);
+
+        std::array<GLenum, COLOR_ATTACHMENT_COUNT> draw_buffers;
+        for (GLuint i = 0; i < COLOR_ATTACHMENT_COUNT; i++)
+        {
+            m_color_textures[i] = create_texture(COLOR_FORMATS[i], width, height);
+            glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0 + i, m_color_textures[i], 0);
+            draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        glNamedFramebufferDrawBuffers(m_framebuffer, COLOR_ATTACHMENT_COUNT, draw_buffers.data());
+
+        // same format as the default framebuffer, otherwise the depth and stencil blit fails
+        m_depth_stencil_texture = create_texture(GL_DEPTH24_STENCIL8, width, height);
+        glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, m_depth_stencil_texture, 0);
+
+        const GLenum status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            YAZPGP_LOG_ERROR("G-buffer %ux%u is incomplete, status 0x%x", width, height, status);
+            release();
+            return;
+        }
+
+        YAZPGP_LOG_DEBUG("G-buffer resized to %ux%u", width, height);
+    }
+
+    void GBuffer::begin_geometry_pass() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+        constexpr GLfloat clear_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        constexpr GLuint clear_material[4] = {0, 0, 0, 0};
+        glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, ALBEDO, clear_color);
+        glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, NORMAL, clear_color);
+        glClearNamedFramebufferuiv(m_framebuffer, GL_COLOR, MATERIAL, clear_material);
+        glClearNamedFramebufferfi(m_framebuffer, GL_DEPTH_STENCIL, 0, 1.0f, 0);
+    }
+
+    void GBuffer::blit_depth_stencil(GLuint target_framebuffer) const
+    {
+        glBlitNamedFramebuffer(
+            m_framebuffer,
+            target_framebuffer,
+            0, 0, m_width, m_height,
+            0, 0, m_width, m_height,
+            GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT,
+            GL_NEAREST
+        );
+    }
+
+    void GBuffer::draw_lighting_pass(const Shader& lighting_shader) const
+    {
+        for (GLuint i = 0; i < COLOR_ATTACHMENT_COUNT; i++)
+            glBindTextureUnit(i, m_color_textures[i]);
+        glBindTextureUnit(DEPTH_TEXTURE_UNIT, m_depth_stencil_texture);
+
+        lighting_shader.use();
+        glBindVertexArray(m_empty_vertex_array);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    bool GBuffer::is_valid() const
+    {
+        return m_framebuffer != 0;
+    }
+
+    void GBuffer::release()
+    {
+        if (m_framebuffer)
+            glDeleteFramebuffers(1, &m_framebuffer);
+        for (auto& texture : m_color_textures)
+        {
+            if (texture)
+                glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+        if (m_depth_stencil_texture)
+            glDeleteTextures(1, &m_depth_stencil_texture);
+
+        m_framebuffer = 0;
+        m_depth_stencil_texture = 0;
+    }
+}
@@ -0,0 +1,154 @@
+#include "geometry_pool.hpp"
+#include "mesh.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace yazpgp
+{
+    namespace
+    {
+        constexpr GLuint VERTEX_BINDING_INDEX = 0;
+
+        size_t index_size_of(GLenum index_type)
+        {
+            return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        }
+
+        GLuint resize_buffer(GLuint buffer, size_t old_size_bytes, size_t new_size_bytes)
+        {
+            GLuint resized = 0;
+            glCreateBuffers(1, &resized);
+            glNamedBufferStorage(resized, new_size_bytes, nullptr, 0);
+            if (buffer)
+            {
+                if (old_size_bytes > 0)
+                    glCopyNamedBufferSubData(buffer, resized, 0, 0, old_size_bytes);
+                glDeleteBuffers(1, &buffer);
+            }
+            return resized;
+        }
+    }
+
+    GeometryPool::~GeometryPool()
+    {
+        for (const auto& arena : m_arenas)
+        {
+            glDeleteVertexArrays(1, &arena.vao);
+            if (arena.vbo)
+                glDeleteBuffers(1, &arena.vbo);
+            if (arena.ebo)
+                glDeleteBuffers(1, &arena.ebo);
+        }
+    }
+
+    bool GeometryPool::add(const std::shared_ptr<Mesh>& mesh)
+    {
+        if (not mesh)
+            return false;
+
+        const auto pooled = m_ranges.find(mesh.get());
+        if (pooled != m_ranges.end() and pooled->second.generation == mesh->generation())
+            return true;
+
+        // indices are relative to the base vertex, so they keep the type of the mesh
+        const uint32_t arena_index = arena_of(*mesh);
+        Arena& arena = m_arenas[arena_index];
+        const size_t stride = arena.layout.get_stride();
+        const size_t index_size = index_size_of(arena.index_type);
+        reserve_vertices(arena, arena.vertex_count + mesh->get_vert_count());
+        // every LOD comes along, they are ranges relative to the first index of the mesh
+        reserve_indices(arena, arena.index_count + mesh->index_buffer_count());
+
+        glCopyNamedBufferSubData(mesh->vertex_buffer(), arena.vbo, 0, arena.vertex_count * stride, mesh->get_vert_count() * stride);
+        glCopyNamedBufferSubData(mesh->index_buffer(), arena.ebo, 0, arena.index_count * index_size, mesh->index_buffer_count() * index_size);
+
+        if (pooled == m_ranges.end())
+            m_meshes.push_back(mesh);
+        m_ranges[mesh.get()] = PooledMesh{
+            .range = MeshRange{
+                .first_index = static_cast<uint32_t>(arena.index_count),
+                .index_count = static_cast<uint32_t>(mesh->get_index_count()),
+                .base_vertex = static_cast<int32_t>(arena.vertex_count),
+                .index_type = arena.index_type,
+                .arena = arena_index
+            },
+            .generation = mesh->generation()
+        };
+        arena.vertex_count += mesh->get_vert_count();
+        arena.index_count += mesh->index_buffer_count();
+        return true;
+    }
+
+    std::optional<GeometryPool::MeshRange> GeometryPool::range_of(const Mesh* mesh) const
+    {
+        const auto it = m_ranges.find(mesh);
+        if (it == m_ranges.end())
+            return std::nullopt;
+        return it->second.range;
+    }
+
+    GLuint GeometryPool::vertex_array(uint32_t arena) const
+    {
+        return m_arenas[arena].vao;
+    }
+
+    size_t GeometryPool::vertex_count() const
+    {
+        size_t count = 0;
+        for (const auto& arena : m_arenas)
+            count += arena.vertex_count;
+        return count;
+    }
+
+    size_t GeometryPool::index_count() const
+    {
+        size_t count = 0;
+        for (const auto& arena : m_arenas)
+            count += arena.index_count;
+        return count;
+    }
+
+    uint32_t GeometryPool::arena_of(const Mesh& mesh)
+    {
+        const auto found = std::find_if(m_arenas.begin(), m_arenas.end(), [&](const Arena& arena)
+        {
+            return arena.index_type == mesh.index_type() and arena.layout == mesh.attribute_layout();
+        });
+        if (found != m_arenas.end())
+            return static_cast<uint32_t>(found - m_arenas.begin());
+
+        Arena& arena = m_arenas.emplace_back();
+        arena.layout = mesh.attribute_layout();
+        arena.index_type = mesh.index_type();
+        glCreateVertexArrays(1, &arena.vao);
+        arena.layout.apply(arena.vao, VERTEX_BINDING_INDEX);
+        YAZPGP_LOG_DEBUG("Geometry pool arena %zu for %zu byte vertices with %zu byte indices", m_arenas.size() - 1, arena.layout.get_stride(), index_size_of(arena.index_type));
+        return static_cast<uint32_t>(m_arenas.size() - 1);
+    }
+
+    void GeometryPool::reserve_vertices(Arena& arena, size_t vertex_count)
+    {
+        if (vertex_count <= arena.vertex_capacity)
+            return;
+
+        const size_t stride = arena.layout.get_stride();
+        const size_t capacity = std::max(vertex_count, arena.vertex_capacity * 2);
+        arena.vbo = resize_buffer(arena.vbo, arena.vertex_count * stride, capacity * stride);
+        arena.vertex_capacity = capacity;
+        glVertexArrayVertexBuffer(arena.vao, VERTEX_BINDING_INDEX, arena.vbo, 0, stride);
+    }
+
+    void GeometryPool::reserve_indices(Arena& arena, size_t index_count)
+    {
+        if (index_count <= arena.index_capacity)
+            return;
+
+        const size_t index_size = index_size_of(arena.index_type);
+        const size_t capacity = std::max(index_count, arena.index_capacity * 2);
+        arena.ebo = resize_buffer(arena.ebo, arena.index_count * index_size, capacity * index_size);
+        arena.index_capacity = capacity;
+        glVertexArrayElementBuffer(arena.vao, arena.ebo);
+    }
+}
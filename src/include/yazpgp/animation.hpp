@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "transform_store.hpp"
+#include "sparse_set.hpp"
+#include "job_system.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief tracks animating one entity, each track moves the result of the previous ones
+     *
+     * Sampling starts with the matrix of the entity transform and pre-multiplies every track in the
+     * order they were added, so translate then rotate orbits around the parent.
+     * Tracks are sampled from the scene time, they do not depend on the frame rate.
+     */
+    class Animation
+    {
+    public:
+        constexpr static uint32_t MAX_BEZIER_POINTS = 16;
+
+        enum class TrackType : uint8_t
+        {
+            Rotate,
+            Translate,
+            Oscillate,
+            BezierPath,
+            Keyframes
+        };
+
+        enum class Channel : uint8_t
+        {
+            Translation,
+            // euler angles in degrees
+            Rotation,
+            Scale
+        };
+
+        enum class Playback : uint8_t
+        {
+            Loop,
+            // forth and back with eased turns
+            PingPong
+        };
+
+        struct Keyframe
+        {
+            float time;
+            glm::vec3 value;
+        };
+
+        /**
+         * @brief one element of the track arrays, fields unused by the type stay zero
+         */
+        struct Track
+        {
+            TrackType type;
+            Channel channel;
+            Playback playback;
+            // rotate: angles at time 0, translate: offset, oscillate: amplitude
+            glm::vec3 base = glm::vec3(0.0f);
+            // rotate: degrees per second, translate: units per second
+            glm::vec3 rate = glm::vec3(0.0f);
+            // oscillate: cycles per second
+            float frequency = 0.0f;
+            // oscillate: radians
+            float phase = 0.0f;
+            // bezier path: seconds from the first to the last point
+            float duration = 0.0f;
+            // range in the point or keyframe array
+            uint32_t first = 0;
+            uint32_t count = 0;
+            uint32_t points_per_curve = 0;
+        };
+
+        Animation& rotate(const glm::vec3& degrees_per_second, const glm::vec3& initial_degrees = glm::vec3(0.0f));
+        Animation& translate(const glm::vec3& offset, const glm::vec3& velocity = glm::vec3(0.0f));
+        /**
+         * @brief translates by amplitude * sin(2 pi frequency t + phase)
+         */
+        Animation& oscillate(const glm::vec3& amplitude, float frequency, float phase = 0.0f);
+        /**
+         * @brief translates along consecutive bezier curves of points_per_curve control points each
+         */
+        Animation& bezier_path(const std::vector<glm::vec3>& points, uint32_t points_per_curve, float duration, Playback playback = Playback::PingPong);
+        /**
+         * @brief linearly interpolated keyframes sorted by time, they loop after the last one
+         */
+        Animation& keyframes(Channel channel, const std::vector<Keyframe>& keyframes);
+
+        bool empty() const;
+        const std::vector<Track>& tracks() const;
+        const std::vector<glm::vec3>& points() const;
+        const std::vector<Keyframe>& keyframe_values() const;
+
+    private:
+        std::vector<Track> m_tracks;
+        std::vector<glm::vec3> m_points;
+        std::vector<Keyframe> m_keyframes;
+    };
+
+    /**
+     * @brief animations of all scene entities, their tracks, points and keyframes in three contiguous arrays
+     *
+     * Only animated entities hold an entry, sample() evaluates all of them in one loop.
+     */
+    class Animator
+    {
+    public:
+        void add(const Animation& animation);
+        void set(uint32_t entity, const Animation& animation);
+        void remove(uint32_t entity);
+        void clear();
+
+        /**
+         * @brief local matrices of the animated entities, animation applied to the transform matrix
+         *
+         * @param local_matrices written in the order of animated()
+         * @param jobs samples chunks of entities in parallel, nullptr samples on the calling thread
+         */
+        void sample(double time, const TransformStore& transforms, std::vector<glm::mat4>& local_matrices, JobSystem* jobs = nullptr);
+
+        bool animates(uint32_t entity) const;
+        // entity indices in no particular order, as of the last sample
+        const std::vector<uint32_t>& animated() const;
+        size_t track_count() const;
+        size_t size() const;
+
+    private:
+        struct Clip
+        {
+            uint32_t entity;
+            uint32_t first_track;
+            uint32_t track_count;
+        };
+
+        // entity descriptions, flattened into the arrays below when one of them changed
+        SparseSet<Animation> m_animations;
+        bool m_dirty = false;
+
+        std::vector<Clip> m_clips;
+        std::vector<uint32_t> m_animated;
+        std::vector<Animation::Track> m_tracks;
+        std::vector<glm::vec3> m_points;
+        std::vector<Animation::Keyframe> m_keyframes;
+
+        void flatten();
+        glm::mat4 apply(const Animation::Track& track, double time, const glm::mat4& m) const;
+    };
+}
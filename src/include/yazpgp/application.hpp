@@ -4,6 +4,8 @@
 #include <string>
 
 #include "window.hpp"
+#include "job_system.hpp"
+#include "asset_loader.hpp"
 
 namespace yazpgp
 {
@@ -24,6 +26,10 @@ namespace yazpgp
     private:
         ApplicationConfig m_config;
         std::unique_ptr<Window> m_window;
+        // per frame engine work, the main thread takes part while it waits
+        std::unique_ptr<JobSystem> m_job_system;
+        // destroyed first, it finishes its loads with the GL context and the job system still alive
+        std::unique_ptr<AssetLoader> m_asset_loader;
         void frame();
     };
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include "job_system.hpp"
+#include "mesh.hpp"
+#include "texture_2d.hpp"
+#include "cubemap.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief streams assets in while the application keeps rendering
+     *
+     * load_*() return a placeholder backed asset right away. Every load is a coroutine which parses
+     * and decodes on a job system worker, then hops to the render thread where the GL upload swaps
+     * the real data into the returned object, so scenes built on the placeholder pick it up in place.
+     * Hops to the render thread go through a lock-free queue drained by process_uploads().
+     */
+    class AssetLoader
+    {
+    public:
+        /**
+         * @brief fire and forget coroutine, starts eagerly and frees its frame when it returns
+         */
+        struct Task
+        {
+            struct promise_type
+            {
+                Task get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+        // co_await resumes the coroutine on a job system worker thread, see JobSystem::run_background
+        struct WorkerAwaiter
+        {
+            AssetLoader& loader;
+
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const {}
+        };
+
+        // co_await resumes the coroutine in process_uploads(), on the thread owning the GL context
+        struct RenderThreadAwaiter
+        {
+            AssetLoader& loader;
+            std::coroutine_handle<> handle = nullptr;
+            // intrusive link of the upload queue, the awaiter lives in the suspended coroutine frame
+            RenderThreadAwaiter* next = nullptr;
+
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const {}
+        };
+
+        explicit AssetLoader(JobSystem& jobs);
+        // finishes every load in flight, the GL context has to be alive
+        ~AssetLoader();
+        AssetLoader(const AssetLoader&) = delete;
+        AssetLoader& operator=(const AssetLoader&) = delete;
+
+        /**
+         * @brief placeholder mesh drawing nothing until the file is loaded, see Mesh::create_placeholder
+         */
+        std::shared_ptr<Mesh> load_mesh(const std::string& path);
+        /**
+         * @brief one white texel until the file is loaded
+         */
+        std::shared_ptr<Texture2D> load_texture(const std::string& path);
+        /**
+         * @brief six black texels until the files are loaded
+         *
+         * @param paths in order: right, left, top, bottom, front, back
+         */
+        std::shared_ptr<CubeMap> load_cubemap(const std::array<std::string, 6>& paths);
+
+        WorkerAwaiter on_worker();
+        RenderThreadAwaiter on_render_thread();
+
+        /**
+         * @brief resumes loads waiting for the render thread, call once per frame
+         *
+         * @param max_uploads spreads large batches of uploads over several frames
+         * @return number of loads resumed
+         */
+        size_t process_uploads(size_t max_uploads);
+        // loads started and not uploaded yet
+        size_t pending() const;
+
+    private:
+        JobSystem& m_jobs;
+        // hops onto workers, the destructor waits for them before draining the queue
+        JobSystem::Counter m_worker_hops;
+        // lock-free stack pushed by workers, newest first
+        std::atomic<RenderThreadAwaiter*> m_upload_head = nullptr;
+        // taken from the stack but over the budget of the frame, render thread only
+        std::deque<RenderThreadAwaiter*> m_ready_uploads;
+        std::atomic<size_t> m_pending = 0;
+
+        Task mesh_task(std::shared_ptr<Mesh> mesh, std::string path);
+        Task texture_task(std::shared_ptr<Texture2D> texture, std::string path);
+        Task cubemap_task(std::shared_ptr<CubeMap> cubemap, std::array<std::string, 6> paths);
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+
+namespace yazpgp
+{
+    struct AABB
+    {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+        bool is_empty() const
+        {
+            return min.x > max.x or min.y > max.y or min.z > max.z;
+        }
+
+        glm::vec3 center() const
+        {
+            return (min + max) * 0.5f;
+        }
+
+        glm::vec3 extents() const
+        {
+            return (max - min) * 0.5f;
+        }
+
+        AABB& expand(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+            return *this;
+        }
+
+        float surface_area() const
+        {
+            if (is_empty())
+                return 0.0f;
+            const glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool contains(const AABB& other) const
+        {
+            return min.x <= other.min.x and min.y <= other.min.y and min.z <= other.min.z
+                and max.x >= other.max.x and max.y >= other.max.y and max.z >= other.max.z;
+        }
+
+        bool intersects(const AABB& other) const
+        {
+            return min.x <= other.max.x and min.y <= other.max.y and min.z <= other.max.z
+                and max.x >= other.min.x and max.y >= other.min.y and max.z >= other.min.z;
+        }
+
+        float distance_squared(const glm::vec3& point) const
+        {
+            const glm::vec3 offset = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+            return glm::dot(offset, offset);
+        }
+
+        static AABB merge(const AABB& a, const AABB& b)
+        {
+            return AABB{ glm::min(a.min, b.min), glm::max(a.max, b.max) };
+        }
+
+        /**
+         * @brief AABB of this box after transformation, using Arvo's method
+         *
+         * @param matrix affine transformation
+         * @return AABB
+         */
+        AABB transformed(const glm::mat4& matrix) const
+        {
+            if (is_empty())
+                return *this;
+
+            const glm::vec3 translation = glm::vec3(matrix[3]);
+            AABB result{translation, translation};
+            for (int column = 0; column < 3; column++)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    float a = matrix[column][row] * min[column];
+                    float b = matrix[column][row] * max[column];
+                    result.min[row] += std::min(a, b);
+                    result.max[row] += std::max(a, b);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief computes AABB of interleaved vertex data
+         *
+         * @param vertices first three floats of every vertex are position
+         * @param vertex_count
+         * @param stride_bytes distance between two vertices in bytes
+         * @return AABB
+         */
+        static AABB from_vertices(const float* vertices, size_t vertex_count, size_t stride_bytes)
+        {
+            AABB result;
+            const auto* bytes = reinterpret_cast<const char*>(vertices);
+            for (size_t i = 0; i < vertex_count; i++)
+            {
+                const auto* position = reinterpret_cast<const float*>(bytes + i * stride_bytes);
+                result.expand({position[0], position[1], position[2]});
+            }
+            return result;
+        }
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        /**
+         * @brief sphere after affine transformation, radius is scaled by the largest axis scale
+         */
+        BoundingSphere transformed(const glm::mat4& matrix) const
+        {
+            const float max_scale_squared = std::max({
+                glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+                glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))
+            });
+
+            return BoundingSphere{
+                .center = glm::vec3(matrix * glm::vec4(center, 1.0f)),
+                .radius = radius * std::sqrt(max_scale_squared)
+            };
+        }
+
+        /**
+         * @brief sphere centered in the AABB of the points, with radius to the farthest point
+         */
+        static BoundingSphere from_vertices(const float* vertices, size_t vertex_count, size_t stride_bytes, const AABB& aabb)
+        {
+            BoundingSphere result{ .center = aabb.center(), .radius = 0.0f };
+            const auto* bytes = reinterpret_cast<const char*>(vertices);
+            float max_distance_squared = 0.0f;
+            for (size_t i = 0; i < vertex_count; i++)
+            {
+                const auto* position = reinterpret_cast<const float*>(bytes + i * stride_bytes);
+                glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - result.center;
+                max_distance_squared = std::max(max_distance_squared, glm::dot(offset, offset));
+            }
+            result.radius = std::sqrt(max_distance_squared);
+            return result;
+        }
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include <limits>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "bounds.hpp"
+#include "frustum.hpp"
+#include "job_system.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief dynamic bounding volume hierarchy, one object per leaf
+     *
+     * Leaves store fattened AABBs, so objects moving a little don't touch the tree at all.
+     * Objects leaving their fat AABB are reinserted, internal nodes are kept balanced by tree rotations.
+     * Bulk loads should use build(), which creates the tree top-down with binned SAH, in parallel when given a job system.
+     */
+    class Bvh
+    {
+    public:
+        using ProxyId = int32_t;
+        constexpr static ProxyId NULL_NODE = -1;
+
+        struct Item
+        {
+            AABB aabb;
+            uint32_t user_data;
+        };
+
+        struct Ray
+        {
+            glm::vec3 origin;
+            glm::vec3 direction;
+            float max_distance = std::numeric_limits<float>::max();
+        };
+
+        struct RayHit
+        {
+            uint32_t user_data;
+            float distance;
+        };
+
+        Bvh(float margin = 0.1f);
+
+        ProxyId insert(const AABB& aabb, uint32_t user_data);
+        void remove(ProxyId proxy);
+
+        /**
+         * @brief moves the proxy to the new AABB
+         *
+         * @return true if the proxy had to be reinserted
+         * @return false if the new AABB still fits into the fat AABB
+         */
+        bool update(ProxyId proxy, const AABB& aabb);
+
+        /**
+         * @brief rebuilds the whole tree from scratch using binned SAH
+         *
+         * @param items
+         * @param proxies resized to items.size(), proxies[i] belongs to items[i]
+         * @param jobs builds large subtrees in parallel, nullptr builds on the calling thread
+         */
+        void build(const std::vector<Item>& items, std::vector<ProxyId>& proxies, JobSystem* jobs = nullptr);
+        void clear();
+
+        uint32_t user_data(ProxyId proxy) const;
+        void set_user_data(ProxyId proxy, uint32_t user_data);
+        const AABB& fat_aabb(ProxyId proxy) const;
+        size_t size() const;
+        int32_t height() const;
+
+        /**
+         * @brief collects objects overlapping the frustum
+         *
+         * @param inside objects whose subtree is completely inside, no further test needed
+         * @param intersecting objects whose fat AABB crosses a frustum plane
+         */
+        void query_frustum(const Frustum& frustum, std::vector<uint32_t>& inside, std::vector<uint32_t>& intersecting) const;
+        void query_sphere(const BoundingSphere& sphere, std::vector<uint32_t>& result) const;
+        void query_aabb(const AABB& aabb, std::vector<uint32_t>& result) const;
+
+        /**
+         * @brief all objects hit by the ray, sorted by distance to their AABB
+         */
+        void query_ray(const Ray& ray, std::vector<RayHit>& result) const;
+        std::optional<RayHit> raycast(const Ray& ray) const;
+
+        /**
+         * @brief k objects with the closest AABBs to the point, sorted from the closest
+         */
+        void query_k_nearest(const glm::vec3& point, size_t k, std::vector<uint32_t>& result) const;
+
+    private:
+        struct Node
+        {
+            AABB aabb;
+            // next free node when the node is in the free list
+            int32_t parent = NULL_NODE;
+            int32_t left = NULL_NODE;
+            int32_t right = NULL_NODE;
+            // leaf = 0, free node = -1
+            int32_t height = -1;
+            uint32_t user_data = 0;
+
+            bool is_leaf() const { return left == NULL_NODE; }
+        };
+
+        struct BuildReference
+        {
+            AABB aabb;
+            glm::vec3 centroid;
+            uint32_t item_index;
+            uint32_t user_data;
+        };
+
+        std::vector<Node> m_nodes;
+        int32_t m_root;
+        int32_t m_free_list;
+        size_t m_leaf_count;
+        float m_margin;
+
+        int32_t allocate_node();
+        void free_node(int32_t node);
+        void insert_leaf(int32_t leaf);
+        void remove_leaf(int32_t leaf);
+        int32_t balance(int32_t node);
+        void fix_upwards(int32_t node);
+        AABB fatten(const AABB& aabb) const;
+
+        void build_recursive(int32_t node, BuildReference* begin, BuildReference* end, std::vector<ProxyId>& proxies, JobSystem* jobs);
+    };
+}
@@ -4,6 +4,7 @@
 #include <memory>
 #include <GL/glew.h>
 #include <array>
+#include <span>
 
 #include "texture.hpp"
 
@@ -11,6 +12,11 @@ namespace yazpgp
 {
     class CubeMap : public Texture
     {
+        // glTexStorage2D cannot be respecified, the next upload needs a new texture name
+        bool m_immutable = false;
+
+        void reset_immutable();
+
     public:
         struct CubeMapDataPart
         {
@@ -21,7 +27,19 @@ namespace yazpgp
         };
 
         CubeMap(const std::array<CubeMapDataPart, 6>& data);
+        CubeMap(GLenum internal_format, GLenum format, uint32_t level_count, std::span<const TextureLevel> levels);
         ~CubeMap();
+
+        /**
+         * @brief replaces all faces, the texture keeps its id
+         */
+        void upload(const std::array<CubeMapDataPart, 6>& data);
+        /**
+         * @brief replaces all faces with immutable storage filled from precomputed levels
+         *
+         * @param levels face major, face * level_count + level, faces in the order of CubeMapDataPart
+         */
+        void upload_levels(GLenum internal_format, GLenum format, uint32_t level_count, std::span<const TextureLevel> levels);
         virtual void use(uint32_t texture_slot) const override;
     };
 }
\ No newline at end of file
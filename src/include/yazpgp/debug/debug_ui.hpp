@@ -8,10 +8,12 @@ namespace yazpgp
     {
         DebugUI() = default;
         ~DebugUI() = default;
+        static void render_stats_component(Scene& scene);
         static void camera_component(Camera& camera);
         static void lights_component(std::vector<PointLight>& lights);
-        static void entities_component(std::vector<std::unique_ptr<RenderableEntity>>& entities);
-        static void phong_blinn_material_component(PhongBlinnMaterial& material);
+        static void entities_component(Scene& scene);
+        // returns true when a parameter was edited
+        static bool phong_blinn_material_component(PhongBlinnMaterial& material);
     public:
         static void scene_window(Scene& scene);
     };
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace yazpgp
+{
+    /**
+     * @brief CPU side of one element of the EntityBlock in assets/shaders/common/entity.glsl, std430 layout
+     *
+     * Indexed by entity index, vertex shaders find the entity of an instance through the DrawEntityBlock.
+     */
+    struct EntityData
+    {
+        glm::mat4 model_matrix;
+        // mat3 columns are padded to vec4 in std430
+        glm::mat3x4 normal_matrix;
+        // entry of the MaterialBlock, see MaterialRegistry
+        int32_t material_index;
+        int32_t padding[3];
+    };
+
+    /**
+     * @brief CPU side of one element of the DrawEntityBlock, rewritten every frame in draw order
+     */
+    struct DrawEntityData
+    {
+        uint32_t entity_index;
+        // LightAssignment::LightList of the entity, offset is LightAssignment::UNASSIGNED without one
+        uint32_t light_offset;
+        uint32_t point_light_count;
+        uint32_t spot_light_count;
+    };
+
+    static_assert(sizeof(EntityData) == 128);
+    static_assert(sizeof(DrawEntityData) == 16);
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "shader.hpp"
+#include "mesh.hpp"
+#include "texture.hpp"
+#include "material.hpp"
+#include "bounds.hpp"
+#include "render_queue.hpp"
+#include "debug/debug_ui_def.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief indices of the GL resources of an entity into the tables of its EntityStorage
+     */
+    struct RenderHandles
+    {
+        uint32_t shader;
+        uint32_t mesh;
+        uint32_t texture_set;
+        uint32_t material;
+
+        // same shader and textures, the entities can be drawn by one multi draw
+        bool can_share_resources_with(const RenderHandles& other) const
+        {
+            return shader == other.shader and texture_set == other.texture_set;
+        }
+
+        // same resources and mesh, the entities can be drawn as instances of one draw
+        bool can_batch_with(const RenderHandles& other) const
+        {
+            return can_share_resources_with(other) and mesh == other.mesh;
+        }
+    };
+
+    static_assert(sizeof(RenderHandles) == 16);
+
+    /**
+     * @brief render components of the scene entities, one dense array per component indexed by entity
+     *
+     * Shaders, meshes, texture sets and materials are held once in deduplicated tables,
+     * entities only keep 16 bytes of handles to them. World matrices and bounds are written
+     * by the scene when an entity moved, render and update passes read them linearly.
+     */
+    class EntityStorage
+    {
+        ENABLE_DEBUG_UI();
+
+    public:
+        uint32_t add(
+            const std::shared_ptr<Shader>& shader,
+            const std::shared_ptr<Mesh>& mesh,
+            const std::vector<std::shared_ptr<Texture>>& textures,
+            const std::shared_ptr<Material>& material
+        );
+        // every later entity moves one index down, resources stay in the tables
+        void remove(uint32_t entity);
+        size_t size() const;
+
+        /**
+         * @brief world matrix with parents applied, updates the world bounds as well
+         */
+        void set_world_matrix(uint32_t entity, const glm::mat4& model_matrix, const glm::mat3& normal_matrix);
+
+        /**
+         * @brief recomputes world bounds of entities whose mesh was replaced since the last call, see Mesh::replace
+         *
+         * @param replaced_meshes receives the replaced meshes
+         * @param refreshed_entities receives the entities with new bounds
+         */
+        void refresh_replaced_meshes(std::vector<std::shared_ptr<Mesh>>& replaced_meshes, std::vector<uint32_t>& refreshed_entities);
+
+        const RenderHandles& handles(uint32_t entity) const;
+        const std::vector<RenderHandles>& handles() const;
+        const glm::mat4& model_matrix(uint32_t entity) const;
+        const glm::mat3& normal_matrix(uint32_t entity) const;
+        const AABB& world_aabb(uint32_t entity) const;
+        const std::vector<AABB>& world_aabbs() const;
+        const BoundingSphere& world_bounding_sphere(uint32_t entity) const;
+
+        const Shader& shader(uint32_t entity) const;
+        const Mesh& mesh(uint32_t entity) const;
+        const std::shared_ptr<Material>& material(uint32_t entity) const;
+
+        /**
+         * @brief binds shader and textures of the entity, everything but the geometry
+         */
+        void bind_resources(uint32_t entity, RenderState& state) const;
+
+        /**
+         * @brief draws instances listed in the bound DrawEntityBlock with the state of the entity
+         *
+         * Binds already present in the render state are skipped.
+         * @param base_instance first instance in the DrawEntityBlock
+         * @param instance_count number of entities sharing the state, see RenderHandles::can_batch_with
+         * @param lod level of the mesh, see Mesh::lods
+         */
+        void render(uint32_t entity, RenderState& state, uint32_t base_instance, uint32_t instance_count, uint32_t lod = 0) const;
+
+    private:
+        template<class T>
+        struct ResourceTable
+        {
+            std::vector<std::shared_ptr<T>> resources;
+            std::unordered_map<const T*, uint32_t> ids;
+
+            uint32_t add(const std::shared_ptr<T>& resource)
+            {
+                const auto [it, inserted] = ids.try_emplace(resource.get(), static_cast<uint32_t>(resources.size()));
+                if (inserted)
+                    resources.push_back(resource);
+                return it->second;
+            }
+        };
+
+        // Mesh::generation of every mesh in m_meshes as of the last refresh
+        std::vector<uint32_t> m_mesh_generations;
+        std::vector<uint8_t> m_replaced_mesh_ids;
+
+        ResourceTable<Shader> m_shaders;
+        ResourceTable<Mesh> m_meshes;
+        ResourceTable<Material> m_materials;
+        std::vector<std::vector<std::shared_ptr<Texture>>> m_texture_sets;
+        std::map<std::vector<const Texture*>, uint32_t> m_texture_set_ids;
+
+        std::vector<RenderHandles> m_handles;
+        std::vector<glm::mat4> m_model_matrices;
+        std::vector<glm::mat3> m_normal_matrices;
+        std::vector<AABB> m_world_aabbs;
+        std::vector<BoundingSphere> m_world_bounding_spheres;
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace yazpgp
+{
+    /**
+     * @brief CPU side of the FrameBlock uniform block in assets/shaders/common/frame.glsl, std140 layout
+     */
+    struct FrameBlockData
+    {
+        glm::mat4 view_matrix;
+        glm::mat4 projection_matrix;
+        glm::mat4 view_projection_matrix;
+        // world positions of the deferred lighting pass are unprojected from the depth buffer
+        glm::mat4 inverse_view_projection_matrix;
+        glm::vec3 camera_position;
+        float time;
+    };
+
+    static_assert(sizeof(FrameBlockData) == 4 * sizeof(glm::mat4) + sizeof(glm::vec4));
+}
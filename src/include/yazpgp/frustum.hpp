@@ -0,0 +1,56 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "bounds.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief bounding spheres in structure of arrays layout, so they can be tested four at a time
+     */
+    struct SphereBatch
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+
+        void clear();
+        void reserve(size_t count);
+        void push_back(const BoundingSphere& sphere);
+        size_t size() const;
+    };
+
+    class Frustum
+    {
+        // left, right, bottom, top, near, far; xyz is normal pointing inside, w is distance
+        std::array<glm::vec4, 6> m_planes;
+
+    public:
+        enum class Containment
+        {
+            Outside,
+            Intersects,
+            Inside
+        };
+
+        Frustum(const glm::mat4& view_projection_matrix);
+
+        const std::array<glm::vec4, 6>& planes() const;
+
+        bool intersects(const BoundingSphere& sphere) const;
+        bool intersects(const AABB& aabb) const;
+        Containment classify(const AABB& aabb) const;
+
+        /**
+         * @brief tests all spheres in the batch against the frustum
+         *
+         * @param batch
+         * @param visible resized to batch size, 1 if sphere intersects the frustum, 0 otherwise
+         * @return number of visible spheres
+         */
+        size_t test_spheres(const SphereBatch& batch, std::vector<uint8_t>& visible) const;
+    };
+}
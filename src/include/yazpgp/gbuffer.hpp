@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <GL/glew.h>
+#include "shader.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief render targets of the deferred path, read by the lighting pass in assets/shaders/deferred
+     *
+     * Albedo and world space normals are color attachments, material index and lighting model an integer one.
+     * World positions are reconstructed from the depth attachment, which also carries the stencil ids used for picking.
+     * Attachments are created on the first resize() and recreated whenever the viewport size changes.
+     */
+    class GBuffer
+    {
+    public:
+        // color attachment index, also the texture unit the lighting pass samples it from
+        enum Attachment : GLuint
+        {
+            ALBEDO = 0,
+            NORMAL = 1,
+            MATERIAL = 2,
+            COLOR_ATTACHMENT_COUNT = 3
+        };
+
+        // texture unit of the depth attachment in the lighting pass
+        constexpr static GLuint DEPTH_TEXTURE_UNIT = COLOR_ATTACHMENT_COUNT;
+
+        GBuffer() = default;
+        ~GBuffer();
+        GBuffer(const GBuffer&) = delete;
+        GBuffer& operator=(const GBuffer&) = delete;
+
+        void resize(uint32_t width, uint32_t height);
+
+        /**
+         * @brief binds the framebuffer for drawing and clears every attachment
+         */
+        void begin_geometry_pass() const;
+
+        /**
+         * @brief copies depth and stencil into the target framebuffer, so forward draws and picking see the deferred geometry
+         */
+        void blit_depth_stencil(GLuint target_framebuffer) const;
+
+        /**
+         * @brief shades every texel with one screen covering triangle, the attachments are bound to the units of Attachment
+         */
+        void draw_lighting_pass(const Shader& lighting_shader) const;
+
+        bool is_valid() const;
+
+    private:
+        GLuint m_framebuffer = 0;
+        std::array<GLuint, COLOR_ATTACHMENT_COUNT> m_color_textures = {};
+        GLuint m_depth_stencil_texture = 0;
+        // core profile draws need a vertex array even without attributes
+        GLuint m_empty_vertex_array = 0;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+
+        void release();
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include <GL/glew.h>
+#include "vertex_attributes.hpp"
+
+namespace yazpgp
+{
+    class Mesh;
+
+    /**
+     * @brief vertices and indices of many meshes in shared buffers
+     *
+     * Meshes with the same vertex attribute layout and index type share an arena, vertex and index
+     * buffers behind one vertex array, and can be drawn together with a single multi draw call.
+     * Their data is copied on the GPU.
+     */
+    class GeometryPool
+    {
+    public:
+        struct MeshRange
+        {
+            // the levels of Mesh::lods start at first_index + MeshLod::first_index
+            uint32_t first_index;
+            // of the finest level
+            uint32_t index_count;
+            int32_t base_vertex;
+            // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+            GLenum index_type;
+            // selects the vertex array to draw with, ranges of one arena can share a multi draw
+            uint32_t arena;
+        };
+
+        GeometryPool() = default;
+        ~GeometryPool();
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        /**
+         * @brief copies the mesh into the pool and keeps it alive, adding it again does nothing
+         *
+         * A mesh whose geometry was replaced since it was added, see Mesh::generation, is copied again,
+         * the range of its old geometry stays unused.
+         * @return false for a null mesh
+         */
+        bool add(const std::shared_ptr<Mesh>& mesh);
+        std::optional<MeshRange> range_of(const Mesh* mesh) const;
+        /**
+         * @brief vertex array with the vertex and index buffer of the arena
+         */
+        GLuint vertex_array(uint32_t arena) const;
+
+        size_t vertex_count() const;
+        size_t index_count() const;
+
+    private:
+        struct Arena
+        {
+            VertexAttributeLayout layout;
+            GLenum index_type = GL_UNSIGNED_INT;
+            GLuint vao = 0;
+            GLuint vbo = 0;
+            GLuint ebo = 0;
+            size_t vertex_capacity = 0;
+            size_t vertex_count = 0;
+            size_t index_capacity = 0;
+            size_t index_count = 0;
+        };
+
+        // few distinct layouts exist, a linear search finds the arena
+        std::vector<Arena> m_arenas;
+
+        std::vector<std::shared_ptr<Mesh>> m_meshes;
+        struct PooledMesh
+        {
+            MeshRange range;
+            uint32_t generation;
+        };
+
+        std::unordered_map<const Mesh*, PooledMesh> m_ranges;
+
+        uint32_t arena_of(const Mesh& mesh);
+        void reserve_vertices(Arena& arena, size_t vertex_count);
+        void reserve_indices(Arena& arena, size_t index_count);
+    };
+}
@@ -2,6 +2,8 @@
 #include <string>
 #include <optional>
 #include <memory>
+#include <vector>
+#include <span>
 #include "shader.hpp"
 #include "mesh.hpp"
 #include "texture_2d.hpp"
@@ -11,11 +13,68 @@ namespace yazpgp
 {
     namespace io
     {
+        // Assimp post processing of read_mesh_data, part of the mesh cache key
+        extern const uint32_t MESH_IMPORT_FLAGS;
+
+        /**
+         * @brief part of a mesh file, indices are already offset by first_vertex
+         */
+        struct SubMeshRange
+        {
+            uint32_t first_index;
+            uint32_t index_count;
+            uint32_t first_vertex;
+            uint32_t vertex_count;
+        };
+
+        struct MeshData
+        {
+            std::vector<Vertex> vertices;
+            // every LOD after another, submeshes cover the finest one
+            std::vector<uint32_t> indices;
+            std::vector<SubMeshRange> submeshes;
+            std::vector<MeshLod> lods;
+            // of the finest LOD, none crosses a submesh
+            std::vector<Meshlet> meshlets;
+        };
+
+        struct ImageData
+        {
+            std::vector<char> bytes;
+            int32_t width;
+            int32_t height;
+            uint32_t channels;
+        };
+
+        /**
+         * @brief parses a mesh file without touching GL, safe to call from any thread
+         */
+        std::optional<MeshData> read_mesh_data(const std::string& path);
+
+        /**
+         * @brief decodes an image file without touching GL, safe to call from any thread
+         *
+         * @param flip_vertically rows bottom to top, the order glTexImage2D expects
+         */
+        std::optional<ImageData> read_image(const std::string& path, bool flip_vertically);
+
         std::shared_ptr<Mesh> load_mesh_from_file(const std::string& path);
         std::shared_ptr<Shader> load_shader_from_file(const std::string& vertex_path, const std::string& fragment_path);
         std::shared_ptr<Texture2D> load_texture_from_file(const std::string& path);
         std::optional<std::string> slurp_file(const std::string& path);
 
+        /**
+         * @brief writes a temporary next to path and renames it over path, readers never see half a file
+         *
+         * Creates missing parent directories. Concurrent writers of the same path are fine, the last rename wins.
+         */
+        bool replace_file(const std::string& path, std::span<const char> contents);
+
+        /**
+         * @brief reads shader source and replaces #include "path" lines, paths are relative to the including file
+         */
+        std::optional<std::string> load_shader_source(const std::string& path);
+
         /**
          * @brief Loads a cubemap from 6 files
          * 
@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yazpgp
+{
+    /**
+     * @brief work-stealing scheduler, every worker owns a deque and steals from the others when it runs dry
+     *
+     * Owners push and pop at the back, so nested jobs run depth first and stay in cache,
+     * thieves take the oldest and usually biggest jobs from the front.
+     * Threads waiting on a counter execute jobs instead of blocking, the main thread works as worker 0.
+     */
+    class JobSystem
+    {
+    public:
+        using JobFunction = void (*)(void* context, uint32_t begin, uint32_t end);
+        class Counter;
+
+    private:
+        struct Job
+        {
+            JobFunction function;
+            void* context;
+            uint32_t begin;
+            uint32_t end;
+            Counter* counter;
+        };
+
+    public:
+        /**
+         * @brief number of unfinished jobs, jobs scheduled after it wait until it reaches zero
+         */
+        class Counter
+        {
+            friend class JobSystem;
+
+            std::atomic<uint32_t> m_pending = 0;
+            // held while the last job finishes, so a waiter cannot destroy the counter under it
+            mutable std::mutex m_mutex;
+            // jobs depending on this counter, scheduled when it reaches zero
+            std::vector<Job> m_continuations;
+
+        public:
+            Counter() = default;
+            Counter(const Counter&) = delete;
+            Counter& operator=(const Counter&) = delete;
+
+            bool done() const;
+        };
+
+        /**
+         * @param worker_count threads besides the calling one, 0 runs every job on the waiting thread
+         */
+        explicit JobSystem(uint32_t worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /**
+         * @brief schedules function over [0, count) in chunks of chunk_size, does not wait for them
+         *
+         * @param context passed to every chunk, has to outlive the counter
+         * @param dependency chunks start once it is done, nullptr starts them right away
+         */
+        void run(JobFunction function, void* context, uint32_t count, uint32_t chunk_size, Counter& counter, Counter* dependency = nullptr);
+
+        /**
+         * @brief schedules one long running job, like an asset load, on the worker threads only
+         *
+         * wait() never picks these up, so a frame waiting on its own jobs cannot end up running one.
+         * Without worker threads wait() runs them, there is nobody else to.
+         */
+        void run_background(JobFunction function, void* context, Counter& counter);
+
+        /**
+         * @brief executes jobs until the counter is done
+         */
+        void wait(const Counter& counter);
+
+        // threads executing jobs including the one calling wait()
+        uint32_t thread_count() const;
+
+        /**
+         * @brief schedules function(begin, end) over [0, count) in chunks, see run()
+         */
+        template<class F>
+        void parallel_for(uint32_t count, uint32_t chunk_size, const F& function, Counter& counter, Counter* dependency = nullptr)
+        {
+            run(&invoke_range<F>, const_cast<F*>(&function), count, chunk_size, counter, dependency);
+        }
+
+        /**
+         * @brief calls function(begin, end) over [0, count) in chunks and waits for all of them
+         */
+        template<class F>
+        void parallel_for(uint32_t count, uint32_t chunk_size, const F& function)
+        {
+            if (count <= chunk_size)
+            {
+                if (count > 0)
+                    function(0, count);
+                return;
+            }
+
+            Counter counter;
+            parallel_for(count, chunk_size, function, counter);
+            wait(counter);
+        }
+
+        /**
+         * @brief schedules one function() call, does not wait for it
+         */
+        template<class F>
+        void spawn(const F& function, Counter& counter, Counter* dependency = nullptr)
+        {
+            run(&invoke_task<F>, const_cast<F*>(&function), 1, 1, counter, dependency);
+        }
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        // shared by all worker threads, oldest first
+        std::mutex m_background_mutex;
+        std::deque<Job> m_background_jobs;
+        // jobs sitting in any deque including the background one, sleeping workers wake up when it is non zero
+        std::atomic<uint32_t> m_queued = 0;
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake;
+        bool m_stop = false;
+
+        void push(const Job* jobs, size_t count);
+        bool pop(uint32_t worker, Job& job);
+        bool steal(uint32_t thief, Job& job);
+        bool execute_one(uint32_t worker);
+        bool execute_background();
+        void finish(const Job& job);
+        void worker_loop(uint32_t worker);
+        uint32_t current_worker() const;
+
+        template<class F>
+        static void invoke_range(void* context, uint32_t begin, uint32_t end)
+        {
+            (*static_cast<const F*>(context))(begin, end);
+        }
+
+        template<class F>
+        static void invoke_task(void* context, uint32_t, uint32_t)
+        {
+            (*static_cast<const F*>(context))();
+        }
+    };
+
+    /**
+     * @brief JobSystem::parallel_for when there is a job system, a plain loop over one chunk otherwise
+     */
+    template<class F>
+    void parallel_for(JobSystem* jobs, uint32_t count, uint32_t chunk_size, const F& function)
+    {
+        if (jobs)
+            jobs->parallel_for(count, chunk_size, function);
+        else if (count > 0)
+            function(0, count);
+    }
+}
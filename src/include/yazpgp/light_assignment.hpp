@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "bvh.hpp"
+#include "bounds.hpp"
+#include "lights/point_light.hpp"
+#include "lights/spot_light.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief lights reaching each drawn entity, found by intersecting light influence spheres with entity bounds
+     *
+     * Every light queries the spatial index with its influence sphere, candidates are refined with the world AABB of the entity.
+     * Fragments pick the shorter of their entity list and their cluster list, see assets/shaders/common/entity_lights.glsl.
+     */
+    class LightAssignment
+    {
+    public:
+        /**
+         * @brief lights of an entity are light_indices()[offset, offset + point_count) followed by spot_count spot lights
+         */
+        struct LightList
+        {
+            uint32_t offset;
+            uint32_t point_count;
+            uint32_t spot_count;
+        };
+
+        // offset of entities which were not assigned this frame, shaders fall back to the clusters
+        constexpr static uint32_t UNASSIGNED = UINT32_MAX;
+
+        /**
+         * @brief assigns lights to the entities at entity_indices, all other entities stay UNASSIGNED
+         *
+         * @param bvh spatial index whose user data are indices into world_aabbs
+         * @param indexed_count entities from here on are not in the bvh yet, no query finds them so they stay UNASSIGNED
+         */
+        void build(
+            const std::vector<PointLight>& point_lights,
+            const std::vector<SpotLight>& spot_lights,
+            const Bvh& bvh,
+            const std::vector<AABB>& world_aabbs,
+            const std::vector<uint32_t>& entity_indices,
+            size_t indexed_count
+        );
+
+        LightList list_of(uint32_t entity_index) const;
+        const std::vector<uint32_t>& light_indices() const;
+
+    private:
+        struct Reference
+        {
+            uint32_t entity;
+            uint32_t light_index;
+        };
+
+        std::vector<LightList> m_lists;
+        std::vector<uint32_t> m_light_indices;
+        std::vector<Reference> m_point_references;
+        std::vector<Reference> m_spot_references;
+        std::vector<uint32_t> m_candidates;
+        std::vector<uint32_t> m_cursors;
+
+        void assign_sphere(
+            const BoundingSphere& sphere,
+            uint32_t light_index,
+            const Bvh& bvh,
+            const std::vector<AABB>& world_aabbs,
+            std::vector<Reference>& references
+        );
+    };
+}
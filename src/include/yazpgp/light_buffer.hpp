@@ -0,0 +1,148 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "uniform_buffer.hpp"
+#include "stream_buffer.hpp"
+#include "light_clusters.hpp"
+#include "light_assignment.hpp"
+#include "lights/point_light.hpp"
+#include "lights/spot_light.hpp"
+#include "lights/directional_light.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief CPU side of the LightBlock uniform block in assets/shaders/common/lights.glsl, std140 layout
+     */
+    struct LightBlockData
+    {
+        struct Intensity
+        {
+            float ambient;
+            float diffuse;
+            float specular;
+            float padding;
+        };
+
+        struct DirectionalLight
+        {
+            glm::vec3 direction;
+            float padding0;
+            glm::vec3 color;
+            float padding1;
+            Intensity intensity;
+        };
+
+        DirectionalLight directional_lights[yazpgp::DirectionalLight::MAX_DIRECTIONAL_LIGHTS];
+        int32_t num_directional_lights;
+        int32_t num_point_lights;
+        int32_t num_spot_lights;
+        int32_t padding;
+        glm::vec2 cluster_tile_size;
+        float cluster_depth_scale;
+        float cluster_depth_bias;
+    };
+
+    /**
+     * @brief element of the PointLightBlock storage block, std430 layout
+     */
+    struct PointLightData
+    {
+        glm::vec3 position;
+        float illumination_radius;
+        glm::vec3 color;
+        float padding;
+        LightBlockData::Intensity intensity;
+    };
+
+    /**
+     * @brief element of the SpotLightBlock storage block, std430 layout
+     */
+    struct SpotLightData
+    {
+        glm::vec3 position;
+        float illumination_radius;
+        glm::vec3 direction;
+        float inner_cone_angle_degrees;
+        glm::vec3 color;
+        float outer_cone_angle_degrees;
+        LightBlockData::Intensity intensity;
+    };
+
+    static_assert(sizeof(LightBlockData::DirectionalLight) == 48);
+    static_assert(sizeof(LightBlockData) == 224);
+    static_assert(sizeof(PointLightData) == 48);
+    static_assert(sizeof(SpotLightData) == 64);
+    static_assert(sizeof(LightClusters::Cluster) == 16);
+
+    /**
+     * @brief all lights of a scene for the lighting shaders
+     *
+     * Point and spot lights live in storage buffers rewritten only after a light changed,
+     * their clusters are rebuilt every frame because they depend on the camera.
+     * Lists of the entity light assignment follow the cluster lists in the same index buffer.
+     * Directional lights light every fragment and stay in the LightBlock uniform block.
+     */
+    class LightBuffer
+    {
+        UniformBuffer m_block;
+        StreamBuffer m_point_lights;
+        StreamBuffer m_spot_lights;
+        StreamBuffer m_clusters;
+        StreamBuffer m_light_indices;
+        LightClusters m_light_clusters;
+        LightAssignment m_light_assignment;
+        LightBlockData m_data = {};
+        // frames until every region of the light buffers holds the current lights
+        size_t m_upload_frames = StreamBuffer::REGION_COUNT;
+        size_t m_upload_count = 0;
+
+    public:
+        LightBuffer();
+
+        void mark_dirty();
+
+        /**
+         * @brief assigns lights to the drawn entities, call every frame before upload_and_bind
+         *
+         * @param entity_indices entities drawn this frame, the others get LightAssignment::UNASSIGNED lists
+         * @param indexed_count entities in the bvh, see LightAssignment::build
+         */
+        void assign_entity_lights(
+            const std::vector<yazpgp::PointLight>& point_lights,
+            const std::vector<yazpgp::SpotLight>& spot_lights,
+            const Bvh& bvh,
+            const std::vector<AABB>& world_aabbs,
+            const std::vector<uint32_t>& entity_indices,
+            size_t indexed_count
+        );
+
+        /**
+         * @brief bins the lights for this view, writes the buffers and binds them to their block binding points
+         */
+        void upload_and_bind(
+            const std::vector<yazpgp::PointLight>& point_lights,
+            const std::vector<yazpgp::SpotLight>& spot_lights,
+            const std::vector<yazpgp::DirectionalLight>& directional_lights,
+            const glm::mat4& view_matrix,
+            const glm::mat4& projection_matrix,
+            const glm::vec2& viewport_size
+        );
+
+        /**
+         * @brief fences the buffers written by upload_and_bind, call after the last draw of the frame
+         */
+        void end_frame();
+
+        /**
+         * @brief list of the entity with its offset into the LightIndexBlock written by upload_and_bind
+         */
+        LightAssignment::LightList entity_lights(uint32_t entity_index) const;
+
+        size_t upload_count() const;
+        size_t light_index_count() const;
+        size_t entity_light_index_count() const;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "lights/point_light.hpp"
+#include "lights/spot_light.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief point and spot lights binned into a grid of view frustum clusters
+     *
+     * The grid is uniform in screen space and logarithmic in view depth, so clusters keep about the same shape.
+     * Lights are bounded by the sphere where their attenuation reaches zero, spot lights ignore their cone.
+     * A fragment finds its cluster from gl_FragCoord and its view depth, see assets/shaders/common/lights.glsl.
+     */
+    class LightClusters
+    {
+    public:
+        // keep in sync with CLUSTER_GRID in assets/shaders/common/lights.glsl
+        constexpr static uint32_t GRID_X = 16;
+        constexpr static uint32_t GRID_Y = 9;
+        constexpr static uint32_t GRID_Z = 24;
+        constexpr static uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+        /**
+         * @brief lights of a cluster are light_indices()[offset, offset + point_count) followed by spot_count spot lights
+         */
+        struct Cluster
+        {
+            uint32_t offset;
+            uint32_t point_count;
+            uint32_t spot_count;
+            uint32_t padding;
+        };
+
+        LightClusters();
+
+        void build(
+            const std::vector<PointLight>& point_lights,
+            const std::vector<SpotLight>& spot_lights,
+            const glm::mat4& view_matrix,
+            const glm::mat4& projection_matrix
+        );
+
+        const std::vector<Cluster>& clusters() const;
+        const std::vector<uint32_t>& light_indices() const;
+
+        // cluster slice of a view depth is floor(log(depth) * depth_scale + depth_bias)
+        float depth_scale() const;
+        float depth_bias() const;
+
+    private:
+        struct Reference
+        {
+            uint32_t cluster;
+            uint32_t light_index;
+        };
+
+        std::vector<Cluster> m_clusters;
+        std::vector<uint32_t> m_light_indices;
+        std::vector<Reference> m_point_references;
+        std::vector<Reference> m_spot_references;
+        std::vector<uint32_t> m_cursors;
+        float m_near = 0.1f;
+        float m_far = 100.0f;
+        float m_depth_scale = 1.0f;
+        float m_depth_bias = 0.0f;
+
+        uint32_t slice_of(float depth) const;
+        void bin_sphere(const glm::vec3& view_center, float radius, const glm::mat4& projection_matrix, uint32_t light_index, std::vector<Reference>& references) const;
+    };
+}
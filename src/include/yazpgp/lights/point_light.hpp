@@ -5,8 +5,6 @@ namespace yazpgp
 {
     struct PointLight : public EventProducer<PointLight>
     {
-        constexpr static auto MAX_POINT_LIGHTS = 4;
-
         glm::vec3 position = glm::vec3(0.0f);
         glm::vec3 color = glm::vec3(1.0f);
         float ambient_intensity = 0.1f;
@@ -52,6 +50,12 @@ namespace yazpgp
             return *this;
         }
 
+        // distance where the attenuation of the lighting shaders, max(1 - distance / illumination_radius * 2, 0), reaches zero
+        float influence_radius() const
+        {
+            return illumination_radius * 0.5f;
+        }
+
         PointLight& invoke()
         {
             notify(*this);
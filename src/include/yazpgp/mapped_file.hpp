@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace yazpgp
+{
+    /**
+     * @brief read only memory mapping of a whole file, pages are read in on first access
+     */
+    class MappedFile
+    {
+        const std::byte* m_data;
+        size_t m_size;
+
+    public:
+        // nullptr when the file cannot be opened or mapped, empty files included
+        static std::unique_ptr<MappedFile> create(const std::string& path);
+        MappedFile(const std::byte* data, size_t size);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const std::byte* data() const;
+        size_t size() const;
+        /**
+         * @brief hash of the contents, keys caches of data derived from the file
+         */
+        uint64_t hash() const;
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <tuple>
+#include <vector>
+#include <cstdint>
+
+namespace yazpgp
+{
+    /**
+     * @brief steps applied to a matrix in order, every step post-multiplies except Multiply
+     *
+     * chain() keeps the steps in a tuple, so a whole chain is one inlined function without heap allocations:
+     *
+     * const auto orbit = compositor::chain(
+     *     compositor::Rotate{{0, angle, 0}},
+     *     compositor::Translate{{0, 0, 8}},
+     *     compositor::Multiply{parent}
+     * );
+     * glm::mat4 output_mat = orbit(input_mat);
+     */
+    namespace compositor
+    {
+        struct Translate
+        {
+            glm::vec3 translation;
+
+            glm::mat4 operator()(glm::mat4 m) const
+            {
+                m[3] = m[0] * translation.x + m[1] * translation.y + m[2] * translation.z + m[3];
+                return m;
+            }
+        };
+
+        // euler angles in degrees, rotates around x first
+        struct Rotate
+        {
+            glm::vec3 rotation;
+
+            glm::mat4 operator()(const glm::mat4& m) const
+            {
+                const glm::mat4 rotated_x = glm::rotate(m, glm::radians(rotation.x), {1, 0, 0});
+                const glm::mat4 rotated_y = glm::rotate(rotated_x, glm::radians(rotation.y), {0, 1, 0});
+                return glm::rotate(rotated_y, glm::radians(rotation.z), {0, 0, 1});
+            }
+        };
+
+        struct Scale
+        {
+            glm::vec3 scale;
+
+            glm::mat4 operator()(glm::mat4 m) const
+            {
+                m[0] *= scale.x;
+                m[1] *= scale.y;
+                m[2] *= scale.z;
+                return m;
+            }
+        };
+
+        // pre-multiplies, puts everything composed so far into the space of matrix
+        struct Multiply
+        {
+            glm::mat4 matrix;
+
+            glm::mat4 operator()(const glm::mat4& m) const
+            {
+                return matrix * m;
+            }
+        };
+
+        template<class... Steps>
+        struct Chain
+        {
+            std::tuple<Steps...> steps;
+
+            glm::mat4 operator()(const glm::mat4& m = glm::mat4(1.0f)) const
+            {
+                return std::apply([&m](const auto&... step)
+                {
+                    glm::mat4 result = m;
+                    ((result = step(result)), ...);
+                    return result;
+                }, steps);
+            }
+        };
+
+        template<class... Steps>
+        Chain<Steps...> chain(const Steps&... steps)
+        {
+            return Chain<Steps...>{ std::tuple<Steps...>(steps...) };
+        }
+    }
+
+    /**
+     * @brief the compositor steps as a flat list built at runtime, for chains that come from data
+     *
+     * Building allocates, evaluation walks the list without allocations or recursion.
+     */
+    class Mat4InstructionList
+    {
+    public:
+        enum class Op : uint8_t
+        {
+            Translate,
+            Rotate,
+            Scale,
+            Multiply
+        };
+
+        struct Instruction
+        {
+            Op op;
+            // translation, rotation or scale, index into the matrices for Multiply
+            glm::vec3 value;
+            uint32_t matrix_index;
+        };
+
+        Mat4InstructionList& translate(const glm::vec3& translation);
+        Mat4InstructionList& rotate(const glm::vec3& rotation);
+        Mat4InstructionList& scale(const glm::vec3& scale);
+        Mat4InstructionList& multiply(const glm::mat4& matrix);
+        void clear();
+
+        glm::mat4 operator()(const glm::mat4& m = glm::mat4(1.0f)) const;
+
+        const std::vector<Instruction>& instructions() const;
+
+    private:
+        std::vector<Instruction> m_instructions;
+        std::vector<glm::mat4> m_matrices;
+    };
+}
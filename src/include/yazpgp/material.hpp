@@ -1,9 +1,23 @@
 #pragma once
-// #include <glm/glm.hpp>
-#include "shader.hpp"
+#include <glm/glm.hpp>
 
 namespace yazpgp
 {
+    /**
+     * @brief one entry of the MaterialBlock in assets/shaders/common/material_block.glsl, std140 layout
+     */
+    struct MaterialParameters
+    {
+        glm::vec3 ambient_color = glm::vec3(1.0f);
+        float padding0 = 0.0f;
+        glm::vec3 diffuse_color = glm::vec3(1.0f);
+        float padding1 = 0.0f;
+        glm::vec3 specular_color = glm::vec3(1.0f);
+        float specular_shininess = 32.0f;
+    };
+
+    static_assert(sizeof(MaterialParameters) == 48);
+
     struct Material
     {
         enum class Kind
@@ -12,8 +26,8 @@ namespace yazpgp
             
             COUNT
         };
-        virtual void use(const Shader& shader) = 0;
+        virtual MaterialParameters parameters() const = 0;
         virtual ~Material() = default;
         virtual Material::Kind kind() const = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "material.hpp"
+#include "uniform_buffer.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief parameters of all materials of a scene in one uniform buffer, draws select them by index
+     *
+     * Materials with identical parameters share an entry. Entry 0 holds the default parameters,
+     * it is used for entities without a material and for materials past MAX_MATERIALS.
+     */
+    class MaterialRegistry
+    {
+    public:
+        // keep in sync with MAX_MATERIALS in assets/shaders/common/material_block.glsl
+        constexpr static size_t MAX_MATERIALS = 256;
+
+        MaterialRegistry();
+
+        /**
+         * @brief keeps the material alive for the lifetime of the registry, adding it again does nothing
+         */
+        void add(const std::shared_ptr<Material>& material);
+
+        /**
+         * @brief call after parameters of an added material changed
+         */
+        void mark_dirty();
+
+        /**
+         * @brief deduplicates and rewrites the buffer when dirty, binds it to UniformBlockBinding::MATERIALS
+         */
+        void upload_and_bind();
+
+        /**
+         * @brief entry of the material as of the last upload_and_bind
+         */
+        uint32_t index_of(const Material* material) const;
+
+        size_t entry_count() const;
+        size_t upload_count() const;
+
+    private:
+        UniformBuffer m_buffer;
+        std::vector<std::shared_ptr<Material>> m_materials;
+        std::unordered_map<const Material*, uint32_t> m_index_by_material;
+        std::vector<MaterialParameters> m_entries;
+        bool m_dirty = true;
+        size_t m_upload_count = 0;
+
+        void deduplicate();
+    };
+}
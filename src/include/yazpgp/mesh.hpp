@@ -2,28 +2,129 @@
 #include <GL/glew.h>
 #include "vertex_attributes.hpp"
 #include "vertex.hpp"
+#include "bounds.hpp"
+#include "meshlet.hpp"
 #include <vector>
 #include <memory>
+#include <span>
 namespace yazpgp
 {
+    /**
+     * @brief 16 or 32-bit indices as they go into an index buffer
+     */
+    struct IndexSpan
+    {
+        const void* data = nullptr;
+        size_t count = 0;
+        GLenum type = GL_UNSIGNED_INT;
+
+        IndexSpan() = default;
+        IndexSpan(std::span<const uint32_t> indices)
+            : data(indices.data()), count(indices.size()), type(GL_UNSIGNED_INT) {}
+        IndexSpan(std::span<const uint16_t> indices)
+            : data(indices.data()), count(indices.size()), type(GL_UNSIGNED_SHORT) {}
+
+        size_t index_size() const { return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+        size_t size_bytes() const { return count * index_size(); }
+    };
+
+    /**
+     * @brief level of detail, a range of the index buffer over the vertices every level shares
+     */
+    struct MeshLod
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        // how far the simplified surface may be off the original one, in mesh units
+        float error;
+    };
+
     class Mesh
     {
         GLuint m_vao, m_vbo, m_ebo;
         size_t m_vert_count;
         size_t m_index_count;
+        size_t m_index_buffer_count;
+        std::vector<MeshLod> m_lods;
+        std::vector<Meshlet> m_meshlets;
+        size_t m_vertex_stride;
+        VertexAttributeLayout m_layout;
+        GLenum m_index_type = GL_UNSIGNED_INT;
+        AABB m_bounds;
+        BoundingSphere m_bounding_sphere;
+        uint32_t m_generation = 0;
 
+        void init(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets);
+        void release();
         void init_vao();
         void init_vbo(const float* vertices, size_t size_bytes);
-        void init_ebo(const uint32_t* indices, size_t size_bytes);
+        void init_ebo(IndexSpan indices);
+        void init_lods(std::span<const MeshLod> lods);
+        void init_meshlets(std::span<const Meshlet> meshlets);
+        void init_bounds(const float* vertices, size_t stride_bytes);
 
     public:
+        // the render queue keeps 3 bits of LOD per draw
+        constexpr static size_t MAX_LODS = 8;
+
+        /**
+         * @brief unindexed vertices, identical ones are welded and the triangles reordered for the vertex cache
+         */
         Mesh(const float* vertices, size_t size_bytes, const VertexAttributeLayout& layout);
         Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexAttributeLayout& layout);
+        /**
+         * @brief uploads the data as is, bounds are taken over instead of computed from the vertices
+         *
+         * @param vertices interleaved as the layout describes, quantized ones included
+         * @param lods ranges of indices, finest first, empty when all indices form the only level
+         * @param meshlets ranges of the finest level, empty when the mesh is always drawn whole
+         */
+        Mesh(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods = {}, std::span<const Meshlet> meshlets = {});
+        Mesh(std::span<const Vertex> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods = {}, std::span<const Meshlet> meshlets = {});
         ~Mesh();
+
+        /**
+         * @brief swaps the geometry for new data, the mesh stays the same object for everything holding it
+         *
+         * Bumps generation(), the scene then refreshes bounds and pooled geometry of its entities.
+         */
+        void replace(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexAttributeLayout& layout);
+        void replace(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods = {}, std::span<const Meshlet> meshlets = {});
+        // number of replace() calls
+        uint32_t generation() const;
         void use() const;
+        GLuint vertex_array() const;
+        GLuint vertex_buffer() const;
+        GLuint index_buffer() const;
+        size_t vertex_stride() const;
+        const VertexAttributeLayout& attribute_layout() const;
         size_t get_vert_count() const; 
-        size_t get_index_count() const;   
+        // indices of the finest level
+        size_t get_index_count() const;
+        // indices of every level
+        size_t index_buffer_count() const;
+        const std::vector<MeshLod>& lods() const;
+        const std::vector<Meshlet>& meshlets() const;
+        /**
+         * @brief coarsest level whose error stays below max_pixel_error on screen
+         *
+         * Going coarser than current needs a margin below the limit, so entities right at it
+         * do not switch levels every frame.
+         * @param pixels_per_unit size of one mesh unit on screen
+         */
+        uint32_t select_lod(float pixels_per_unit, float max_pixel_error, uint32_t current) const;
+        // GL_UNSIGNED_SHORT when every vertex can be indexed with 16 bits, GL_UNSIGNED_INT otherwise
+        GLenum index_type() const;
+        size_t index_size() const;
+        const AABB& bounds() const;
+        const BoundingSphere& bounding_sphere() const;
 
+        // attribute layout of Vertex
+        static VertexAttributeLayout vertex_layout();
         static std::unique_ptr<Mesh> create_cube();    
+        /**
+         * @brief one degenerate triangle at the origin, draws nothing until it is replaced
+         */
+        static std::unique_ptr<Mesh> create_placeholder();
     };
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include "bounds.hpp"
+#include "io.hpp"
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+#include "vertex.hpp"
+#include "vertex_attributes.hpp"
+
+namespace yazpgp
+{
+    namespace io
+    {
+        // relative to the working directory, next to the copied assets
+        constexpr const char* MESH_CACHE_DIRECTORY = "cache/meshes";
+
+        /**
+         * @brief final vertex and index data ready for glBufferData
+         *
+         * The spans point into the mapped cache file, or into the imported data when the
+         * cache could not be written. Moving the blob keeps them valid.
+         */
+        struct MeshBlob
+        {
+            // quantized, interleaved as layout describes
+            std::span<const std::byte> vertices;
+            VertexAttributeLayout layout;
+            // 16-bit when there are fewer than 65536 vertices
+            IndexSpan indices;
+            std::span<const SubMeshRange> submeshes;
+            // finest first, see Mesh::lods
+            std::span<const MeshLod> lods;
+            std::span<const Meshlet> meshlets;
+            AABB bounds;
+            BoundingSphere bounding_sphere;
+
+            std::unique_ptr<MappedFile> file;
+            std::unique_ptr<MeshData> imported;
+            std::vector<uint16_t> short_indices;
+            std::vector<std::byte> quantized_vertices;
+        };
+
+        /**
+         * @brief maps the cached mesh of the file, imports it with Assimp and writes the cache on a miss
+         *
+         * Cache files are keyed by a hash of the source file and MESH_IMPORT_FLAGS, an edited source
+         * or changed import flags miss and are imported again. Safe to call from any thread.
+         */
+        std::optional<MeshBlob> read_cached_mesh(const std::string& path, const std::string& cache_directory = MESH_CACHE_DIRECTORY);
+    }
+}
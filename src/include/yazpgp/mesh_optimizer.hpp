@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace yazpgp
+{
+    // FIFO post-transform cache size the optimizations and the reported ACMR assume
+    constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+    /**
+     * @brief average cache miss ratio, vertex shader invocations per triangle with a FIFO cache
+     *
+     * 0.5 is the ideal for a large regular grid, 3 means no vertex is ever reused.
+     */
+    float average_cache_miss_ratio(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size = VERTEX_CACHE_SIZE);
+
+    /**
+     * @brief maps every vertex to the first byte identical one, unique vertices get consecutive ids
+     *
+     * @return number of unique vertices
+     */
+    size_t weld_vertices(const void* vertices, size_t vertex_count, size_t stride_bytes, std::vector<uint32_t>& remap);
+
+    /**
+     * @brief Tipsify, reorders triangles so their vertices are reused while still in the post-transform cache
+     *
+     * @param clusters receives the first triangle of every run that had to restart after a cache flush
+     */
+    void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count, std::vector<uint32_t>& clusters, uint32_t cache_size = VERTEX_CACHE_SIZE);
+
+    /**
+     * @brief splits the clusters of optimize_vertex_cache further and draws outward facing ones first
+     *
+     * Clusters are sorted by how much they face away from the mesh center, which approximates a front
+     * to back order from most view directions without touching the order inside a cluster.
+     * @param positions first three floats of every vertex
+     * @param threshold ACMR a cluster may lose to splitting, 1.05 allows 5% more cache misses
+     */
+    void optimize_overdraw(
+        std::span<uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        const std::vector<uint32_t>& clusters,
+        float threshold = 1.05f,
+        uint32_t cache_size = VERTEX_CACHE_SIZE
+    );
+
+    constexpr uint32_t UNUSED_VERTEX = ~0u;
+
+    /**
+     * @brief renumbers vertices in the order the indices first use them, unused vertices are dropped
+     *
+     * @param remap receives the new id of every vertex, UNUSED_VERTEX for dropped ones
+     * @return number of used vertices
+     */
+    size_t optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count, std::vector<uint32_t>& remap);
+
+    /**
+     * @brief moves every vertex to its remapped position, ones mapped to UNUSED_VERTEX are dropped
+     *
+     * Several vertices may map to the same position, any of them ends up there.
+     */
+    void remap_vertices(const void* source, size_t vertex_count, size_t stride_bytes, const std::vector<uint32_t>& remap, void* destination);
+
+    struct MeshOptimizationStats
+    {
+        size_t vertices_before;
+        size_t vertices_after;
+        float acmr_before;
+        float acmr_after;
+    };
+
+    /**
+     * @brief welds, optimizes for the vertex cache, for overdraw and for vertex fetch, in that order
+     *
+     * @param vertices interleaved with position first, rewritten in place, only the first vertices_after stay used
+     */
+    MeshOptimizationStats optimize_mesh(std::span<std::byte> vertices, size_t stride_bytes, std::vector<uint32_t>& indices);
+
+    /**
+     * @brief quadric error metric edge collapses, Garland and Heckbert, into the existing vertices
+     *
+     * Vertices on open edges, mesh borders and attribute seams alike, never move, so submeshes and
+     * texture seams keep their outline. Collapses that would flip a triangle are skipped.
+     * @param positions first three floats of every vertex
+     * @param target_index_count stops once the triangles fit
+     * @param target_error stops before a collapse moves the surface further than this, in mesh units
+     * @param result_error receives the largest error of the performed collapses, in mesh units
+     * @return indices into the same vertices, the input when nothing could be collapsed
+     */
+    std::vector<uint32_t> simplify_mesh(
+        std::span<const uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        size_t target_index_count,
+        float target_error,
+        float* result_error = nullptr
+    );
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace yazpgp
+{
+    constexpr size_t MAX_MESHLET_VERTICES = 64;
+    constexpr size_t MAX_MESHLET_TRIANGLES = 124;
+
+    /**
+     * @brief few adjacent triangles of a mesh, culled as a whole against the frustum and by their facing
+     */
+    struct Meshlet
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        glm::vec3 center;
+        float radius;
+        // every triangle faces away from a camera inside the cone behind the apex, see faces_away
+        glm::vec3 cone_apex;
+        glm::vec3 cone_axis;
+        // sine of the cone half angle, above 1 when the normals spread too far for a cone
+        float cone_cutoff;
+
+        /**
+         * @brief true when the camera sees only back faces, so none of the triangles can be visible
+         *
+         * @param camera_position in mesh space, the test is exact for any model matrix keeping the orientation
+         */
+        bool faces_away(const glm::vec3& camera_position) const
+        {
+            const glm::vec3 view = cone_apex - camera_position;
+            const float distance = glm::length(view);
+            return distance > 0.0f and glm::dot(view, cone_axis) >= cone_cutoff * distance;
+        }
+    };
+
+    /**
+     * @brief splits the triangles in their order into runs with at most max_vertices distinct vertices
+     *
+     * Triangles are not reordered, index buffers optimized for the vertex cache already keep
+     * neighbouring triangles together, so the runs stay compact.
+     * @param positions first three floats of every vertex
+     * @return meshlets with first_index relative to the start of indices
+     */
+    std::vector<Meshlet> build_meshlets(
+        std::span<const uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        size_t max_vertices = MAX_MESHLET_VERTICES,
+        size_t max_triangles = MAX_MESHLET_TRIANGLES
+    );
+}
@@ -16,10 +16,13 @@ namespace yazpgp
             float specular_shininess = 32.0f
         );
         
-        virtual void use(const Shader& shader) override;
+        virtual MaterialParameters parameters() const override;
         virtual ~PhongBlinnMaterial() = default;
         virtual Material::Kind kind() const override;
 
+        /**
+         * @brief the same instance on every call, editing it changes every entity using it
+         */
         static std::shared_ptr<PhongBlinnMaterial> default_material();
         static std::shared_ptr<PhongBlinnMaterial> create_shared(
             const glm::vec3& ambient_color,
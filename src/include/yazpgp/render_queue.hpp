@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace yazpgp
+{
+    class Shader;
+    class Mesh;
+    class Texture;
+    struct RenderHandles;
+
+    /**
+     * @brief last bound GL objects, consecutive draws skip binds that would not change anything
+     */
+    struct RenderState
+    {
+        constexpr static size_t MAX_TEXTURE_SLOTS = 32;
+
+        const Shader* shader = nullptr;
+        GLuint vertex_array = 0;
+        std::array<const Texture*, MAX_TEXTURE_SLOTS> textures = {};
+        // draws go into the G-buffer, shaders are replaced by their G-buffer variant
+        bool gbuffer_pass = false;
+
+        size_t program_binds = 0;
+        size_t vao_binds = 0;
+        size_t texture_binds = 0;
+
+        bool bind_shader(const Shader* next);
+        bool bind_mesh(const Mesh* next);
+        bool bind_vertex_array(GLuint next);
+        bool bind_texture(size_t slot, const Texture* next);
+    };
+
+    /**
+     * @brief draw list sorted by 64-bit keys, draws sharing GL state end up next to each other
+     *
+     * Key layout from the most significant bit: shader (12), texture set (20), mesh (16), LOD (3), view depth (13).
+     * Draws sharing shader and textures are adjacent, so they can go out as one multi draw over different meshes.
+     * Materials are not part of the key, draws select them from the MaterialBlock per instance.
+     * Within the same state draws go front to back for early depth rejection.
+     * Ids are the EntityStorage handles and saturate, which only makes the grouping worse, never wrong.
+     */
+    class RenderQueue
+    {
+    public:
+        struct DrawItem
+        {
+            uint64_t key;
+            uint32_t entity_index;
+            // level of the mesh, draws of different levels are not batched
+            uint32_t lod;
+        };
+
+        void begin(const glm::mat4& view_matrix, const glm::mat4& projection_matrix);
+        /**
+         * @param center world space center of the entity bounds, orders draws by view depth
+         */
+        void push(const RenderHandles& handles, const glm::vec3& center, uint32_t entity_index, uint32_t lod = 0);
+
+        /**
+         * @brief LSD radix sort on the keys, bytes equal across all keys are skipped
+         */
+        void sort();
+
+        const std::vector<DrawItem>& items() const;
+        size_t size() const;
+
+    private:
+        std::vector<DrawItem> m_items;
+        std::vector<DrawItem> m_scratch;
+
+        glm::vec4 m_view_depth_row = glm::vec4(0.0f);
+        float m_near = 0.1f;
+        float m_inverse_log_depth_range = 1.0f;
+
+        uint16_t quantize_depth(const glm::vec3& world_position) const;
+    };
+}
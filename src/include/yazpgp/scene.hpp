@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
-#include "renderable_entity.hpp"
+#include "entity_storage.hpp"
+#include "transform.hpp"
 #include "camera.hpp"
 #include "input_manager.hpp"
 #include "lights/light.hpp"
@@ -8,9 +9,28 @@
 #include "material.hpp"
 #include "debug/debug_ui_def.hpp"
 #include "event_distributor.hpp"
+#include "frustum.hpp"
+#include "bvh.hpp"
+#include "render_queue.hpp"
+#include "entity_data.hpp"
+#include "stream_buffer.hpp"
+#include "geometry_pool.hpp"
+#include "light_buffer.hpp"
+#include "material_registry.hpp"
+#include "uniform_buffer.hpp"
+#include "frame_uniforms.hpp"
+#include "gbuffer.hpp"
+#include "transform_hierarchy.hpp"
+#include "transform_store.hpp"
+#include "animation.hpp"
+#include "job_system.hpp"
+#include <optional>
 
 namespace yazpgp
 {
+    /**
+     * @brief entities stored as components, see EntityStorage, TransformStore and Animator
+     */
     class Scene
     {
     public:
@@ -22,37 +42,103 @@ namespace yazpgp
             std::vector<std::shared_ptr<Texture>> textures = {};
             Transform transform = Transform::default_transform();
             std::shared_ptr<Material> material = nullptr;
-            RenderableEntity::TransformModifier transform_modifier = [](const glm::mat4& m) { return m; };
+            // sampled from the scene time on top of the transform
+            Animation animation = {};
+            // index of an entity added earlier, transform and animation are then relative to it
+            std::optional<size_t> parent = std::nullopt;
         };
 
-        enum AddEntityOptions
+        struct RenderStats
         {
-            None = 1 << 0,
-            PassCameraPostitionToShader = 1 << 1, 
-            PassLightToShader = 1 << 2
+            size_t drawn = 0;
+            size_t culled = 0;
+            // entities on the frustum boundary that needed the exact sphere test
+            size_t sphere_tests = 0;
+            size_t program_binds = 0;
+            size_t vao_binds = 0;
+            size_t texture_binds = 0;
+            size_t draw_calls = 0;
+            // commands submitted through glMultiDrawElementsIndirect
+            size_t indirect_commands = 0;
+            // entities written to the EntityBlock, only moved entities are rewritten
+            size_t entity_uploads = 0;
+            // draw calls into the G-buffer, the screen space lighting pass is one more draw call
+            size_t gbuffer_draw_calls = 0;
+            // of the selected mesh LODs over all instances
+            size_t triangles = 0;
+            // entities drawn with a coarser level than the finest one
+            size_t reduced_lods = 0;
+            // meshlets of entities drawn cluster by cluster, see set_meshlet_culling
+            size_t meshlets_drawn = 0;
+            size_t meshlets_culled = 0;
         };
 
-        
+        struct UpdateStats
+        {
+            // entities whose world matrix was recomputed, moved ones and their descendants
+            size_t transform_updates = 0;
+            size_t animated_entities = 0;
+        };
+
+        // stencil value of entities drawn in a batch, pick() finds them through the spatial index
+        constexpr static uint32_t STENCIL_BATCHED = 0xFF;
 
         Scene();
-        // Scene(std::vector<std::unique_ptr<RenderableEntity>> entities);
-        // Scene(const std::vector<SceneRenderableEntity>& entities);
         ~Scene() = default;
         Scene(const Scene&) = delete;
         Scene& operator=(const Scene&) = delete;
         Scene(Scene&&) = default;
         Scene& operator=(Scene&&) = default;
 
-        Scene& add_entity(std::unique_ptr<RenderableEntity> entity);
-        Scene& add_entity(const SceneRenderableEntity& entity, AddEntityOptions options = AddEntityOptions::None);
+        Scene& add_entity(const SceneRenderableEntity& entity);
         Scene& add_light(const PointLight& light);
         Scene& add_light(const SpotLight& light);
         Scene& add_light(const DirectionalLight& light);
         Scene& set_skybox(std::shared_ptr<Skybox> skybox);
         Scene& lock_spotlights_to_camera(size_t index = 0);
-
-        auto begin() { return m_entities.begin(); }
-        auto end() { return m_entities.end(); }
+        Scene& set_frustum_culling(bool enabled);
+        /**
+         * @brief runs the per entity update stages and spatial index builds as chunked jobs
+         *
+         * The scene does not own the job system, nullptr runs everything on the calling thread.
+         */
+        Scene& set_job_system(JobSystem* job_system);
+        /**
+         * @brief submits draws sharing shader and textures as one glMultiDrawElementsIndirect over the geometry pool
+         */
+        Scene& set_multi_draw_indirect(bool enabled);
+        /**
+         * @brief draws entities whose shader has a G-buffer variant into a G-buffer and lights them in one screen space pass
+         *
+         * Everything else, including the skybox, stays forward rendered on top of the deferred depth.
+         * Passing nullptr goes back to forward rendering of every entity.
+         */
+        Scene& set_deferred_shading(std::shared_ptr<Shader> lighting_shader);
+        /**
+         * @brief entities are drawn with the coarsest mesh LOD whose error stays below this many pixels
+         *
+         * 0 always draws the finest level.
+         */
+        Scene& set_lod_pixel_error(float pixels);
+        /**
+         * @brief draws large meshes only with their meshlets that are in the frustum and not facing away
+         *
+         * Applies to entities drawn on their own with the finest LOD, instanced draws stay whole.
+         */
+        Scene& set_meshlet_culling(bool enabled);
+        Scene& remove_entity(size_t index);
+        /**
+         * @brief replaces the animation of the entity, an empty one stops animating it
+         */
+        Scene& set_animation(size_t index, const Animation& animation);
+        /**
+         * @brief the world matrix is composed on the next update, only moved entities are recomposed
+         */
+        Scene& set_transform(size_t index, const Transform& transform);
+        /**
+         * @brief drops the spatial index, it is rebuilt with binned SAH on the next update
+         */
+        Scene& rebuild_spatial_index();
 
         void render(const glm::mat4& projection_matrix) const;
         void update(const InputManager& input_manager, double delta_time);
@@ -60,10 +146,27 @@ namespace yazpgp
         Scene& invoke_distributors();
 
         Camera& camera();
-        std::vector<std::unique_ptr<RenderableEntity>>& entities();
+        size_t entity_count() const;
+        Transform transform(size_t index) const;
+        const RenderStats& render_stats() const;
+        const UpdateStats& update_stats() const;
+        const TransformHierarchy& transform_hierarchy() const;
+        /**
+         * @brief BVH over world AABBs of entities, user data of each proxy is the entity index
+         */
+        const Bvh& spatial_index() const;
+
+        /**
+         * @brief entity under the cursor
+         *
+         * @param stencil_value stencil buffer value under the cursor
+         * @param world_position unprojected depth buffer value under the cursor
+         * @return entity index
+         */
+        std::optional<size_t> pick(uint32_t stencil_value, const glm::vec3& world_position) const;
     private:
         Camera m_camera;
-        std::vector<std::unique_ptr<RenderableEntity>> m_entities;
+        EntityStorage m_entities;
         std::unique_ptr<std::vector<PointLight>> m_point_lights;
         std::unique_ptr<std::vector<SpotLight>> m_spot_lights;
         std::unique_ptr<std::vector<DirectionalLight>> m_directional_lights;
@@ -73,19 +176,82 @@ namespace yazpgp
         std::unique_ptr<EventDistributor<DirectionalLight>> m_directional_light_event_distributor;
         std::shared_ptr<Skybox> m_skybox;
 
-        struct LightCountData
+        bool m_frustum_culling = true;
+        float m_lod_pixel_error = 1.0f;
+        // LOD every entity was drawn with last, the start for the hysteresis of the next selection
+        mutable std::vector<uint8_t> m_entity_lods;
+        JobSystem* m_job_system = nullptr;
+        mutable RenderStats m_render_stats;
+        UpdateStats m_update_stats;
+        mutable SphereBatch m_cull_spheres;
+        mutable std::vector<uint8_t> m_cull_visibility;
+        mutable std::vector<uint32_t> m_visible_inside;
+        mutable std::vector<uint32_t> m_visible_intersecting;
+        mutable RenderQueue m_render_queue;
+
+        struct DrawRun
         {
-            size_t point_light_count = 0;
-            size_t spot_light_count = 0;
-            size_t directional_light_count = 0;
+            uint32_t first;
+            uint32_t count;
+            // drawn with the visible meshlets only, their commands follow the run slots in the indirect buffer
+            bool meshlet_culled = false;
+            uint32_t first_meshlet_command = 0;
+            uint32_t meshlet_command_count = 0;
         };
 
-        std::unique_ptr<EventDistributor<LightCountData>> m_light_count_event_distributor;
+        bool m_multi_draw_indirect = true;
+        bool m_deferred_shading = false;
+        std::shared_ptr<Shader> m_deferred_lighting_shader;
+        mutable std::vector<DrawRun> m_draw_runs;
+        bool m_meshlet_culling = true;
+        // indices into Mesh::meshlets, every meshlet culled run owns a range
+        mutable std::vector<uint32_t> m_visible_meshlets;
+        mutable SphereBatch m_meshlet_spheres;
+        mutable std::vector<uint8_t> m_meshlet_visibility;
+        // first command of the visible meshlets in the indirect buffer region
+        mutable size_t m_meshlet_command_base = 0;
+        // frames left until every region of the entity buffer holds the current data of the entity
+        mutable std::vector<uint8_t> m_entity_upload_frames;
+        mutable size_t m_material_upload_count = 0;
 
-    };
+        // node i belongs to entity i, parents are always earlier entities
+        TransformHierarchy m_transform_hierarchy;
+        // entry i holds the Transform of entity i
+        TransformStore m_transform_store;
+        Animator m_animator;
+        std::vector<glm::mat4> m_animated_local_matrices;
+        std::vector<glm::mat4> m_moved_model_matrices;
+        std::vector<glm::mat3> m_moved_normal_matrices;
+        std::vector<std::shared_ptr<Mesh>> m_replaced_meshes;
+        std::vector<uint32_t> m_remeshed_entities;
+
+        Bvh m_bvh;
+        // m_bvh_proxies[i] belongs to entity i
+        std::vector<Bvh::ProxyId> m_bvh_proxies;
+
+        void update_transforms();
+        void update_replaced_meshes();
+        void update_spatial_index(const std::vector<uint32_t>& moved_entities);
+        void upload_entity_data() const;
+        uint32_t select_lod(uint32_t entity, const glm::mat4& projection_matrix, float viewport_height) const;
+        void render_runs(size_t first_run, size_t end_run, bool gbuffer_pass) const;
+        void render_direct(RenderState& state, size_t first_run, size_t end_run) const;
+        void render_indirect(RenderState& state, size_t first_run, size_t end_run) const;
+        void cull_meshlets(const Frustum* frustum) const;
+        void render_meshlets(RenderState& state, const DrawRun& run) const;
+        void render_deferred_lighting() const;
+        uint32_t stencil_of(uint32_t first, uint32_t count) const;
 
-    constexpr enum Scene::AddEntityOptions operator|(Scene::AddEntityOptions lhs, Scene::AddEntityOptions rhs)
-    {     
-        return static_cast<Scene::AddEntityOptions>(static_cast<int>(lhs) | static_cast<int>(rhs));
-    }
+        std::unique_ptr<LightBuffer> m_light_buffer;
+        std::unique_ptr<UniformBuffer> m_frame_buffer;
+        std::unique_ptr<MaterialRegistry> m_material_registry;
+        std::unique_ptr<StreamBuffer> m_entity_buffer;
+        std::unique_ptr<StreamBuffer> m_draw_entity_buffer;
+        std::unique_ptr<StreamBuffer> m_indirect_buffer;
+        std::unique_ptr<GeometryPool> m_geometry_pool;
+        std::unique_ptr<GBuffer> m_gbuffer;
+        // seconds of updates, shaders read it from the FrameBlock
+        double m_time = 0.0;
+
+    };
 } 
\ No newline at end of file
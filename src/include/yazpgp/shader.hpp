@@ -1,32 +1,125 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 namespace yazpgp
 {
-    class Shader 
+    class Shader;
+
+    template<typename T> constexpr GLenum uniform_gl_type = 0;
+    template<> constexpr GLenum uniform_gl_type<glm::mat4> = GL_FLOAT_MAT4;
+    template<> constexpr GLenum uniform_gl_type<glm::mat3> = GL_FLOAT_MAT3;
+    template<> constexpr GLenum uniform_gl_type<glm::vec3> = GL_FLOAT_VEC3;
+    template<> constexpr GLenum uniform_gl_type<glm::vec4> = GL_FLOAT_VEC4;
+    template<> constexpr GLenum uniform_gl_type<float> = GL_FLOAT;
+    template<> constexpr GLenum uniform_gl_type<int> = GL_INT;
+
+    /**
+     * @brief uniform with location resolved once, setting an unchanged value is a no-op
+     *
+     * Handles of uniforms missing in the program are invalid and setting them does nothing,
+     * same as glUniform* with location -1.
+     */
+    template<typename T>
+    class UniformHandle
+    {
+        const Shader* m_shader = nullptr;
+        int32_t m_slot = -1;
+
+    public:
+        UniformHandle() = default;
+        UniformHandle(const Shader* shader, int32_t slot) : m_shader(shader), m_slot(slot) {}
+
+        bool is_valid() const { return m_slot >= 0; }
+        void set(const T& value) const;
+    };
+
+    class Shader
     {
         using ShaderProgramId = GLuint;
-        
+
+        struct UniformSlot
+        {
+            GLint location;
+            GLenum type;
+            bool initialized = false;
+            // last value uploaded to the program
+            std::array<std::byte, sizeof(glm::mat4)> shadow = {};
+        };
+
+        struct StringHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+        };
+
         ShaderProgramId m_program;
+        std::shared_ptr<Shader> m_gbuffer_variant;
+        mutable std::vector<UniformSlot> m_slots;
+        std::unordered_map<std::string, int32_t, StringHash, std::equal_to<>> m_slot_by_name;
+
+        void reflect_uniforms();
+        // uniform and storage blocks to the points in uniform_block_bindings.hpp
+        void bind_blocks();
+        int32_t find_slot(std::string_view name) const;
+        int32_t resolve(std::string_view name, GLenum type) const;
+        bool shadow_changed(int32_t slot, const void* value, size_t size_bytes) const;
+
+        void upload(int32_t slot, const glm::mat4& value) const;
+        void upload(int32_t slot, const glm::mat3& value) const;
+        void upload(int32_t slot, const glm::vec3& value) const;
+        void upload(int32_t slot, const glm::vec4& value) const;
+        void upload(int32_t slot, const float value) const;
+        void upload(int32_t slot, const int value) const;
+
+        template<typename T>
+        friend class UniformHandle;
+
     public:
-        Shader(ShaderProgramId linked_program) : m_program(linked_program){}
+        Shader(ShaderProgramId linked_program);
         ~Shader();
         static std::shared_ptr<Shader> create_shader(const std::string& vertex_shader, const std::string& fragment_shader);
         static std::shared_ptr<Shader> create_default_shader(float r = 1.f, float g = 0.f, float b = 0.f, float a = 1.f);
         void use() const;
 
-        void set_uniform(const std::string& name, const glm::mat4& value) const;
-        void set_uniform(const std::string& name, const glm::mat3& value) const;
-        void set_uniform(const std::string& name, const glm::vec3& value) const;
-        void set_uniform(const std::string& name, const glm::vec4& value) const;
-        void set_uniform(const std::string& name, const float value) const;
-        void set_uniform(const std::string& name, const int value) const;
+        template<typename T>
+        UniformHandle<T> uniform(std::string_view name) const
+        {
+            return UniformHandle<T>(this, resolve(name, uniform_gl_type<T>));
+        }
+
+        bool has_uniform(std::string_view name) const;
+
+        /**
+         * @brief program drawing the same geometry into the G-buffer, shaders without one are always drawn forward
+         */
+        void set_gbuffer_variant(std::shared_ptr<Shader> variant);
+        const std::shared_ptr<Shader>& gbuffer_variant() const;
+
+        void set_uniform(std::string_view name, const glm::mat4& value) const;
+        void set_uniform(std::string_view name, const glm::mat3& value) const;
+        void set_uniform(std::string_view name, const glm::vec3& value) const;
+        void set_uniform(std::string_view name, const glm::vec4& value) const;
+        void set_uniform(std::string_view name, const float value) const;
+        void set_uniform(std::string_view name, const int value) const;
 
         static void unuse();
 
     };
+
+    template<typename T>
+    void UniformHandle<T>::set(const T& value) const
+    {
+        if (m_shader)
+            m_shader->upload(m_slot, value);
+    }
 }
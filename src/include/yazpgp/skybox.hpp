@@ -12,6 +12,7 @@ namespace yazpgp
         std::shared_ptr<CubeMap> m_cubemap;
         std::shared_ptr<Shader> m_shader;       
         std::unique_ptr<Mesh> m_cube_mesh;
+        UniformHandle<glm::mat4> m_view_projection_uniform;
 
     public:
         Skybox(std::shared_ptr<CubeMap> cubemap, std::shared_ptr<Shader> shader);
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace yazpgp
+{
+    /**
+     * @brief component of only some entities, values packed densely with an entity to slot lookup
+     *
+     * Entity indices are positions in the scene, remove_entity() shifts every later index down by one
+     * like the scene does with its dense component arrays.
+     */
+    template<class T>
+    class SparseSet
+    {
+    public:
+        constexpr static uint32_t NONE = UINT32_MAX;
+
+        // grows the lookup by one entity without a value
+        void push_entity()
+        {
+            m_sparse.push_back(NONE);
+        }
+
+        void set(uint32_t entity, const T& value)
+        {
+            if (entity >= m_sparse.size())
+                m_sparse.resize(entity + 1, NONE);
+
+            if (m_sparse[entity] != NONE)
+            {
+                m_values[m_sparse[entity]] = value;
+                return;
+            }
+
+            m_sparse[entity] = static_cast<uint32_t>(m_values.size());
+            m_values.push_back(value);
+            m_entities.push_back(entity);
+        }
+
+        // swaps the last value into the hole, dense order is not entity order
+        void erase(uint32_t entity)
+        {
+            if (not contains(entity))
+                return;
+
+            const uint32_t slot = m_sparse[entity];
+            const uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+            if (slot != last)
+            {
+                m_values[slot] = std::move(m_values[last]);
+                m_entities[slot] = m_entities[last];
+                m_sparse[m_entities[slot]] = slot;
+            }
+            m_values.pop_back();
+            m_entities.pop_back();
+            m_sparse[entity] = NONE;
+        }
+
+        void remove_entity(uint32_t entity)
+        {
+            if (entity >= m_sparse.size())
+                return;
+
+            erase(entity);
+            m_sparse.erase(m_sparse.begin() + entity);
+            for (auto& other : m_entities)
+            {
+                if (other > entity)
+                    other--;
+            }
+        }
+
+        void clear()
+        {
+            m_sparse.clear();
+            m_values.clear();
+            m_entities.clear();
+        }
+
+        bool contains(uint32_t entity) const
+        {
+            return entity < m_sparse.size() and m_sparse[entity] != NONE;
+        }
+
+        const T& get(uint32_t entity) const
+        {
+            return m_values[m_sparse[entity]];
+        }
+
+        // entity count, with or without a value
+        size_t size() const { return m_sparse.size(); }
+        const std::vector<T>& values() const { return m_values; }
+        // entity of each value
+        const std::vector<uint32_t>& entities() const { return m_entities; }
+
+    private:
+        std::vector<uint32_t> m_sparse;
+        std::vector<T> m_values;
+        std::vector<uint32_t> m_entities;
+    };
+}
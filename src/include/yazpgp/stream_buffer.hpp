@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <GL/glew.h>
+
+namespace yazpgp
+{
+    /**
+     * @brief persistently mapped buffer split into per frame regions, written by the CPU without any map calls
+     *
+     * The CPU writes region N while the GPU may still read regions N-1 and N-2.
+     * Every region is fenced after its frame was submitted and waited for before it is reused.
+     * Regions keep their content, so data written once has to be written to every region.
+     */
+    class StreamBuffer
+    {
+    public:
+        constexpr static size_t REGION_COUNT = 3;
+
+        StreamBuffer() = default;
+        ~StreamBuffer();
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        /**
+         * @brief makes the next region writable, grows the storage when the region is smaller than requested
+         *
+         * @return true when the storage was recreated and the content of all regions is lost
+         */
+        bool begin_frame(size_t region_size_bytes);
+
+        /**
+         * @brief fences the current region, call after the last command reading it was issued
+         */
+        void end_frame();
+
+        std::byte* data() const;
+        // offset of the current region in the buffer
+        size_t offset() const;
+        GLuint id() const;
+
+        void bind_range(GLenum target, GLuint index) const;
+
+    private:
+        GLuint m_buffer = 0;
+        std::byte* m_mapped = nullptr;
+        size_t m_region_size = 0;
+        size_t m_region = 0;
+        std::array<GLsync, REGION_COUNT> m_fences = {};
+
+        void allocate(size_t region_size_bytes);
+        void wait(size_t region);
+    };
+}
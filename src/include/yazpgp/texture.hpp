@@ -5,6 +5,16 @@
 
 namespace yazpgp
 {
+    /**
+     * @brief one mip level of one face, rows padded to 4 bytes, the default GL_UNPACK_ALIGNMENT
+     */
+    struct TextureLevel
+    {
+        const char* bytes;
+        int32_t width;
+        int32_t height;
+    };
+
     class Texture
     {
     public:
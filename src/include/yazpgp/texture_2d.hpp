@@ -1,12 +1,30 @@
 #pragma once
 #include "texture.hpp"
+#include <span>
 namespace yazpgp
 {
     class Texture2D: public Texture
     {
+        // glTexStorage2D cannot be respecified, the next upload needs a new texture name
+        bool m_immutable = false;
+
+        void reset_immutable();
+
     public:
         Texture2D(const char* bytes, uint32_t width, uint32_t height, uint32_t channels);
+        Texture2D(GLenum internal_format, GLenum format, std::span<const TextureLevel> levels);
         ~Texture2D();
+
+        /**
+         * @brief replaces the image, the texture keeps its id so everything using it sees the new one
+         */
+        void upload(const char* bytes, uint32_t width, uint32_t height, uint32_t channels);
+        /**
+         * @brief replaces the image with immutable storage filled from a precomputed mip chain
+         *
+         * @param levels largest first, every level half the size of the previous one
+         */
+        void upload_levels(GLenum internal_format, GLenum format, std::span<const TextureLevel> levels);
         
         virtual void use(uint32_t texture_slot) const override;
     };
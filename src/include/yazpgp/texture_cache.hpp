@@ -0,0 +1,53 @@
+#pragma once
+#include <GL/glew.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+#include "texture.hpp"
+
+namespace yazpgp
+{
+    namespace io
+    {
+        // relative to the working directory, next to the copied assets
+        constexpr const char* TEXTURE_CACHE_DIRECTORY = "cache/textures";
+
+        /**
+         * @brief decoded, flipped and mipmapped texture in its final GL format, ready for glTexStorage2D
+         *
+         * Levels are face major, face * level_count + level. They point into the mapped cache file,
+         * or into bytes when the cache could not be written. Moving the texture keeps them valid.
+         */
+        struct CookedTexture
+        {
+            GLenum internal_format;
+            GLenum format;
+            uint32_t face_count;
+            uint32_t level_count;
+            std::vector<TextureLevel> levels;
+
+            std::unique_ptr<MappedFile> file;
+            std::vector<char> bytes;
+        };
+
+        /**
+         * @brief maps the cooked texture of an image, decodes and cooks it on a miss
+         *
+         * Rows are flipped to the bottom to top order glTexImage2D expects and the full mip chain is
+         * precomputed. Cache files are keyed by a hash of the source, an edited image is cooked again.
+         * Safe to call from any thread.
+         */
+        std::optional<CookedTexture> read_cooked_texture(const std::string& path, const std::string& cache_directory = TEXTURE_CACHE_DIRECTORY);
+
+        /**
+         * @brief cubemap version of read_cooked_texture, one RGB level per face like CubeMap::upload
+         *
+         * @param paths in order: right, left, top, bottom, front, back
+         */
+        std::optional<CookedTexture> read_cooked_cubemap(const std::array<std::string, 6>& paths, const std::string& cache_directory = TEXTURE_CACHE_DIRECTORY);
+    }
+}
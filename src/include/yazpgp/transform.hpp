@@ -3,8 +3,6 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <variant>
-#include <vector>
 
 namespace yazpgp
 {
@@ -68,128 +66,5 @@ namespace yazpgp
         {
             return Transform(*this).scale(scale);
         }
-
-        // usage looks like this:
-        // glm::mat4 output_mat = Transform::Mat4Compositor::Composite({
-        //     Transform::Mat4Compositor::Composite({
-        //         Transform::Mat4Compositor::Rotate({0, angle, 0}),
-        //         Transform::Mat4Compositor::Translate({0, 0, 8}),
-        //     }),
-        //     Transform::Mat4Compositor::Translate({0, 0, -8}),
-        // })(input_mat);
-
-        struct Mat4Compositor
-        {
-            struct TranslateData
-            {
-                glm::vec3 translation;
-            };
-            struct RotateData
-            {
-                glm::vec3 rotation;
-            };
-            struct ScaleData
-            {
-                glm::vec3 scale;
-            };
-
-            using Mat4Data = glm::mat4;
-            
-            struct CompositeData
-            {
-                std::vector<Mat4Compositor> compositor;
-            };
-
-            using CompositorVariant = std::variant<TranslateData, RotateData, ScaleData, CompositeData, Mat4Data>;
-            CompositorVariant compositor;
-
-            Mat4Compositor(const TranslateData &translate) : compositor(translate) {}
-            Mat4Compositor(const RotateData &rotate) : compositor(rotate) {}
-            Mat4Compositor(const ScaleData &scale) : compositor(scale) {}
-            Mat4Compositor(const CompositeData &composite) : compositor(composite) {}
-            Mat4Compositor(const Mat4Data &mat4 = glm::mat4(1.0f)) : compositor(mat4) {}
-
-            glm::mat4 operator()(const glm::mat4 &transform = glm::mat4(1.0f)) const
-            {
-                // auto c = transform.copy();
-                // return std::visit(CompositorVisitor{c}, compositor);
-                auto c = transform;
-                return std::visit(CompositorVisitor{c}, compositor);
-            }
-
-            glm::mat4 operator()(glm::mat4 &&transform) const
-            {
-                return std::visit(CompositorVisitor{transform}, compositor);
-            }
-
-            glm::mat4 compose(const glm::mat4 &transform = glm::mat4(1.0f)) const
-            {
-                return (*this)(transform);
-            }
-            struct CompositorVisitor
-            {
-                glm::mat4 &transform;
-                glm::mat4 operator()(const TranslateData &translate) const
-                {
-                    // return transform.translate(translate.translation);
-                    return glm::translate(transform, translate.translation);
-                }
-                glm::mat4 operator()(const RotateData &rotate) const
-                {
-                    // return transform.rotate(rotate.rotation);
-                    return glm::rotate(transform, glm::radians(rotate.rotation.x), {1, 0, 0}) *
-                           glm::rotate(transform, glm::radians(rotate.rotation.y), {0, 1, 0}) *
-                           glm::rotate(transform, glm::radians(rotate.rotation.z), {0, 0, 1});
-                }
-                glm::mat4 operator()(const ScaleData &scale) const
-                {
-                    // return transform.scale(scale.scale);
-                    return glm::scale(transform, scale.scale);
-                }
-
-                glm::mat4 operator()(const Mat4Data &mat4) const
-                {
-                    return mat4 * transform;
-                }
-
-                glm::mat4 operator()(const CompositeData &composite) const
-                {
-                    glm::mat4 result = transform;
-                    for (const auto &compositor : composite.compositor)
-                        result = compositor(result);
-                    return result;
-                }
-            };
-
-            static Mat4Compositor Translate(const glm::vec3 &translation)
-            {
-                return Mat4Compositor(TranslateData{translation});
-            }
-
-            static Mat4Compositor Rotate(const glm::vec3 &rotation)
-            {
-                return Mat4Compositor(RotateData{rotation});
-            }
-
-            static Mat4Compositor Scale(const glm::vec3 &scale)
-            {
-                return Mat4Compositor(ScaleData{scale});
-            }
-
-            static Mat4Compositor Composite(const std::vector<Mat4Compositor> &compositor)
-            {
-                return Mat4Compositor(CompositeData{compositor});
-            }
-
-            static Mat4Compositor Composite(std::vector<Mat4Compositor> &&compositor)
-            {
-                return Mat4Compositor(CompositeData{std::move(compositor)});
-            }
-
-            static Mat4Compositor Composite(std::initializer_list<Mat4Compositor> compositor)
-            {
-                return Mat4Compositor(CompositeData{compositor});
-            }
-        };
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace yazpgp
+{
+    /**
+     * @brief parent links with cached local and world matrices, one node per scene entity
+     *
+     * Parents always come before their children, so the node array itself is topologically ordered
+     * and one linear pass updates the world matrices. Only nodes whose local matrix changed
+     * and their descendants are recomputed.
+     */
+    class TransformHierarchy
+    {
+    public:
+        constexpr static uint32_t NO_PARENT = UINT32_MAX;
+
+        /**
+         * @brief appends a node, its world matrix is computed by the next update
+         *
+         * @param parent existing node or NO_PARENT
+         * @return index of the new node
+         */
+        uint32_t add(const glm::mat4& local_matrix, uint32_t parent = NO_PARENT);
+
+        /**
+         * @brief removes the node, its children move to its parent and every later node one index down
+         */
+        void remove(uint32_t node);
+        void clear();
+
+        /**
+         * @brief marks the node dirty when the matrix differs from the cached one
+         */
+        void set_local_matrix(uint32_t node, const glm::mat4& local_matrix);
+
+        /**
+         * @brief recomputes world matrices of dirty nodes and their descendants
+         *
+         * @return nodes with a new world matrix, in topological order
+         */
+        const std::vector<uint32_t>& update();
+
+        const glm::mat4& local_matrix(uint32_t node) const;
+        const glm::mat4& world_matrix(uint32_t node) const;
+        uint32_t parent(uint32_t node) const;
+        size_t size() const;
+
+    private:
+        std::vector<uint32_t> m_parents;
+        std::vector<glm::mat4> m_local_matrices;
+        std::vector<glm::mat4> m_world_matrices;
+        std::vector<uint8_t> m_dirty;
+        std::vector<uint32_t> m_updated;
+    };
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "transform.hpp"
+#include "job_system.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief position, rotation and scale of the scene entities in structure of arrays layout
+     *
+     * Entries follow the entity indices. Only entries whose Transform changed since the last update
+     * get their TRS matrix composed, in SIMD batches of TransformStore::LANES entries.
+     */
+    class TransformStore
+    {
+    public:
+        // entries composed by one SIMD batch, 8 with AVX2, 4 with SSE2, 1 without either
+        static const size_t LANES;
+
+        uint32_t add(const Transform& transform);
+        void remove(uint32_t index);
+        void clear();
+
+        /**
+         * @brief copies the transform, marks the entry dirty when any component differs
+         */
+        void set(uint32_t index, const Transform& transform);
+
+        /**
+         * @brief composes translation * rotation * scale of the dirty entries
+         *
+         * @param jobs composes chunks of batches in parallel, nullptr composes on the calling thread
+         * @return entries with a new model matrix, in ascending order
+         */
+        const std::vector<uint32_t>& update(JobSystem* jobs = nullptr);
+
+        // gathered back from the component arrays
+        Transform transform(uint32_t index) const;
+        const glm::mat4& model_matrix(uint32_t index) const;
+        size_t size() const;
+
+    private:
+        std::vector<float> m_position_x;
+        std::vector<float> m_position_y;
+        std::vector<float> m_position_z;
+        // euler angles in degrees, same convention as Transform
+        std::vector<float> m_rotation_x;
+        std::vector<float> m_rotation_y;
+        std::vector<float> m_rotation_z;
+        std::vector<float> m_scale_x;
+        std::vector<float> m_scale_y;
+        std::vector<float> m_scale_z;
+        std::vector<glm::mat4> m_model_matrices;
+        std::vector<uint8_t> m_dirty;
+        std::vector<uint32_t> m_updated;
+    };
+
+    /**
+     * @brief inverse transpose of the upper 3x3 of each model matrix, in SIMD batches
+     *
+     * Batches where every matrix has uniform scale skip the inverse, the normal matrix is then the
+     * rotation part divided by the squared scale.
+     */
+    void compute_normal_matrices(const glm::mat4* model_matrices, size_t count, glm::mat3* normal_matrices);
+}
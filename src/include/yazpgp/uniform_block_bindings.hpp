@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <string_view>
+#include <utility>
+#include <GL/glew.h>
+
+namespace yazpgp
+{
+    /**
+     * @brief fixed binding points of uniform blocks shared between shaders
+     *
+     * Shader binds every block found in this table when it is linked,
+     * owners of the buffers bind them to the same points with glBindBufferBase.
+     */
+    namespace UniformBlockBinding
+    {
+        constexpr GLuint LIGHTS = 0;
+        constexpr GLuint FRAME = 1;
+        constexpr GLuint MATERIALS = 2;
+
+        constexpr std::array<std::pair<std::string_view, GLuint>, 3> BLOCKS = {{
+            {"LightBlock", LIGHTS},
+            {"FrameBlock", FRAME},
+            {"MaterialBlock", MATERIALS},
+        }};
+    }
+
+    /**
+     * @brief fixed binding points of shader storage blocks, bound the same way as UniformBlockBinding
+     */
+    namespace StorageBlockBinding
+    {
+        constexpr GLuint ENTITIES = 0;
+        constexpr GLuint DRAW_ENTITIES = 1;
+        constexpr GLuint POINT_LIGHTS = 2;
+        constexpr GLuint SPOT_LIGHTS = 3;
+        constexpr GLuint LIGHT_CLUSTERS = 4;
+        constexpr GLuint LIGHT_INDICES = 5;
+
+        constexpr std::array<std::pair<std::string_view, GLuint>, 6> BLOCKS = {{
+            {"EntityBlock", ENTITIES},
+            {"DrawEntityBlock", DRAW_ENTITIES},
+            {"PointLightBlock", POINT_LIGHTS},
+            {"SpotLightBlock", SPOT_LIGHTS},
+            {"LightClusterBlock", LIGHT_CLUSTERS},
+            {"LightIndexBlock", LIGHT_INDICES},
+        }};
+    }
+}
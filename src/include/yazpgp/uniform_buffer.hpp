@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+
+namespace yazpgp
+{
+    /**
+     * @brief fixed size uniform buffer bound to one of the UniformBlockBinding points
+     */
+    class UniformBuffer
+    {
+        GLuint m_buffer = 0;
+        GLuint m_binding;
+        size_t m_size_bytes;
+
+    public:
+        UniformBuffer(GLuint binding, size_t size_bytes);
+        ~UniformBuffer();
+        UniformBuffer(const UniformBuffer&) = delete;
+        UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+        /**
+         * @brief writes data at the offset, the GL buffer is created on the first upload
+         */
+        void upload(const void* data, size_t size_bytes, size_t offset_bytes = 0);
+        void bind() const;
+    };
+}
@@ -3,21 +3,40 @@
 #include <GL/glew.h>
 namespace yazpgp
 {
+    /**
+     * @brief one attribute of interleaved vertices, shaders always read it as floats
+     *
+     * Packed GL_INT_2_10_10_10_REV and GL_UNSIGNED_INT_2_10_10_10_REV need size 4.
+     * Normalized integers map to [0, 1] or [-1, 1], others keep their integer value.
+     */
     struct VertexAttribute
     {
         GLint size;
         GLenum type;
         GLboolean normalized;
+
+        bool operator==(const VertexAttribute&) const = default;
     };
 
     class VertexAttributeLayout
     {
         std::vector<VertexAttribute> m_attributes;
-        size_t m_stride;
-    
+        std::vector<size_t> m_offsets;
+        size_t m_stride = 0;
+
     public:
+        VertexAttributeLayout() = default;
+        /**
+         * @brief attributes at locations 0, 1, ... every one starts 4 byte aligned
+         */
         VertexAttributeLayout(const std::vector<VertexAttribute>& attributes);
+        // sets the attributes of the bound vertex array to the bound GL_ARRAY_BUFFER
         void use() const;
+        // sets the attributes of vertex_array to read from the buffer bound at binding_index
+        void apply(GLuint vertex_array, GLuint binding_index) const;
         size_t get_stride() const;
+        const std::vector<VertexAttribute>& attributes() const;
+
+        bool operator==(const VertexAttributeLayout& other) const;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "bounds.hpp"
+#include "vertex.hpp"
+#include "vertex_attributes.hpp"
+
+namespace yazpgp
+{
+    /**
+     * @brief interleaved vertices in the smallest formats that keep the mesh intact
+     *
+     * Attributes stay at the locations of Mesh::vertex_layout, shaders read them unchanged.
+     */
+    struct QuantizedVertices
+    {
+        std::vector<std::byte> bytes;
+        VertexAttributeLayout layout;
+    };
+
+    /**
+     * @brief picks the attribute formats from the mesh bounds and packs the vertices into them
+     *
+     * Positions become half floats unless their precision at the largest coordinate falls below
+     * 1/1024 of the mesh size, normals and tangents are 10 bits per component, texture coordinates
+     * are 16-bit normalized in [0, 1], half floats when they tile a little and floats beyond.
+     * Typical meshes end up at 20 bytes per vertex instead of 44.
+     */
+    QuantizedVertices quantize_vertices(std::span<const Vertex> vertices, const AABB& bounds);
+
+    // round to nearest even, out of range values become infinity
+    uint16_t to_half_float(float value);
+    // GL_INT_2_10_10_10_REV with x in the lowest bits, components are clamped to [-1, 1]
+    uint32_t pack_snorm_10_10_10_2(float x, float y, float z, float w);
+}
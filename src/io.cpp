@@ -1,10 +1,20 @@
 #include "io.hpp"
 #include "logger.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_optimizer.hpp"
+#include "meshlet.hpp"
+#include "texture_cache.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <vector>
 #include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unordered_set>
+#include <cstring>
+#include <limits>
+#include <thread>
 #include <SDL2/SDL_image.h>
 
 
@@ -12,45 +22,150 @@ namespace yazpgp
 {
     namespace io
     {
-        std::shared_ptr<Mesh> load_mesh_from_file(const std::string& path)
+        const uint32_t MESH_IMPORT_FLAGS = aiProcess_Triangulate
+            | aiProcess_GenNormals
+            | aiProcess_JoinIdenticalVertices
+            | aiProcess_CalcTangentSpace;
+
+        namespace
+        {
+            /**
+             * @brief optimizes every submesh on its own, so submesh ranges stay contiguous
+             *
+             * @return totals over all submeshes, ACMR weighted by triangle count
+             */
+            MeshOptimizationStats optimize_submeshes(MeshData& data)
+            {
+                MeshData optimized;
+                optimized.vertices.reserve(data.vertices.size());
+                optimized.indices.reserve(data.indices.size());
+                optimized.submeshes.reserve(data.submeshes.size());
+
+                MeshOptimizationStats total{ .vertices_before = data.vertices.size(), .vertices_after = 0, .acmr_before = 0.0f, .acmr_after = 0.0f };
+                for (const auto& submesh : data.submeshes)
+                {
+                    const auto first_vertex = data.vertices.begin() + submesh.first_vertex;
+                    std::vector<Vertex> vertices(first_vertex, first_vertex + submesh.vertex_count);
+                    std::vector<uint32_t> indices(submesh.index_count);
+                    for (size_t i = 0; i < indices.size(); i++)
+                        indices[i] = data.indices[submesh.first_index + i] - submesh.first_vertex;
+
+                    const auto stats = optimize_mesh(std::as_writable_bytes(std::span(vertices)), sizeof(Vertex), indices);
+                    vertices.resize(stats.vertices_after);
+
+                    const SubMeshRange range{
+                        .first_index = static_cast<uint32_t>(optimized.indices.size()),
+                        .index_count = static_cast<uint32_t>(indices.size()),
+                        .first_vertex = static_cast<uint32_t>(optimized.vertices.size()),
+                        .vertex_count = static_cast<uint32_t>(vertices.size())
+                    };
+                    optimized.vertices.insert(optimized.vertices.end(), vertices.begin(), vertices.end());
+                    for (const uint32_t index : indices)
+                        optimized.indices.push_back(range.first_vertex + index);
+                    optimized.submeshes.push_back(range);
+
+                    const float triangles = static_cast<float>(indices.size() / 3);
+                    total.acmr_before += stats.acmr_before * triangles;
+                    total.acmr_after += stats.acmr_after * triangles;
+                }
+
+                const float triangles = static_cast<float>(optimized.indices.size() / 3);
+                total.vertices_after = optimized.vertices.size();
+                total.acmr_before = triangles > 0.0f ? total.acmr_before / triangles : 0.0f;
+                total.acmr_after = triangles > 0.0f ? total.acmr_after / triangles : 0.0f;
+                data = std::move(optimized);
+                return total;
+            }
+
+            // a level is only worth it with at least this many triangles and this much fewer than the one before
+            constexpr size_t MIN_LOD_TRIANGLES = 64;
+            constexpr float MAX_LOD_TRIANGLE_RATIO = 0.8f;
+            // beyond this fraction of the bounding sphere radius simplification eats the silhouette
+            constexpr float MAX_LOD_ERROR = 0.1f;
+
+            /**
+             * @brief appends coarser levels of the whole mesh to the indices, each about half the one before
+             *
+             * Every level is simplified from the previous one, its error is the sum of the errors so far.
+             */
+            void build_lods(MeshData& data)
+            {
+                const uint32_t finest_count = static_cast<uint32_t>(data.indices.size());
+                data.lods = { MeshLod{ .first_index = 0, .index_count = finest_count, .error = 0.0f } };
+
+                const auto* positions = reinterpret_cast<const float*>(data.vertices.data());
+                const AABB bounds = AABB::from_vertices(positions, data.vertices.size(), sizeof(Vertex));
+                const float max_error = MAX_LOD_ERROR * BoundingSphere::from_vertices(positions, data.vertices.size(), sizeof(Vertex), bounds).radius;
+
+                std::vector<uint32_t> previous(data.indices.begin(), data.indices.end());
+                std::vector<uint32_t> clusters;
+                float error = 0.0f;
+                while (data.lods.size() < Mesh::MAX_LODS and previous.size() / 6 >= MIN_LOD_TRIANGLES)
+                {
+                    float lod_error = 0.0f;
+                    std::vector<uint32_t> lod = simplify_mesh(previous, positions, data.vertices.size(), sizeof(Vertex), previous.size() / 2, max_error - error, &lod_error);
+                    if (static_cast<float>(lod.size()) > static_cast<float>(previous.size()) * MAX_LOD_TRIANGLE_RATIO)
+                        break;
+
+                    error += lod_error;
+                    optimize_vertex_cache(lod, data.vertices.size(), clusters);
+                    data.lods.push_back(MeshLod{
+                        .first_index = static_cast<uint32_t>(data.indices.size()),
+                        .index_count = static_cast<uint32_t>(lod.size()),
+                        .error = error
+                    });
+                    data.indices.insert(data.indices.end(), lod.begin(), lod.end());
+                    previous = std::move(lod);
+                }
+            }
+        }
+
+        std::optional<MeshData> read_mesh_data(const std::string& path)
         {
             Assimp::Importer importer;
-            const aiScene* scene = importer.ReadFile(
-                path,
-                aiProcess_Triangulate 
-                    | aiProcess_GenNormals 
-                    | aiProcess_JoinIdenticalVertices
-                    | aiProcess_CalcTangentSpace
-            );
+            const aiScene* scene = importer.ReadFile(path, MESH_IMPORT_FLAGS);
 
             if (not scene)
             {
                 YAZPGP_LOG_ERROR("Failed to load mesh from file: %s", path.c_str());
                 YAZPGP_LOG_ERROR("Error: %s", importer.GetErrorString());
-                return nullptr;
+                return std::nullopt;
             }
             if (scene->mNumMeshes == 0)
             {
                 YAZPGP_LOG_ERROR("No meshes found in file: %s", path.c_str());
-                return nullptr;
+                return std::nullopt;
             }
 
-            std::vector<Vertex> vertex_data;
-            size_t estimated_vertex_data_size = 0;
+            size_t vertex_count = 0;
+            size_t index_count = 0;
             for (size_t i = 0; i < scene->mNumMeshes; i++)
-                estimated_vertex_data_size += scene->mMeshes[i]->mNumVertices;
-
-            
-            bool has_uvs = scene->mMeshes[0]->HasTextureCoords(0);
-            vertex_data.reserve(estimated_vertex_data_size);
+            {
+                vertex_count += scene->mMeshes[i]->mNumVertices;
+                index_count += scene->mMeshes[i]->mNumFaces * 3;
+            }
 
+            MeshData data;
+            data.vertices.reserve(vertex_count);
+            data.indices.reserve(index_count);
+            data.submeshes.reserve(scene->mNumMeshes);
 
             for (size_t i = 0; i < scene->mNumMeshes; i++)
             {
                 const aiMesh* mesh = scene->mMeshes[i];
+                // tangents are only calculated for meshes with texture coordinates
+                const bool has_uvs = mesh->HasTextureCoords(0);
+                const bool has_tangents = mesh->HasTangentsAndBitangents();
+                SubMeshRange submesh{
+                    .first_index = static_cast<uint32_t>(data.indices.size()),
+                    .index_count = 0,
+                    .first_vertex = static_cast<uint32_t>(data.vertices.size()),
+                    .vertex_count = mesh->mNumVertices
+                };
+
                 for (size_t j = 0; j < mesh->mNumVertices; j++)
                 {
-                    vertex_data.push_back({
+                    data.vertices.push_back({
                         .x = mesh->mVertices[j].x,
                         .y = mesh->mVertices[j].y,
                         .z = mesh->mVertices[j].z,
@@ -59,80 +174,173 @@ namespace yazpgp
                         .nz = mesh->mNormals[j].z,
                         .u = has_uvs ? mesh->mTextureCoords[0][j].x : 0.0f,
                         .v = has_uvs ? mesh->mTextureCoords[0][j].y : 0.0f,
-                        .tx = mesh->mTangents[j].x,
-                        .ty = mesh->mTangents[j].y,
-                        .tz = mesh->mTangents[j].z
+                        .tx = has_tangents ? mesh->mTangents[j].x : 1.0f,
+                        .ty = has_tangents ? mesh->mTangents[j].y : 0.0f,
+                        .tz = has_tangents ? mesh->mTangents[j].z : 0.0f
                     });
                 }
+
+                // face indices are local to their mesh, all meshes share one vertex buffer
+                for (size_t j = 0; j < mesh->mNumFaces; j++)
+                {
+                    for (size_t k = 0; k < mesh->mFaces[j].mNumIndices; k++)
+                        data.indices.push_back(submesh.first_vertex + mesh->mFaces[j].mIndices[k]);
+                }
+
+                submesh.index_count = static_cast<uint32_t>(data.indices.size()) - submesh.first_index;
+                data.submeshes.push_back(submesh);
             }
 
-            std::vector<uint32_t> indices;
-            size_t estimated_index_data_size = 0;
-            for (size_t i = 0; i < scene->mNumMeshes; i++)
-                estimated_index_data_size += scene->mMeshes[i]->mNumFaces * 3;
-            
-            indices.reserve(estimated_index_data_size);
+            const auto stats = optimize_submeshes(data);
+            YAZPGP_LOG_INFO(
+                "Optimized mesh %s: vertices %zu -> %zu, ACMR %.3f -> %.3f, %s indices",
+                path.c_str(),
+                stats.vertices_before,
+                stats.vertices_after,
+                stats.acmr_before,
+                stats.acmr_after,
+                stats.vertices_after <= std::numeric_limits<uint16_t>::max() ? "16-bit" : "32-bit"
+            );
 
-            for (size_t i = 0; i < scene->mNumMeshes; i++)
+            for (const auto& submesh : data.submeshes)
             {
-                const aiMesh* mesh = scene->mMeshes[i];
-                for (size_t j = 0; j < mesh->mNumFaces; j++)
+                const auto indices = std::span<const uint32_t>(data.indices).subspan(submesh.first_index, submesh.index_count);
+                for (auto meshlet : build_meshlets(indices, reinterpret_cast<const float*>(data.vertices.data()), data.vertices.size(), sizeof(Vertex)))
                 {
-                    for (size_t k = 0; k < mesh->mFaces[j].mNumIndices; k++)
-                        indices.push_back(mesh->mFaces[j].mIndices[k]);
+                    meshlet.first_index += submesh.first_index;
+                    data.meshlets.push_back(meshlet);
                 }
             }
-            
-            return std::make_shared<Mesh>(vertex_data, indices, VertexAttributeLayout({
-                {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
-                {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
-                {.size = 2, .type = GL_FLOAT, .normalized = GL_FALSE},
-                {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
-            }));
+            build_lods(data);
+            std::string triangles;
+            for (const auto& lod : data.lods)
+                triangles += (triangles.empty() ? "" : ", ") + std::to_string(lod.index_count / 3);
+            YAZPGP_LOG_INFO("LODs of %s: %zu with %s triangles, error %.4f", path.c_str(), data.lods.size(), triangles.c_str(), data.lods.back().error);
+            YAZPGP_LOG_INFO("Meshlets of %s: %zu", path.c_str(), data.meshlets.size());
+
+            return data;
+        }
+
+        std::shared_ptr<Mesh> load_mesh_from_file(const std::string& path)
+        {
+            auto blob = read_cached_mesh(path);
+            if (not blob.has_value())
+                return nullptr;
+
+            return std::make_shared<Mesh>(blob->vertices, blob->indices, blob->bounds, blob->bounding_sphere, blob->layout, blob->lods, blob->meshlets);
         }
     
+        namespace
+        {
+            constexpr int MAX_SHADER_INCLUDE_DEPTH = 16;
+
+            std::optional<std::string> load_shader_source_recursive(const std::filesystem::path& path, std::unordered_set<std::string>& included, int depth)
+            {
+                if (depth > MAX_SHADER_INCLUDE_DEPTH)
+                {
+                    YAZPGP_LOG_ERROR("Shader includes nested too deep: %s", path.c_str());
+                    return std::nullopt;
+                }
+
+                auto source = slurp_file(path.string());
+                if (not source.has_value())
+                    return std::nullopt;
+
+                std::string result;
+                result.reserve(source->size());
+                std::istringstream lines(source.value());
+                std::string line;
+                while (std::getline(lines, line))
+                {
+                    const size_t directive = line.find_first_not_of(" \t");
+                    if (directive == std::string::npos or line.compare(directive, 8, "#include") != 0)
+                    {
+                        result += line;
+                        result += '\n';
+                        continue;
+                    }
+
+                    const size_t open_quote = line.find('"', directive);
+                    const size_t close_quote = line.find('"', open_quote + 1);
+                    if (open_quote == std::string::npos or close_quote == std::string::npos)
+                    {
+                        YAZPGP_LOG_ERROR("Malformed #include in %s: %s", path.c_str(), line.c_str());
+                        return std::nullopt;
+                    }
+
+                    const auto include_path = (path.parent_path() / line.substr(open_quote + 1, close_quote - open_quote - 1)).lexically_normal();
+                    // every file is included once, like #pragma once
+                    if (not included.insert(include_path.string()).second)
+                        continue;
+
+                    auto include_source = load_shader_source_recursive(include_path, included, depth + 1);
+                    if (not include_source.has_value())
+                        return std::nullopt;
+
+                    result += include_source.value();
+                }
+
+                return result;
+            }
+        }
+
+        std::optional<std::string> load_shader_source(const std::string& path)
+        {
+            std::unordered_set<std::string> included;
+            return load_shader_source_recursive(path, included, 0);
+        }
+
         std::shared_ptr<Shader> load_shader_from_file(const std::string& vertex_path, const std::string& fragment_path)
         {
-            auto vertex_source = slurp_file(vertex_path);
+            auto vertex_source = load_shader_source(vertex_path);
             if (not vertex_source.has_value())
                 return nullptr;
 
-            auto fragment_source = slurp_file(fragment_path);
+            auto fragment_source = load_shader_source(fragment_path);
             if (not fragment_source.has_value())
                 return nullptr;
 
             return Shader::create_shader(vertex_source.value(), fragment_source.value());
         }
 
-        std::shared_ptr<Texture2D> load_texture_from_file(const std::string& path)
+        std::optional<ImageData> read_image(const std::string& path, bool flip_vertically)
         {
             SDL_Surface* surface = IMG_Load(path.c_str());
             if (not surface)
             {
-                YAZPGP_LOG_ERROR("Failed to load texture from file: %s", path.c_str());
+                YAZPGP_LOG_ERROR("Failed to load image from file: %s", path.c_str());
                 YAZPGP_LOG_ERROR("Error: %s", IMG_GetError());
-                return nullptr;
+                return std::nullopt;
             }
 
+            // rows padded to 4 bytes, the default GL_UNPACK_ALIGNMENT
+            const size_t row_size = surface->w * surface->format->BytesPerPixel;
+            const size_t row_stride = (row_size + 3) & ~size_t(3);
+            ImageData image{
+                .bytes = std::vector<char>(row_stride * surface->h),
+                .width = surface->w,
+                .height = surface->h,
+                .channels = surface->format->BytesPerPixel
+            };
+
             // engineers in SDL couldn't add the most used function in image processing with opengl :))
-            for (int y = 0; y < surface->h / 2; y++)
+            for (int y = 0; y < surface->h; y++)
             {
-                char* top_row = static_cast<char*>(surface->pixels) + y * surface->pitch;
-                char* bottom_row = static_cast<char*>(surface->pixels) + (surface->h - y - 1) * surface->pitch;
-                for (int x = 0; x < surface->w * surface->format->BytesPerPixel; x++)
-                    std::swap(top_row[x], bottom_row[x]);
+                const int source_row = flip_vertically ? surface->h - y - 1 : y;
+                std::memcpy(image.bytes.data() + y * row_stride, static_cast<const char*>(surface->pixels) + source_row * surface->pitch, row_size);
             }
 
+            SDL_FreeSurface(surface);
+            return image;
+        }
 
-            auto texture =  std::make_shared<Texture2D>(
-                static_cast<const char*>(surface->pixels),
-                surface->w,
-                surface->h,
-                surface->format->BytesPerPixel
-            );
+        std::shared_ptr<Texture2D> load_texture_from_file(const std::string& path)
+        {
+            auto cooked = read_cooked_texture(path);
+            if (not cooked.has_value())
+                return nullptr;
 
-            SDL_FreeSurface(surface);
-            return texture;
+            return std::make_shared<Texture2D>(cooked->internal_format, cooked->format, cooked->levels);
         }
 
 
@@ -156,63 +364,42 @@ namespace yazpgp
             return contents;
         }
 
-        std::shared_ptr<CubeMap> load_cubemap_from_files(const std::array<std::string, 6>& paths)
+        bool replace_file(const std::string& path, std::span<const char> contents)
         {
-            SDL_Surface* surfaces[6];
-            for (size_t i = 0; i < 6; i++)
+            std::error_code error;
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+            // every thread writes its own temporary, rename replaces atomically
+            const std::string temporary_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
             {
-                surfaces[i] = IMG_Load(paths[i].c_str());
-                if (not surfaces[i])
+                std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+                if (not file.write(contents.data(), contents.size()))
                 {
-                    YAZPGP_LOG_ERROR("Failed to load cubemap from file: %s", paths[i].c_str());
-                    YAZPGP_LOG_ERROR("Error: %s", IMG_GetError());
-                    return nullptr;
+                    file.close();
+                    std::filesystem::remove(temporary_path, error);
+                    return false;
                 }
             }
 
-            auto cubemap = std::make_shared<CubeMap>(std::array<CubeMap::CubeMapDataPart, 6>({
-                CubeMap::CubeMapDataPart{
-                    .bytes = static_cast<const char*>(surfaces[0]->pixels),
-                    .width = surfaces[0]->w,
-                    .height = surfaces[0]->h,
-                    .channels = surfaces[0]->format->BytesPerPixel
-                },
-                {
-                    .bytes = static_cast<const char*>(surfaces[1]->pixels),
-                    .width = surfaces[1]->w,
-                    .height = surfaces[1]->h,
-                    .channels = surfaces[1]->format->BytesPerPixel
-                },
-                {
-                    .bytes = static_cast<const char*>(surfaces[2]->pixels),
-                    .width = surfaces[2]->w,
-                    .height = surfaces[2]->h,
-                    .channels = surfaces[2]->format->BytesPerPixel
-                },
-                {
-                    .bytes = static_cast<const char*>(surfaces[3]->pixels),
-                    .width = surfaces[3]->w,
-                    .height = surfaces[3]->h,
-                    .channels = surfaces[3]->format->BytesPerPixel
-                },
-                {
-                    .bytes = static_cast<const char*>(surfaces[4]->pixels),
-                    .width = surfaces[4]->w,
-                    .height = surfaces[4]->h,
-                    .channels = surfaces[4]->format->BytesPerPixel
-                },
-                {
-                    .bytes = static_cast<const char*>(surfaces[5]->pixels),
-                    .width = surfaces[5]->w,
-                    .height = surfaces[5]->h,
-                    .channels = surfaces[5]->format->BytesPerPixel
-                }
-            }));
+            std::filesystem::rename(temporary_path, path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporary_path, error);
+                return false;
+            }
+            return true;
+        }
 
-            for (size_t i = 0; i < 6; i++)
-                SDL_FreeSurface(surfaces[i]);
+        std::shared_ptr<CubeMap> load_cubemap_from_files(const std::array<std::string, 6>& paths)
+        {
+            auto cooked = read_cooked_cubemap(paths);
+            if (not cooked.has_value())
+            {
+                YAZPGP_LOG_ERROR("Failed to load cubemap from files: %s", paths[0].c_str());
+                return nullptr;
+            }
 
-            return cubemap;
+            return std::make_shared<CubeMap>(cooked->internal_format, cooked->format, cooked->level_count, cooked->levels);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "job_system.hpp"
+
+namespace yazpgp
+{
+    namespace
+    {
+        // worker index of the current thread, threads of other job systems count as worker 0
+        thread_local const JobSystem* t_job_system = nullptr;
+        thread_local uint32_t t_worker = 0;
+    }
+
+    bool JobSystem::Counter::done() const
+    {
+        return m_pending.load(std::memory_order_acquire) == 0;
+    }
+
+    JobSystem::JobSystem(uint32_t worker_count)
+    {
+        m_workers.reserve(worker_count + 1);
+        for (uint32_t i = 0; i < worker_count + 1; i++)
+            m_workers.push_back(std::make_unique<Worker>());
+
+        m_threads.reserve(worker_count);
+        for (uint32_t i = 1; i <= worker_count; i++)
+            m_threads.emplace_back(&JobSystem::worker_loop, this, i);
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    void JobSystem::run(JobFunction function, void* context, uint32_t count, uint32_t chunk_size, Counter& counter, Counter* dependency)
+    {
+        if (count == 0)
+            return;
+
+        chunk_size = std::max(chunk_size, 1u);
+        const uint32_t chunk_count = (count + chunk_size - 1) / chunk_size;
+        // counted before any chunk can run, a fast chunk must not see the counter reach zero early
+        counter.m_pending.fetch_add(chunk_count, std::memory_order_relaxed);
+
+        std::vector<Job> jobs(chunk_count);
+        for (uint32_t i = 0; i < chunk_count; i++)
+        {
+            const uint32_t begin = i * chunk_size;
+            jobs[i] = Job{ function, context, begin, std::min(begin + chunk_size, count), &counter };
+        }
+
+        if (dependency)
+        {
+            std::lock_guard lock(dependency->m_mutex);
+            if (not dependency->done())
+            {
+                dependency->m_continuations.insert(dependency->m_continuations.end(), jobs.begin(), jobs.end());
+                return;
+            }
+        }
+
+        push(jobs.data(), jobs.size());
+    }
+
+    void JobSystem::run_background(JobFunction function, void* context, Counter& counter)
+    {
+        counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_queued.fetch_add(1, std::memory_order_release);
+        }
+        {
+            std::lock_guard lock(m_background_mutex);
+            m_background_jobs.push_back(Job{ function, context, 0, 1, &counter });
+        }
+        m_wake.notify_one();
+    }
+
+    void JobSystem::wait(const Counter& counter)
+    {
+        const uint32_t worker = current_worker();
+        while (not counter.done())
+        {
+            if (not execute_one(worker) and not (m_threads.empty() and execute_background()))
+                std::this_thread::yield();
+        }
+
+        // the last job may still be releasing the counter
+        std::lock_guard lock(counter.m_mutex);
+    }
+
+    uint32_t JobSystem::thread_count() const
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    void JobSystem::push(const Job* jobs, size_t count)
+    {
+        // counted before the jobs can be stolen, a thief finishing one first must not wrap the counter,
+        // taking the sleep mutex orders the increment against workers about to sleep
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_queued.fetch_add(static_cast<uint32_t>(count), std::memory_order_release);
+        }
+
+        auto& worker = *m_workers[current_worker()];
+        {
+            std::lock_guard lock(worker.mutex);
+            worker.jobs.insert(worker.jobs.end(), jobs, jobs + count);
+        }
+        if (count == 1)
+            m_wake.notify_one();
+        else
+            m_wake.notify_all();
+    }
+
+    bool JobSystem::pop(uint32_t worker, Job& job)
+    {
+        auto& owner = *m_workers[worker];
+        std::lock_guard lock(owner.mutex);
+        if (owner.jobs.empty())
+            return false;
+
+        job = owner.jobs.back();
+        owner.jobs.pop_back();
+        return true;
+    }
+
+    bool JobSystem::steal(uint32_t thief, Job& job)
+    {
+        const size_t worker_count = m_workers.size();
+        for (size_t offset = 1; offset < worker_count; offset++)
+        {
+            auto& victim = *m_workers[(thief + offset) % worker_count];
+            std::lock_guard lock(victim.mutex);
+            if (victim.jobs.empty())
+                continue;
+
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool JobSystem::execute_one(uint32_t worker)
+    {
+        Job job;
+        if (not pop(worker, job) and not steal(worker, job))
+            return false;
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        job.function(job.context, job.begin, job.end);
+        finish(job);
+        return true;
+    }
+
+    bool JobSystem::execute_background()
+    {
+        Job job;
+        {
+            std::lock_guard lock(m_background_mutex);
+            if (m_background_jobs.empty())
+                return false;
+
+            job = m_background_jobs.front();
+            m_background_jobs.pop_front();
+        }
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        job.function(job.context, job.begin, job.end);
+        finish(job);
+        return true;
+    }
+
+    void JobSystem::finish(const Job& job)
+    {
+        std::vector<Job> continuations;
+        {
+            std::lock_guard lock(job.counter->m_mutex);
+            if (job.counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                continuations.swap(job.counter->m_continuations);
+        }
+
+        if (not continuations.empty())
+            push(continuations.data(), continuations.size());
+    }
+
+    void JobSystem::worker_loop(uint32_t worker)
+    {
+        t_job_system = this;
+        t_worker = worker;
+
+        while (true)
+        {
+            // frame jobs first, background jobs only keep otherwise idle workers busy
+            if (execute_one(worker) or execute_background())
+                continue;
+
+            std::unique_lock lock(m_sleep_mutex);
+            m_wake.wait(lock, [this]() { return m_stop or m_queued.load(std::memory_order_acquire) > 0; });
+            if (m_stop)
+                return;
+        }
+    }
+
+    uint32_t JobSystem::current_worker() const
+    {
+        return t_job_system == this ? t_worker : 0;
+    }
+}
@@ -0,0 +1,96 @@
+#include "light_assignment.hpp"
+
+namespace yazpgp
+{
+    void LightAssignment::build(
+        const std::vector<PointLight>& point_lights,
+        const std::vector<SpotLight>& spot_lights,
+        const Bvh& bvh,
+        const std::vector<AABB>& world_aabbs,
+        const std::vector<uint32_t>& entity_indices,
+        size_t indexed_count
+    )
+    {
+        m_lists.assign(world_aabbs.size(), LightList{ .offset = UNASSIGNED, .point_count = 0, .spot_count = 0 });
+        for (auto index : entity_indices)
+        {
+            if (index < indexed_count)
+                m_lists[index].offset = 0;
+        }
+
+        m_point_references.clear();
+        for (uint32_t i = 0; i < point_lights.size(); i++)
+        {
+            const BoundingSphere sphere{ .center = point_lights[i].position, .radius = point_lights[i].influence_radius() };
+            assign_sphere(sphere, i, bvh, world_aabbs, m_point_references);
+        }
+
+        m_spot_references.clear();
+        for (uint32_t i = 0; i < spot_lights.size(); i++)
+        {
+            const BoundingSphere sphere{ .center = spot_lights[i].position, .radius = spot_lights[i].influence_radius() };
+            assign_sphere(sphere, i, bvh, world_aabbs, m_spot_references);
+        }
+
+        // counting sort by entity, point lights of an entity go before its spot lights
+        for (const auto& reference : m_point_references)
+            m_lists[reference.entity].point_count++;
+        for (const auto& reference : m_spot_references)
+            m_lists[reference.entity].spot_count++;
+
+        uint32_t offset = 0;
+        m_cursors.resize(world_aabbs.size());
+        for (auto index : entity_indices)
+        {
+            if (m_lists[index].offset == UNASSIGNED)
+                continue;
+            m_lists[index].offset = offset;
+            m_cursors[index] = offset;
+            offset += m_lists[index].point_count + m_lists[index].spot_count;
+        }
+
+        m_light_indices.resize(offset);
+        for (const auto& reference : m_point_references)
+            m_light_indices[m_cursors[reference.entity]++] = reference.light_index;
+        for (const auto& reference : m_spot_references)
+            m_light_indices[m_cursors[reference.entity]++] = reference.light_index;
+    }
+
+    void LightAssignment::assign_sphere(
+        const BoundingSphere& sphere,
+        uint32_t light_index,
+        const Bvh& bvh,
+        const std::vector<AABB>& world_aabbs,
+        std::vector<Reference>& references
+    )
+    {
+        m_candidates.clear();
+        bvh.query_sphere(sphere, m_candidates);
+
+        // the spatial index holds fattened bounds, the world AABB is the exact test
+        const float radius_squared = sphere.radius * sphere.radius;
+        for (auto entity : m_candidates)
+        {
+            if (entity >= m_lists.size() or m_lists[entity].offset == UNASSIGNED)
+                continue;
+
+            if (world_aabbs[entity].distance_squared(sphere.center) > radius_squared)
+                continue;
+
+            references.push_back({entity, light_index});
+        }
+    }
+
+    LightAssignment::LightList LightAssignment::list_of(uint32_t entity_index) const
+    {
+        if (entity_index >= m_lists.size())
+            return LightList{ .offset = UNASSIGNED, .point_count = 0, .spot_count = 0 };
+
+        return m_lists[entity_index];
+    }
+
+    const std::vector<uint32_t>& LightAssignment::light_indices() const
+    {
+        return m_light_indices;
+    }
+}
@@ -0,0 +1,156 @@
+#include "light_buffer.hpp"
+#include "uniform_block_bindings.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace yazpgp
+{
+    namespace
+    {
+        LightBlockData::Intensity intensity(float ambient, float diffuse, float specular)
+        {
+            return { .ambient = ambient, .diffuse = diffuse, .specular = specular, .padding = 0.0f };
+        }
+    }
+
+    LightBuffer::LightBuffer()
+        : m_block(UniformBlockBinding::LIGHTS, sizeof(LightBlockData))
+    {
+    }
+
+    void LightBuffer::mark_dirty()
+    {
+        m_upload_frames = StreamBuffer::REGION_COUNT;
+    }
+
+    void LightBuffer::assign_entity_lights(
+        const std::vector<yazpgp::PointLight>& point_lights,
+        const std::vector<yazpgp::SpotLight>& spot_lights,
+        const Bvh& bvh,
+        const std::vector<AABB>& world_aabbs,
+        const std::vector<uint32_t>& entity_indices,
+        size_t indexed_count
+    )
+    {
+        m_light_assignment.build(point_lights, spot_lights, bvh, world_aabbs, entity_indices, indexed_count);
+    }
+
+    void LightBuffer::upload_and_bind(
+        const std::vector<yazpgp::PointLight>& point_lights,
+        const std::vector<yazpgp::SpotLight>& spot_lights,
+        const std::vector<yazpgp::DirectionalLight>& directional_lights,
+        const glm::mat4& view_matrix,
+        const glm::mat4& projection_matrix,
+        const glm::vec2& viewport_size
+    )
+    {
+        // regions are sized for at least one light, so the ranges bound below are never empty
+        if (m_point_lights.begin_frame(std::max<size_t>(point_lights.size(), 1) * sizeof(PointLightData)))
+            m_upload_frames = StreamBuffer::REGION_COUNT;
+        if (m_spot_lights.begin_frame(std::max<size_t>(spot_lights.size(), 1) * sizeof(SpotLightData)))
+            m_upload_frames = StreamBuffer::REGION_COUNT;
+
+        if (m_upload_frames > 0)
+        {
+            auto* point_data = reinterpret_cast<PointLightData*>(m_point_lights.data());
+            for (size_t i = 0; i < point_lights.size(); i++)
+            {
+                const auto& light = point_lights[i];
+                point_data[i] = {
+                    .position = light.position,
+                    .illumination_radius = light.illumination_radius,
+                    .color = light.color,
+                    .padding = 0.0f,
+                    .intensity = intensity(light.ambient_intensity, light.diffuse_intensity, light.specular_intensity)
+                };
+            }
+
+            auto* spot_data = reinterpret_cast<SpotLightData*>(m_spot_lights.data());
+            for (size_t i = 0; i < spot_lights.size(); i++)
+            {
+                const auto& light = spot_lights[i];
+                spot_data[i] = {
+                    .position = light.position,
+                    .illumination_radius = light.illumination_radius,
+                    .direction = light.direction,
+                    .inner_cone_angle_degrees = light.inner_cone_angle_degrees,
+                    .color = light.color,
+                    .outer_cone_angle_degrees = light.outer_cone_angle_degrees,
+                    .intensity = intensity(light.ambient_intensity, light.diffuse_intensity, light.specular_intensity)
+                };
+            }
+
+            m_upload_frames--;
+            m_upload_count++;
+        }
+
+        m_light_clusters.build(point_lights, spot_lights, view_matrix, projection_matrix);
+
+        const auto& clusters = m_light_clusters.clusters();
+        m_clusters.begin_frame(clusters.size() * sizeof(LightClusters::Cluster));
+        std::memcpy(m_clusters.data(), clusters.data(), clusters.size() * sizeof(LightClusters::Cluster));
+
+        const auto& cluster_indices = m_light_clusters.light_indices();
+        const auto& entity_indices = m_light_assignment.light_indices();
+        const size_t index_count = cluster_indices.size() + entity_indices.size();
+        m_light_indices.begin_frame(std::max<size_t>(index_count, 1) * sizeof(uint32_t));
+        auto* light_indices = reinterpret_cast<uint32_t*>(m_light_indices.data());
+        std::copy(cluster_indices.begin(), cluster_indices.end(), light_indices);
+        std::copy(entity_indices.begin(), entity_indices.end(), light_indices + cluster_indices.size());
+
+        m_data.num_directional_lights = std::min<size_t>(directional_lights.size(), DirectionalLight::MAX_DIRECTIONAL_LIGHTS);
+        for (int32_t i = 0; i < m_data.num_directional_lights; i++)
+        {
+            const auto& light = directional_lights[i];
+            auto& data = m_data.directional_lights[i];
+            data.direction = light.direction;
+            data.color = light.color;
+            data.intensity = intensity(light.ambient_intensity, light.diffuse_intensity, light.specular_intensity);
+        }
+        m_data.num_point_lights = static_cast<int32_t>(point_lights.size());
+        m_data.num_spot_lights = static_cast<int32_t>(spot_lights.size());
+        m_data.cluster_tile_size = viewport_size / glm::vec2(LightClusters::GRID_X, LightClusters::GRID_Y);
+        m_data.cluster_depth_scale = m_light_clusters.depth_scale();
+        m_data.cluster_depth_bias = m_light_clusters.depth_bias();
+        m_block.upload(&m_data, sizeof(LightBlockData));
+
+        m_block.bind();
+        m_point_lights.bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::POINT_LIGHTS);
+        m_spot_lights.bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::SPOT_LIGHTS);
+        m_clusters.bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::LIGHT_CLUSTERS);
+        m_light_indices.bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::LIGHT_INDICES);
+    }
+
+    void LightBuffer::end_frame()
+    {
+        m_point_lights.end_frame();
+        m_spot_lights.end_frame();
+        m_clusters.end_frame();
+        m_light_indices.end_frame();
+    }
+
+    size_t LightBuffer::upload_count() const
+    {
+        return m_upload_count;
+    }
+
+    LightAssignment::LightList LightBuffer::entity_lights(uint32_t entity_index) const
+    {
+        auto list = m_light_assignment.list_of(entity_index);
+        if (list.offset != LightAssignment::UNASSIGNED)
+            list.offset += static_cast<uint32_t>(m_light_clusters.light_indices().size());
+        return list;
+    }
+
+    size_t LightBuffer::entity_light_index_count() const
+    {
+        return m_light_assignment.light_indices().size();
+    }
+
+    size_t LightBuffer::light_index_count() const
+    {
+        return m_light_clusters.light_indices().size();
+    }
+}
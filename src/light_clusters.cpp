@@ -0,0 +1,135 @@
+#include "light_clusters.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace yazpgp
+{
+    namespace
+    {
+        uint32_t tile_of(float ndc, uint32_t tile_count)
+        {
+            const float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(tile_count));
+            return static_cast<uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(tile_count - 1)));
+        }
+    }
+
+    LightClusters::LightClusters()
+        : m_clusters(CLUSTER_COUNT, Cluster{})
+    {
+    }
+
+    void LightClusters::build(
+        const std::vector<PointLight>& point_lights,
+        const std::vector<SpotLight>& spot_lights,
+        const glm::mat4& view_matrix,
+        const glm::mat4& projection_matrix
+    )
+    {
+        // near and far planes of a glm::perspective matrix
+        const float near = projection_matrix[3][2] / (projection_matrix[2][2] - 1.0f);
+        const float far = projection_matrix[3][2] / (projection_matrix[2][2] + 1.0f);
+        m_near = near > 0.0f ? near : 0.1f;
+        m_far = far > m_near ? far : m_near * 1000.0f;
+        m_depth_scale = static_cast<float>(GRID_Z) / std::log(m_far / m_near);
+        m_depth_bias = -std::log(m_near) * m_depth_scale;
+
+        m_point_references.clear();
+        for (uint32_t i = 0; i < point_lights.size(); i++)
+        {
+            const glm::vec3 center = glm::vec3(view_matrix * glm::vec4(point_lights[i].position, 1.0f));
+            bin_sphere(center, point_lights[i].influence_radius(), projection_matrix, i, m_point_references);
+        }
+
+        m_spot_references.clear();
+        for (uint32_t i = 0; i < spot_lights.size(); i++)
+        {
+            const glm::vec3 center = glm::vec3(view_matrix * glm::vec4(spot_lights[i].position, 1.0f));
+            bin_sphere(center, spot_lights[i].influence_radius(), projection_matrix, i, m_spot_references);
+        }
+
+        // counting sort by cluster, point lights of a cluster go before its spot lights
+        std::fill(m_clusters.begin(), m_clusters.end(), Cluster{});
+        for (const auto& reference : m_point_references)
+            m_clusters[reference.cluster].point_count++;
+        for (const auto& reference : m_spot_references)
+            m_clusters[reference.cluster].spot_count++;
+
+        uint32_t offset = 0;
+        m_cursors.resize(CLUSTER_COUNT);
+        for (uint32_t i = 0; i < CLUSTER_COUNT; i++)
+        {
+            m_clusters[i].offset = offset;
+            m_cursors[i] = offset;
+            offset += m_clusters[i].point_count + m_clusters[i].spot_count;
+        }
+
+        m_light_indices.resize(offset);
+        for (const auto& reference : m_point_references)
+            m_light_indices[m_cursors[reference.cluster]++] = reference.light_index;
+        for (const auto& reference : m_spot_references)
+            m_light_indices[m_cursors[reference.cluster]++] = reference.light_index;
+    }
+
+    void LightClusters::bin_sphere(const glm::vec3& view_center, float radius, const glm::mat4& projection_matrix, uint32_t light_index, std::vector<Reference>& references) const
+    {
+        // view space looks down -z
+        const float min_depth = std::max(-view_center.z - radius, m_near);
+        const float max_depth = std::min(-view_center.z + radius, m_far);
+        if (min_depth > max_depth)
+            return;
+
+        const uint32_t first_slice = slice_of(min_depth);
+        const uint32_t last_slice = slice_of(max_depth);
+        for (uint32_t z = first_slice; z <= last_slice; z++)
+        {
+            // part of the sphere depth range inside this slice
+            const float slice_near = std::max(min_depth, m_near * std::pow(m_far / m_near, static_cast<float>(z) / GRID_Z));
+            const float slice_far = std::min(max_depth, m_near * std::pow(m_far / m_near, static_cast<float>(z + 1) / GRID_Z));
+
+            // the sphere box projected at both ends of the range bounds its projection in between
+            const float x_min = std::min((view_center.x - radius) / slice_near, (view_center.x - radius) / slice_far) * projection_matrix[0][0];
+            const float x_max = std::max((view_center.x + radius) / slice_near, (view_center.x + radius) / slice_far) * projection_matrix[0][0];
+            const float y_min = std::min((view_center.y - radius) / slice_near, (view_center.y - radius) / slice_far) * projection_matrix[1][1];
+            const float y_max = std::max((view_center.y + radius) / slice_near, (view_center.y + radius) / slice_far) * projection_matrix[1][1];
+            if (x_min > 1.0f or x_max < -1.0f or y_min > 1.0f or y_max < -1.0f)
+                continue;
+
+            const uint32_t first_x = tile_of(x_min, GRID_X);
+            const uint32_t last_x = tile_of(x_max, GRID_X);
+            const uint32_t first_y = tile_of(y_min, GRID_Y);
+            const uint32_t last_y = tile_of(y_max, GRID_Y);
+            for (uint32_t y = first_y; y <= last_y; y++)
+            {
+                for (uint32_t x = first_x; x <= last_x; x++)
+                    references.push_back({x + GRID_X * (y + GRID_Y * z), light_index});
+            }
+        }
+    }
+
+    uint32_t LightClusters::slice_of(float depth) const
+    {
+        const float slice = std::floor(std::log(depth) * m_depth_scale + m_depth_bias);
+        return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(GRID_Z - 1)));
+    }
+
+    const std::vector<LightClusters::Cluster>& LightClusters::clusters() const
+    {
+        return m_clusters;
+    }
+
+    const std::vector<uint32_t>& LightClusters::light_indices() const
+    {
+        return m_light_indices;
+    }
+
+    float LightClusters::depth_scale() const
+    {
+        return m_depth_scale;
+    }
+
+    float LightClusters::depth_bias() const
+    {
+        return m_depth_bias;
+    }
+}
@@ -0,0 +1,85 @@
+#include "mapped_file.hpp"
+#include "logger.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace yazpgp
+{
+    std::unique_ptr<MappedFile> MappedFile::create(const std::string& path)
+    {
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return nullptr;
+
+        struct stat status;
+        if (fstat(file, &status) != 0 or status.st_size == 0)
+        {
+            close(file);
+            return nullptr;
+        }
+
+        const size_t size = static_cast<size_t>(status.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        // the mapping keeps the file alive
+        close(file);
+        if (data == MAP_FAILED)
+        {
+            YAZPGP_LOG_ERROR("Failed to map file: %s", path.c_str());
+            return nullptr;
+        }
+
+        // every page is read right away by the upload, start reading ahead
+        madvise(data, size, MADV_WILLNEED);
+        return std::make_unique<MappedFile>(static_cast<const std::byte*>(data), size);
+    }
+
+    MappedFile::MappedFile(const std::byte* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+
+    const std::byte* MappedFile::data() const
+    {
+        return m_data;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return m_size;
+    }
+
+    uint64_t MappedFile::hash() const
+    {
+        // FNV-1a over 8 byte words with a rotation for the high bits, a cache key and not a checksum
+        constexpr uint64_t PRIME = 0x100000001b3ull;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= m_size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, m_data + i, sizeof(word));
+            hash = std::rotl((hash ^ word) * PRIME, 31);
+        }
+        for (; i < m_size; i++)
+            hash = (hash ^ static_cast<uint64_t>(m_data[i])) * PRIME;
+
+        // finalizer of MurmurHash3, small edits change the whole key
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+}
@@ -0,0 +1,64 @@
+#include "mat4_compositor.hpp"
+
+namespace yazpgp
+{
+    Mat4InstructionList& Mat4InstructionList::translate(const glm::vec3& translation)
+    {
+        m_instructions.push_back({ .op = Op::Translate, .value = translation, .matrix_index = 0 });
+        return *this;
+    }
+
+    Mat4InstructionList& Mat4InstructionList::rotate(const glm::vec3& rotation)
+    {
+        m_instructions.push_back({ .op = Op::Rotate, .value = rotation, .matrix_index = 0 });
+        return *this;
+    }
+
+    Mat4InstructionList& Mat4InstructionList::scale(const glm::vec3& scale)
+    {
+        m_instructions.push_back({ .op = Op::Scale, .value = scale, .matrix_index = 0 });
+        return *this;
+    }
+
+    Mat4InstructionList& Mat4InstructionList::multiply(const glm::mat4& matrix)
+    {
+        m_instructions.push_back({ .op = Op::Multiply, .value = glm::vec3(0.0f), .matrix_index = static_cast<uint32_t>(m_matrices.size()) });
+        m_matrices.push_back(matrix);
+        return *this;
+    }
+
+    void Mat4InstructionList::clear()
+    {
+        m_instructions.clear();
+        m_matrices.clear();
+    }
+
+    glm::mat4 Mat4InstructionList::operator()(const glm::mat4& m) const
+    {
+        glm::mat4 result = m;
+        for (const auto& instruction : m_instructions)
+        {
+            switch (instruction.op)
+            {
+                case Op::Translate:
+                    result = compositor::Translate{instruction.value}(result);
+                    break;
+                case Op::Rotate:
+                    result = compositor::Rotate{instruction.value}(result);
+                    break;
+                case Op::Scale:
+                    result = compositor::Scale{instruction.value}(result);
+                    break;
+                case Op::Multiply:
+                    result = compositor::Multiply{m_matrices[instruction.matrix_index]}(result);
+                    break;
+            }
+        }
+        return result;
+    }
+
+    const std::vector<Mat4InstructionList::Instruction>& Mat4InstructionList::instructions() const
+    {
+        return m_instructions;
+    }
+}
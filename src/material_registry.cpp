@@ -0,0 +1,112 @@
+#include "material_registry.hpp"
+#include "uniform_block_bindings.hpp"
+#include "logger.hpp"
+
+#include <cstring>
+#include <string_view>
+#include <functional>
+
+namespace yazpgp
+{
+    namespace
+    {
+        struct ParametersHash
+        {
+            size_t operator()(const MaterialParameters& parameters) const
+            {
+                return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(&parameters), sizeof(parameters)));
+            }
+        };
+
+        struct ParametersEqual
+        {
+            bool operator()(const MaterialParameters& a, const MaterialParameters& b) const
+            {
+                return std::memcmp(&a, &b, sizeof(MaterialParameters)) == 0;
+            }
+        };
+    }
+
+    MaterialRegistry::MaterialRegistry()
+        : m_buffer(UniformBlockBinding::MATERIALS, MAX_MATERIALS * sizeof(MaterialParameters))
+    {
+    }
+
+    void MaterialRegistry::add(const std::shared_ptr<Material>& material)
+    {
+        if (not material)
+            return;
+
+        if (m_index_by_material.try_emplace(material.get(), 0).second)
+        {
+            m_materials.push_back(material);
+            m_dirty = true;
+        }
+    }
+
+    void MaterialRegistry::mark_dirty()
+    {
+        m_dirty = true;
+    }
+
+    void MaterialRegistry::deduplicate()
+    {
+        m_entries.clear();
+        m_entries.push_back(MaterialParameters{});
+
+        std::unordered_map<MaterialParameters, uint32_t, ParametersHash, ParametersEqual> index_by_parameters;
+        index_by_parameters.emplace(m_entries.front(), 0);
+
+        bool overflow = false;
+        for (const auto& material : m_materials)
+        {
+            const auto parameters = material->parameters();
+            auto [it, inserted] = index_by_parameters.try_emplace(parameters, static_cast<uint32_t>(m_entries.size()));
+            if (inserted)
+            {
+                if (m_entries.size() < MAX_MATERIALS)
+                {
+                    m_entries.push_back(parameters);
+                }
+                else
+                {
+                    it->second = 0;
+                    overflow = true;
+                }
+            }
+            m_index_by_material[material.get()] = it->second;
+        }
+
+        if (overflow)
+            YAZPGP_LOG_WARN("More than %zu distinct materials, the rest is drawn with the default material", MAX_MATERIALS);
+    }
+
+    void MaterialRegistry::upload_and_bind()
+    {
+        if (m_dirty)
+        {
+            deduplicate();
+            m_buffer.upload(m_entries.data(), m_entries.size() * sizeof(MaterialParameters));
+            m_dirty = false;
+            m_upload_count++;
+        }
+
+        m_buffer.bind();
+    }
+
+    uint32_t MaterialRegistry::index_of(const Material* material) const
+    {
+        const auto it = m_index_by_material.find(material);
+        return it != m_index_by_material.end() ? it->second : 0;
+    }
+
+    size_t MaterialRegistry::entry_count() const
+    {
+        return m_entries.size();
+    }
+
+    size_t MaterialRegistry::upload_count() const
+    {
+        return m_upload_count;
+    }
+}
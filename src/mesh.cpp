@@ -1,46 +1,105 @@
 #include "mesh.hpp"
 #include "logger.hpp"
+#include "mesh_optimizer.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <cstring>
+#include <limits>
 #include <memory>
 
 namespace yazpgp
 {
     Mesh::Mesh(const float* vertices, size_t size_bytes, const VertexAttributeLayout& layout)
-        : m_vert_count(size_bytes / layout.get_stride())
+        : m_vertex_stride(layout.get_stride()), m_layout(layout)
     {
+        std::vector<std::byte> welded(reinterpret_cast<const std::byte*>(vertices), reinterpret_cast<const std::byte*>(vertices) + size_bytes);
+        std::vector<uint32_t> indices(size_bytes / m_vertex_stride);
+        std::iota(indices.begin(), indices.end(), 0);
+        const auto stats = optimize_mesh(welded, m_vertex_stride, indices);
+        m_vert_count = stats.vertices_after;
 
         this->init_vao();
-        this->init_vbo(vertices, size_bytes);
+        this->init_vbo(reinterpret_cast<const float*>(welded.data()), m_vert_count * m_vertex_stride);
+        this->init_bounds(reinterpret_cast<const float*>(welded.data()), m_vertex_stride);
         layout.use();
+        this->init_ebo(std::span<const uint32_t>(indices));
+        this->init_lods({});
+        this->init_meshlets({});
 
-        
-        std::vector<uint32_t> indices(m_vert_count);
-        std::iota(indices.begin(), indices.end(), 0);
-        m_index_count = indices.size();
+        YAZPGP_LOG_DEBUG("Mesh loaded with vao: %d, ebo: %d, verts: %lu, indices: %lu, tris: %lu", m_vao, m_ebo, m_vert_count, m_index_count, m_index_count / 3);
+    }
 
-        this->init_ebo(indices.data(), indices.size() * sizeof(uint32_t));
+    namespace
+    {
+        // coarser levels have to stay this far below the pixel error before they are picked
+        constexpr float LOD_HYSTERESIS = 0.75f;
 
-        YAZPGP_LOG_DEBUG("Mesh loaded with vao: %d, ebo: %d, verts: %lu, indices: %lu, tris: %lu", m_vao, m_ebo, m_vert_count, m_index_count, m_index_count / 3);
+        AABB vertex_bounds(const std::vector<Vertex>& vertices)
+        {
+            return AABB::from_vertices(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex));
+        }
+
+        BoundingSphere vertex_bounding_sphere(const std::vector<Vertex>& vertices, const AABB& bounds)
+        {
+            return BoundingSphere::from_vertices(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex), bounds);
+        }
     }
 
     Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexAttributeLayout& layout)
-        : m_vert_count(vertices.size()), m_index_count(indices.size())
     {
+        const AABB bounds = vertex_bounds(vertices);
+        init(std::as_bytes(std::span(vertices)), std::span<const uint32_t>(indices), bounds, vertex_bounding_sphere(vertices, bounds), layout, {}, {});
+    }
 
-        static_assert(sizeof(Vertex) == 11 * sizeof(float));
-        YAZPGP_LOG_FATAL_IF(m_vert_count * layout.get_stride() != vertices.size() * sizeof(Vertex), "Vertex size mismatch");
-        std::unique_ptr<float[]> vertices_data = std::make_unique<float[]>(vertices.size() * layout.get_stride());
+    Mesh::Mesh(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets)
+    {
+        init(vertices, indices, bounds, bounding_sphere, layout, lods, meshlets);
+    }
 
-        std::memcpy(vertices_data.get(), vertices.data(), vertices.size() * sizeof(Vertex));
+    Mesh::Mesh(std::span<const Vertex> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets)
+    {
+        init(std::as_bytes(vertices), indices, bounds, bounding_sphere, layout, lods, meshlets);
+    }
+
+    void Mesh::replace(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const VertexAttributeLayout& layout)
+    {
+        const AABB bounds = vertex_bounds(vertices);
+        replace(std::as_bytes(std::span(vertices)), std::span<const uint32_t>(indices), bounds, vertex_bounding_sphere(vertices, bounds), layout, {}, {});
+    }
+
+    void Mesh::replace(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets)
+    {
+        release();
+        init(vertices, indices, bounds, bounding_sphere, layout, lods, meshlets);
+        m_generation++;
+    }
+
+    uint32_t Mesh::generation() const
+    {
+        return m_generation;
+    }
 
+    void Mesh::init(std::span<const std::byte> vertices, IndexSpan indices, const AABB& bounds, const BoundingSphere& bounding_sphere, const VertexAttributeLayout& layout, std::span<const MeshLod> lods, std::span<const Meshlet> meshlets)
+    {
+        m_vertex_stride = layout.get_stride();
+        m_layout = layout;
+        m_vert_count = vertices.size() / m_vertex_stride;
+        m_bounds = bounds;
+        m_bounding_sphere = bounding_sphere;
+
+        static_assert(sizeof(Vertex) == 11 * sizeof(float));
+        YAZPGP_LOG_FATAL_IF(vertices.size() % m_vertex_stride != 0, "Vertex data is not a multiple of the layout stride");
+
+        // the data goes to the driver as it is laid out, without an intermediate copy
         this->init_vao();
-        this->init_vbo(vertices_data.get(), vertices.size() * sizeof(Vertex));
+        this->init_vbo(reinterpret_cast<const float*>(vertices.data()), vertices.size());
         layout.use();
-        this->init_ebo(indices.data(), indices.size() * sizeof(uint32_t));
+        this->init_ebo(indices);
+        this->init_lods(lods);
+        this->init_meshlets(meshlets);
 
-        YAZPGP_LOG_DEBUG("Mesh loaded with vao: %d, ebo: %d, verts: %lu, indices: %lu, tris: %lu", m_vao, m_ebo, m_vert_count, m_index_count, m_index_count / 3);
+        YAZPGP_LOG_DEBUG("Mesh loaded with vao: %d, ebo: %d, verts: %lu, indices: %lu, tris: %lu, lods: %zu, meshlets: %zu", m_vao, m_ebo, m_vert_count, m_index_count, m_index_count / 3, m_lods.size(), m_meshlets.size());
     }
 
     void Mesh::init_vao()
@@ -59,11 +118,62 @@ namespace yazpgp
         glBufferData(GL_ARRAY_BUFFER, size_bytes, vertices, GL_STATIC_DRAW);
     }
 
-    void Mesh::init_ebo(const uint32_t* indices, size_t size_bytes)
+    void Mesh::init_ebo(IndexSpan indices)
     {
+        // half the index memory and bandwidth whenever every vertex fits into 16 bits
+        std::vector<uint16_t> short_indices;
+        if (indices.type == GL_UNSIGNED_INT and m_vert_count <= std::numeric_limits<uint16_t>::max())
+        {
+            const auto* wide = static_cast<const uint32_t*>(indices.data);
+            short_indices.assign(wide, wide + indices.count);
+            indices = IndexSpan(std::span<const uint16_t>(short_indices));
+        }
+
+        m_index_buffer_count = indices.count;
+        m_index_type = indices.type;
         glGenBuffers(1, &m_ebo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_bytes, indices, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size_bytes(), indices.data, GL_STATIC_DRAW);
+    }
+
+    void Mesh::init_lods(std::span<const MeshLod> lods)
+    {
+        m_lods.clear();
+        for (const auto& lod : lods.first(std::min(lods.size(), MAX_LODS)))
+        {
+            if (size_t(lod.first_index) + lod.index_count > m_index_buffer_count)
+            {
+                YAZPGP_LOG_ERROR("Mesh LOD %zu is outside of the %zu indices, dropping the coarser levels", m_lods.size(), m_index_buffer_count);
+                break;
+            }
+            m_lods.push_back(lod);
+        }
+        if (m_lods.empty())
+            m_lods.push_back(MeshLod{ .first_index = 0, .index_count = static_cast<uint32_t>(m_index_buffer_count), .error = 0.0f });
+        m_index_count = m_lods.front().index_count;
+    }
+
+    void Mesh::init_meshlets(std::span<const Meshlet> meshlets)
+    {
+        const MeshLod& finest = m_lods.front();
+        const bool inside = std::all_of(meshlets.begin(), meshlets.end(), [&](const Meshlet& meshlet)
+        {
+            return meshlet.first_index >= finest.first_index and size_t(meshlet.first_index) + meshlet.index_count <= size_t(finest.first_index) + finest.index_count;
+        });
+        if (inside)
+            m_meshlets.assign(meshlets.begin(), meshlets.end());
+        else
+        {
+            YAZPGP_LOG_ERROR("Mesh meshlets are outside of the finest LOD, the mesh is drawn whole");
+            m_meshlets.clear();
+        }
+    }
+
+    void Mesh::init_bounds(const float* vertices, size_t stride_bytes)
+    {
+        // position is always the first attribute
+        m_bounds = AABB::from_vertices(vertices, m_vert_count, stride_bytes);
+        m_bounding_sphere = BoundingSphere::from_vertices(vertices, m_vert_count, stride_bytes, m_bounds);
     }
 
     void Mesh::use() const
@@ -72,6 +182,31 @@ namespace yazpgp
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
     }
 
+    GLuint Mesh::vertex_array() const
+    {
+        return m_vao;
+    }
+
+    GLuint Mesh::vertex_buffer() const
+    {
+        return m_vbo;
+    }
+
+    GLuint Mesh::index_buffer() const
+    {
+        return m_ebo;
+    }
+
+    size_t Mesh::vertex_stride() const
+    {
+        return m_vertex_stride;
+    }
+
+    const VertexAttributeLayout& Mesh::attribute_layout() const
+    {
+        return m_layout;
+    }
+
     size_t Mesh::get_vert_count() const
     {
         return m_vert_count;
@@ -82,7 +217,61 @@ namespace yazpgp
         return m_index_count;
     }
 
+    size_t Mesh::index_buffer_count() const
+    {
+        return m_index_buffer_count;
+    }
+
+    const std::vector<MeshLod>& Mesh::lods() const
+    {
+        return m_lods;
+    }
+
+    const std::vector<Meshlet>& Mesh::meshlets() const
+    {
+        return m_meshlets;
+    }
+
+    uint32_t Mesh::select_lod(float pixels_per_unit, float max_pixel_error, uint32_t current) const
+    {
+        uint32_t selected = 0;
+        for (uint32_t lod = 1; lod < m_lods.size(); lod++)
+        {
+            const float limit = lod > current ? max_pixel_error * LOD_HYSTERESIS : max_pixel_error;
+            // errors grow with every level, the first one over the limit ends the search
+            if (m_lods[lod].error * pixels_per_unit > limit)
+                break;
+            selected = lod;
+        }
+        return selected;
+    }
+
+    GLenum Mesh::index_type() const
+    {
+        return m_index_type;
+    }
+
+    size_t Mesh::index_size() const
+    {
+        return m_index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    const AABB& Mesh::bounds() const
+    {
+        return m_bounds;
+    }
+
+    const BoundingSphere& Mesh::bounding_sphere() const
+    {
+        return m_bounding_sphere;
+    }
+
     Mesh::~Mesh()
+    {
+        release();
+    }
+
+    void Mesh::release()
     {
         glDeleteBuffers(1, &m_vbo);
         glDeleteBuffers(1, &m_ebo);
@@ -91,6 +280,16 @@ namespace yazpgp
         YAZPGP_LOG_DEBUG("Mesh deleted with vao: %d, ebo: %d", m_vao, m_ebo);
     }
 
+    VertexAttributeLayout Mesh::vertex_layout()
+    {
+        return VertexAttributeLayout({
+            {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
+            {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
+            {.size = 2, .type = GL_FLOAT, .normalized = GL_FALSE},
+            {.size = 3, .type = GL_FLOAT, .normalized = GL_FALSE},
+        });
+    }
+
     std::unique_ptr<Mesh> Mesh::create_cube()
     {
         // Kindly borrowed from:
@@ -147,4 +346,11 @@ namespace yazpgp
         );
             
     }
+
+    std::unique_ptr<Mesh> Mesh::create_placeholder()
+    {
+        const std::vector<Vertex> vertices(3, Vertex{ .x = 0, .y = 0, .z = 0, .nx = 0, .ny = 1, .nz = 0, .u = 0, .v = 0, .tx = 1, .ty = 0, .tz = 0 });
+        const std::vector<uint32_t> indices = {0, 1, 2};
+        return std::make_unique<Mesh>(vertices, indices, vertex_layout());
+    }
 }
@@ -0,0 +1,264 @@
+#include "mesh_cache.hpp"
+#include "logger.hpp"
+#include "vertex_quantization.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <type_traits>
+
+namespace yazpgp
+{
+    namespace io
+    {
+        namespace
+        {
+            constexpr char MAGIC[4] = { 'Y', 'Z', 'M', 'C' };
+            // bumped whenever the layout of the file or the vertex quantization changes
+            constexpr uint32_t FORMAT_VERSION = 5;
+            constexpr uint32_t MAX_CACHED_ATTRIBUTES = 8;
+            // blobs start aligned, the mapping itself is page aligned
+            constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+            struct CachedAttribute
+            {
+                int32_t size;
+                uint32_t type;
+                uint32_t normalized;
+            };
+
+            struct MeshCacheHeader
+            {
+                char magic[4];
+                uint32_t version;
+                uint64_t source_hash;
+                uint64_t source_size;
+                uint32_t import_flags;
+                uint32_t vertex_stride;
+                uint32_t vertex_count;
+                uint32_t index_count;
+                uint32_t submesh_count;
+                uint32_t lod_count;
+                uint32_t meshlet_count;
+                float bounds_min[3];
+                float bounds_max[3];
+                float sphere_center[3];
+                float sphere_radius;
+                uint32_t index_size;
+                uint32_t attribute_count;
+                CachedAttribute attributes[MAX_CACHED_ATTRIBUTES];
+                uint64_t vertex_offset;
+                uint64_t index_offset;
+                uint64_t submesh_offset;
+                uint64_t lod_offset;
+                uint64_t meshlet_offset;
+            };
+            static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+            static_assert(std::is_trivially_copyable_v<SubMeshRange> and std::is_trivially_copyable_v<MeshLod> and std::is_trivially_copyable_v<Meshlet>);
+
+            uint64_t align_up(uint64_t offset)
+            {
+                return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+            }
+
+            bool blob_fits(uint64_t offset, uint64_t size_bytes, uint64_t file_size)
+            {
+                return offset % BLOB_ALIGNMENT == 0 and offset <= file_size and size_bytes <= file_size - offset;
+            }
+
+            std::string cache_file_path(const std::string& cache_directory, uint64_t source_hash)
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "%016llx-%08x.mesh", static_cast<unsigned long long>(source_hash), MESH_IMPORT_FLAGS);
+                return (std::filesystem::path(cache_directory) / name).string();
+            }
+
+            std::optional<MeshBlob> map_cache_file(const std::string& cache_path, uint64_t source_hash, uint64_t source_size)
+            {
+                auto file = MappedFile::create(cache_path);
+                if (not file or file->size() < sizeof(MeshCacheHeader))
+                    return std::nullopt;
+
+                MeshCacheHeader header;
+                std::memcpy(&header, file->data(), sizeof(header));
+                const bool matches = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+                    and header.version == FORMAT_VERSION
+                    and header.source_hash == source_hash
+                    and header.source_size == source_size
+                    and header.import_flags == MESH_IMPORT_FLAGS
+                    and header.attribute_count > 0
+                    and header.attribute_count <= MAX_CACHED_ATTRIBUTES
+                    and (header.index_size == sizeof(uint16_t) or header.index_size == sizeof(uint32_t));
+                if (not matches)
+                {
+                    YAZPGP_LOG_DEBUG("Mesh cache %s is stale", cache_path.c_str());
+                    return std::nullopt;
+                }
+
+                std::vector<VertexAttribute> attributes;
+                for (uint32_t i = 0; i < header.attribute_count; i++)
+                {
+                    // only formats quantize_vertices writes, anything else would be fatal for the layout
+                    const auto& attribute = header.attributes[i];
+                    const bool supported = attribute.size >= 1 and attribute.size <= 4
+                        and (attribute.type == GL_FLOAT or attribute.type == GL_HALF_FLOAT or attribute.type == GL_UNSIGNED_SHORT
+                            or (attribute.type == GL_INT_2_10_10_10_REV and attribute.size == 4));
+                    if (not supported)
+                    {
+                        YAZPGP_LOG_ERROR("Mesh cache %s has an unsupported vertex attribute", cache_path.c_str());
+                        return std::nullopt;
+                    }
+                    attributes.push_back({ .size = attribute.size, .type = attribute.type, .normalized = static_cast<GLboolean>(attribute.normalized) });
+                }
+                VertexAttributeLayout layout(attributes);
+                if (layout.get_stride() != header.vertex_stride)
+                {
+                    YAZPGP_LOG_ERROR("Mesh cache %s has a vertex stride of %u for a layout of %zu bytes", cache_path.c_str(), header.vertex_stride, layout.get_stride());
+                    return std::nullopt;
+                }
+
+                const bool fits = blob_fits(header.vertex_offset, uint64_t(header.vertex_count) * header.vertex_stride, file->size())
+                    and blob_fits(header.index_offset, uint64_t(header.index_count) * header.index_size, file->size())
+                    and blob_fits(header.submesh_offset, uint64_t(header.submesh_count) * sizeof(SubMeshRange), file->size())
+                    and blob_fits(header.lod_offset, uint64_t(header.lod_count) * sizeof(MeshLod), file->size())
+                    and blob_fits(header.meshlet_offset, uint64_t(header.meshlet_count) * sizeof(Meshlet), file->size());
+                if (not fits)
+                {
+                    YAZPGP_LOG_ERROR("Mesh cache %s is truncated", cache_path.c_str());
+                    return std::nullopt;
+                }
+
+                const std::byte* bytes = file->data();
+                const IndexSpan indices = header.index_size == sizeof(uint16_t)
+                    ? IndexSpan(std::span(reinterpret_cast<const uint16_t*>(bytes + header.index_offset), header.index_count))
+                    : IndexSpan(std::span(reinterpret_cast<const uint32_t*>(bytes + header.index_offset), header.index_count));
+                return MeshBlob{
+                    .vertices = { bytes + header.vertex_offset, uint64_t(header.vertex_count) * header.vertex_stride },
+                    .layout = std::move(layout),
+                    .indices = indices,
+                    .submeshes = { reinterpret_cast<const SubMeshRange*>(bytes + header.submesh_offset), header.submesh_count },
+                    .lods = { reinterpret_cast<const MeshLod*>(bytes + header.lod_offset), header.lod_count },
+                    .meshlets = { reinterpret_cast<const Meshlet*>(bytes + header.meshlet_offset), header.meshlet_count },
+                    .bounds = AABB{
+                        .min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]),
+                        .max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2])
+                    },
+                    .bounding_sphere = BoundingSphere{
+                        .center = glm::vec3(header.sphere_center[0], header.sphere_center[1], header.sphere_center[2]),
+                        .radius = header.sphere_radius
+                    },
+                    .file = std::move(file),
+                    .imported = nullptr,
+                    .short_indices = {},
+                    .quantized_vertices = {}
+                };
+            }
+
+            MeshBlob blob_of(std::unique_ptr<MeshData> data)
+            {
+                const AABB bounds = AABB::from_vertices(reinterpret_cast<const float*>(data->vertices.data()), data->vertices.size(), sizeof(Vertex));
+                std::vector<uint16_t> short_indices;
+                if (data->vertices.size() <= std::numeric_limits<uint16_t>::max())
+                    short_indices.assign(data->indices.begin(), data->indices.end());
+
+                QuantizedVertices quantized = quantize_vertices(data->vertices, bounds);
+
+                // moving the vectors into the blob keeps their buffers
+                const IndexSpan indices = short_indices.empty()
+                    ? IndexSpan(std::span<const uint32_t>(data->indices))
+                    : IndexSpan(std::span<const uint16_t>(short_indices));
+                return MeshBlob{
+                    .vertices = quantized.bytes,
+                    .layout = std::move(quantized.layout),
+                    .indices = indices,
+                    .submeshes = data->submeshes,
+                    .lods = data->lods,
+                    .meshlets = data->meshlets,
+                    .bounds = bounds,
+                    .bounding_sphere = BoundingSphere::from_vertices(reinterpret_cast<const float*>(data->vertices.data()), data->vertices.size(), sizeof(Vertex), bounds),
+                    .file = nullptr,
+                    .imported = std::move(data),
+                    .short_indices = std::move(short_indices),
+                    .quantized_vertices = std::move(quantized.bytes)
+                };
+            }
+
+            bool write_cache_file(const std::string& cache_path, uint64_t source_hash, uint64_t source_size, const MeshBlob& blob)
+            {
+                MeshCacheHeader header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = FORMAT_VERSION;
+                header.source_hash = source_hash;
+                header.source_size = source_size;
+                header.import_flags = MESH_IMPORT_FLAGS;
+                const auto& attributes = blob.layout.attributes();
+                if (attributes.size() > MAX_CACHED_ATTRIBUTES)
+                    return false;
+
+                header.attribute_count = static_cast<uint32_t>(attributes.size());
+                for (size_t i = 0; i < attributes.size(); i++)
+                    header.attributes[i] = CachedAttribute{ .size = attributes[i].size, .type = attributes[i].type, .normalized = attributes[i].normalized };
+                header.vertex_stride = static_cast<uint32_t>(blob.layout.get_stride());
+                header.vertex_count = static_cast<uint32_t>(blob.vertices.size() / blob.layout.get_stride());
+                header.index_count = static_cast<uint32_t>(blob.indices.count);
+                header.index_size = static_cast<uint32_t>(blob.indices.index_size());
+                header.submesh_count = static_cast<uint32_t>(blob.submeshes.size());
+                header.lod_count = static_cast<uint32_t>(blob.lods.size());
+                header.meshlet_count = static_cast<uint32_t>(blob.meshlets.size());
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    header.bounds_min[axis] = blob.bounds.min[axis];
+                    header.bounds_max[axis] = blob.bounds.max[axis];
+                    header.sphere_center[axis] = blob.bounding_sphere.center[axis];
+                }
+                header.sphere_radius = blob.bounding_sphere.radius;
+                header.vertex_offset = align_up(sizeof(header));
+                header.index_offset = align_up(header.vertex_offset + blob.vertices.size_bytes());
+                header.submesh_offset = align_up(header.index_offset + blob.indices.size_bytes());
+                header.lod_offset = align_up(header.submesh_offset + blob.submeshes.size_bytes());
+                header.meshlet_offset = align_up(header.lod_offset + blob.lods.size_bytes());
+
+                std::vector<char> contents(header.meshlet_offset + blob.meshlets.size_bytes());
+                std::memcpy(contents.data(), &header, sizeof(header));
+                std::memcpy(contents.data() + header.vertex_offset, blob.vertices.data(), blob.vertices.size_bytes());
+                std::memcpy(contents.data() + header.index_offset, blob.indices.data, blob.indices.size_bytes());
+                std::memcpy(contents.data() + header.submesh_offset, blob.submeshes.data(), blob.submeshes.size_bytes());
+                std::memcpy(contents.data() + header.lod_offset, blob.lods.data(), blob.lods.size_bytes());
+                std::memcpy(contents.data() + header.meshlet_offset, blob.meshlets.data(), blob.meshlets.size_bytes());
+                return replace_file(cache_path, contents);
+            }
+        }
+
+        std::optional<MeshBlob> read_cached_mesh(const std::string& path, const std::string& cache_directory)
+        {
+            uint64_t source_hash = 0;
+            uint64_t source_size = 0;
+            {
+                auto source = MappedFile::create(path);
+                if (not source)
+                {
+                    YAZPGP_LOG_ERROR("Failed to open mesh file: %s", path.c_str());
+                    return std::nullopt;
+                }
+                source_hash = source->hash();
+                source_size = source->size();
+            }
+
+            const std::string cache_path = cache_file_path(cache_directory, source_hash);
+            if (auto cached = map_cache_file(cache_path, source_hash, source_size))
+                return cached;
+
+            auto data = read_mesh_data(path);
+            if (not data.has_value())
+                return std::nullopt;
+
+            MeshBlob imported = blob_of(std::make_unique<MeshData>(std::move(data.value())));
+            if (write_cache_file(cache_path, source_hash, source_size, imported))
+                YAZPGP_LOG_INFO("Cached mesh %s as %s, %zu bytes per vertex", path.c_str(), cache_path.c_str(), imported.layout.get_stride());
+            else
+                YAZPGP_LOG_ERROR("Failed to write mesh cache: %s", cache_path.c_str());
+            return imported;
+        }
+    }
+}
@@ -0,0 +1,545 @@
+#include "mesh_optimizer.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <limits>
+#include <cmath>
+
+namespace yazpgp
+{
+    namespace
+    {
+        glm::vec3 position_of(const float* positions, size_t stride_bytes, uint32_t vertex)
+        {
+            const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * stride_bytes);
+            return glm::vec3(position[0], position[1], position[2]);
+        }
+
+        // sum of squared distances to planes as a symmetric 4x4 matrix, weighted by triangle area
+        struct Quadric
+        {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+            double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+            double a22 = 0.0, a23 = 0.0;
+            double a33 = 0.0;
+            double weight = 0.0;
+
+            Quadric& operator+=(const Quadric& other)
+            {
+                a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+                a11 += other.a11; a12 += other.a12; a13 += other.a13;
+                a22 += other.a22; a23 += other.a23;
+                a33 += other.a33;
+                weight += other.weight;
+                return *this;
+            }
+
+            void add_plane(const glm::dvec3& normal, double distance, double area)
+            {
+                a00 += area * normal.x * normal.x; a01 += area * normal.x * normal.y; a02 += area * normal.x * normal.z; a03 += area * normal.x * distance;
+                a11 += area * normal.y * normal.y; a12 += area * normal.y * normal.z; a13 += area * normal.y * distance;
+                a22 += area * normal.z * normal.z; a23 += area * normal.z * distance;
+                a33 += area * distance * distance;
+                weight += area;
+            }
+
+            // area weighted mean of the squared distances of the point to the planes
+            double error(const glm::dvec3& p) const
+            {
+                const double sum = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + a33
+                    + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z + a03 * p.x + a13 * p.y + a23 * p.z);
+                return weight > 0.0 ? std::max(sum / weight, 0.0) : 0.0;
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from;
+            uint32_t to;
+            double error;
+        };
+    }
+
+    float average_cache_miss_ratio(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size)
+    {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+            return 0.0f;
+
+        // FIFO, a vertex is cached while fewer than cache_size misses happened since it was loaded
+        std::vector<uint32_t> loaded_at(vertex_count, 0);
+        uint32_t misses = cache_size + 1;
+        const uint32_t first_miss = misses;
+        for (const uint32_t index : indices)
+        {
+            if (misses - loaded_at[index] > cache_size)
+                loaded_at[index] = misses++;
+        }
+        return static_cast<float>(misses - first_miss) / static_cast<float>(triangle_count);
+    }
+
+    size_t weld_vertices(const void* vertices, size_t vertex_count, size_t stride_bytes, std::vector<uint32_t>& remap)
+    {
+        const auto* bytes = static_cast<const char*>(vertices);
+        std::unordered_map<std::string_view, uint32_t> unique;
+        unique.reserve(vertex_count);
+        remap.resize(vertex_count);
+        for (size_t i = 0; i < vertex_count; i++)
+        {
+            const auto [vertex, inserted] = unique.try_emplace(std::string_view(bytes + i * stride_bytes, stride_bytes), static_cast<uint32_t>(unique.size()));
+            remap[i] = vertex->second;
+        }
+        return unique.size();
+    }
+
+    void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count, std::vector<uint32_t>& clusters, uint32_t cache_size)
+    {
+        // Sander, Nehab and Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007
+        clusters.clear();
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0)
+            return;
+
+        // triangles around every vertex, live counts the ones not emitted yet
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (const uint32_t index : indices)
+            live[index]++;
+
+        std::vector<uint32_t> first_adjacent(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++)
+            first_adjacent[v + 1] = first_adjacent[v] + live[v];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(first_adjacent.begin(), first_adjacent.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+        std::vector<uint32_t> loaded_at(vertex_count, 0);
+        std::vector<uint8_t> emitted(triangle_count, 0);
+        std::vector<uint32_t> dead_ends;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        dead_ends.reserve(indices.size());
+        output.reserve(indices.size());
+        uint32_t time = cache_size + 1;
+        size_t cursor = 0;
+
+        // recently used vertices first, then the first vertex in input order with triangles left
+        const auto skip_dead_end = [&]() -> uint32_t
+        {
+            while (not dead_ends.empty())
+            {
+                const uint32_t vertex = dead_ends.back();
+                dead_ends.pop_back();
+                if (live[vertex] > 0)
+                    return vertex;
+            }
+            for (; cursor < vertex_count; cursor++)
+            {
+                if (live[cursor] > 0)
+                    return static_cast<uint32_t>(cursor);
+            }
+            return UNUSED_VERTEX;
+        };
+
+        uint32_t fan = skip_dead_end();
+        clusters.push_back(0);
+        while (fan != UNUSED_VERTEX)
+        {
+            candidates.clear();
+            for (uint32_t a = first_adjacent[fan]; a < first_adjacent[fan + 1]; a++)
+            {
+                const uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                    continue;
+
+                emitted[triangle] = 1;
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t vertex = indices[triangle * 3 + k];
+                    output.push_back(vertex);
+                    dead_ends.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    if (time - loaded_at[vertex] > cache_size)
+                        loaded_at[vertex] = time++;
+                }
+            }
+
+            // the candidate which stays cached the longest while its remaining triangles are emitted
+            uint32_t next = UNUSED_VERTEX;
+            int64_t best_priority = -1;
+            for (const uint32_t vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (time - loaded_at[vertex] + 2 * live[vertex] <= cache_size)
+                    priority = time - loaded_at[vertex];
+                if (priority > best_priority)
+                {
+                    best_priority = priority;
+                    next = vertex;
+                }
+            }
+
+            if (next == UNUSED_VERTEX)
+            {
+                next = skip_dead_end();
+                if (next != UNUSED_VERTEX)
+                    clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+            }
+            fan = next;
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void optimize_overdraw(
+        std::span<uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        const std::vector<uint32_t>& clusters,
+        float threshold,
+        uint32_t cache_size
+    )
+    {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0 or clusters.empty())
+            return;
+
+        std::vector<uint32_t> loaded_at(vertex_count, 0);
+        uint32_t time = 0;
+        const auto misses_of = [&](size_t triangle)
+        {
+            uint32_t misses = 0;
+            for (size_t k = 0; k < 3; k++)
+            {
+                const uint32_t vertex = indices[triangle * 3 + k];
+                if (time - loaded_at[vertex] > cache_size)
+                {
+                    loaded_at[vertex] = time++;
+                    misses++;
+                }
+            }
+            return misses;
+        };
+
+        // clusters end where the running ACMR gets within threshold of the whole cluster,
+        // smaller clusters sort better and still start with a cold cache
+        std::vector<uint32_t> boundaries;
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            const size_t begin = clusters[c];
+            const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+
+            time += cache_size + 1;
+            uint32_t cluster_misses = 0;
+            for (size_t t = begin; t < end; t++)
+                cluster_misses += misses_of(t);
+            const float cluster_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+            time += cache_size + 1;
+            boundaries.push_back(static_cast<uint32_t>(begin));
+            uint32_t running_misses = 0;
+            uint32_t running_triangles = 0;
+            for (size_t t = begin; t < end; t++)
+            {
+                running_misses += misses_of(t);
+                running_triangles++;
+                if (t + 1 < end and static_cast<float>(running_misses) <= cluster_threshold * static_cast<float>(running_triangles))
+                {
+                    boundaries.push_back(static_cast<uint32_t>(t + 1));
+                    time += cache_size + 1;
+                    running_misses = 0;
+                    running_triangles = 0;
+                }
+            }
+        }
+
+        struct ClusterOrder
+        {
+            float facing;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        glm::vec3 mesh_center(0.0f);
+        float mesh_area = 0.0f;
+        std::vector<ClusterOrder> order(boundaries.size());
+        std::vector<glm::vec3> cluster_centers(boundaries.size());
+        std::vector<glm::vec3> cluster_normals(boundaries.size());
+        for (size_t c = 0; c < boundaries.size(); c++)
+        {
+            order[c].begin = boundaries[c];
+            order[c].end = c + 1 < boundaries.size() ? boundaries[c + 1] : static_cast<uint32_t>(triangle_count);
+
+            glm::vec3 center(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = order[c].begin; t < order[c].end; t++)
+            {
+                const glm::vec3 a = position_of(positions, stride_bytes, indices[t * 3 + 0]);
+                const glm::vec3 b = position_of(positions, stride_bytes, indices[t * 3 + 1]);
+                const glm::vec3 d = position_of(positions, stride_bytes, indices[t * 3 + 2]);
+                // twice the area, the factor cancels out
+                const glm::vec3 cross = glm::cross(b - a, d - a);
+                const float triangle_area = glm::length(cross);
+                center += (a + b + d) * (triangle_area / 3.0f);
+                normal += cross;
+                area += triangle_area;
+            }
+
+            mesh_center += center;
+            mesh_area += area;
+            cluster_centers[c] = area > 0.0f ? center / area : center;
+            const float normal_length = glm::length(normal);
+            cluster_normals[c] = normal_length > 0.0f ? normal / normal_length : normal;
+        }
+        if (mesh_area > 0.0f)
+            mesh_center /= mesh_area;
+
+        // clusters facing away from the center are in front of the rest from most directions
+        for (size_t c = 0; c < order.size(); c++)
+            order[c].facing = glm::dot(cluster_centers[c] - mesh_center, cluster_normals[c]);
+        std::stable_sort(order.begin(), order.end(), [](const ClusterOrder& a, const ClusterOrder& b) { return a.facing > b.facing; });
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(indices.size());
+        for (const auto& cluster : order)
+            sorted.insert(sorted.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+        std::copy(sorted.begin(), sorted.end(), indices.begin());
+    }
+
+    size_t optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count, std::vector<uint32_t>& remap)
+    {
+        remap.assign(vertex_count, UNUSED_VERTEX);
+        uint32_t used = 0;
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == UNUSED_VERTEX)
+                remap[index] = used++;
+            index = remap[index];
+        }
+        return used;
+    }
+
+    void remap_vertices(const void* source, size_t vertex_count, size_t stride_bytes, const std::vector<uint32_t>& remap, void* destination)
+    {
+        const auto* from = static_cast<const char*>(source);
+        auto* to = static_cast<char*>(destination);
+        for (size_t v = 0; v < vertex_count; v++)
+        {
+            if (remap[v] != UNUSED_VERTEX)
+                std::memcpy(to + remap[v] * stride_bytes, from + v * stride_bytes, stride_bytes);
+        }
+    }
+
+    MeshOptimizationStats optimize_mesh(std::span<std::byte> vertices, size_t stride_bytes, std::vector<uint32_t>& indices)
+    {
+        const size_t vertex_count = vertices.size() / stride_bytes;
+        MeshOptimizationStats stats{
+            .vertices_before = vertex_count,
+            .vertices_after = vertex_count,
+            .acmr_before = average_cache_miss_ratio(indices, vertex_count),
+            .acmr_after = 0.0f
+        };
+
+        std::vector<std::byte> scratch(vertices.begin(), vertices.end());
+        std::vector<uint32_t> remap;
+        const size_t unique_count = weld_vertices(scratch.data(), vertex_count, stride_bytes, remap);
+        for (uint32_t& index : indices)
+            index = remap[index];
+        remap_vertices(scratch.data(), vertex_count, stride_bytes, remap, vertices.data());
+
+        std::vector<uint32_t> clusters;
+        optimize_vertex_cache(indices, unique_count, clusters);
+        optimize_overdraw(indices, reinterpret_cast<const float*>(vertices.data()), unique_count, stride_bytes, clusters);
+
+        stats.vertices_after = optimize_vertex_fetch(indices, unique_count, remap);
+        std::copy(vertices.begin(), vertices.begin() + unique_count * stride_bytes, scratch.begin());
+        remap_vertices(scratch.data(), unique_count, stride_bytes, remap, vertices.data());
+
+        stats.acmr_after = average_cache_miss_ratio(indices, stats.vertices_after);
+        return stats;
+    }
+
+    std::vector<uint32_t> simplify_mesh(
+        std::span<const uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        size_t target_index_count,
+        float target_error,
+        float* result_error
+    )
+    {
+        std::vector<uint32_t> current(indices.begin(), indices.end());
+        const auto position = [&](uint32_t vertex) { return glm::dvec3(position_of(positions, stride_bytes, vertex)); };
+
+        // an edge without its opposite lies on a border or a seam between vertices with different attributes
+        std::unordered_set<uint64_t> directed_edges;
+        directed_edges.reserve(current.size());
+        const auto edge_key = [](uint32_t a, uint32_t b) { return uint64_t(a) << 32 | b; };
+        for (size_t t = 0; t + 2 < current.size(); t += 3)
+        {
+            for (size_t k = 0; k < 3; k++)
+                directed_edges.insert(edge_key(current[t + k], current[t + (k + 1) % 3]));
+        }
+
+        std::vector<uint8_t> locked(vertex_count, 0);
+        std::vector<Quadric> quadrics(vertex_count);
+        for (size_t t = 0; t + 2 < current.size(); t += 3)
+        {
+            const glm::dvec3 a = position(current[t]);
+            const glm::dvec3 cross = glm::cross(position(current[t + 1]) - a, position(current[t + 2]) - a);
+            const double length = glm::length(cross);
+            for (size_t k = 0; k < 3; k++)
+            {
+                const uint32_t from = current[t + k];
+                const uint32_t to = current[t + (k + 1) % 3];
+                if (not directed_edges.contains(edge_key(to, from)))
+                    locked[from] = locked[to] = 1;
+                if (length > 0.0)
+                    quadrics[from].add_plane(cross / length, -glm::dot(cross / length, a), length * 0.5);
+            }
+        }
+
+        std::vector<uint32_t> live(vertex_count);
+        std::vector<uint32_t> first_adjacent(vertex_count + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint8_t> touched(vertex_count);
+        std::vector<uint32_t> remap(vertex_count);
+        const double max_error = double(target_error) * double(target_error);
+        double worst_error = 0.0;
+
+        // every pass collapses independent edges, cheapest first, until the target or the error limit is hit
+        while (current.size() > target_index_count)
+        {
+            std::fill(live.begin(), live.end(), 0);
+            for (const uint32_t index : current)
+                live[index]++;
+            first_adjacent[0] = 0;
+            for (size_t v = 0; v < vertex_count; v++)
+                first_adjacent[v + 1] = first_adjacent[v] + live[v];
+            adjacency.resize(current.size());
+            std::vector<uint32_t> fill(first_adjacent.begin(), first_adjacent.end() - 1);
+            for (size_t i = 0; i < current.size(); i++)
+                adjacency[fill[current[i]]++] = static_cast<uint32_t>(i / 3);
+
+            collapses.clear();
+            for (size_t t = 0; t < current.size(); t += 3)
+            {
+                for (size_t k = 0; k < 3; k++)
+                {
+                    uint32_t a = current[t + k];
+                    uint32_t b = current[t + (k + 1) % 3];
+                    // interior edges show up in both of their triangles, once is enough
+                    if (a > b and directed_edges.contains(edge_key(b, a)))
+                        continue;
+
+                    Quadric merged = quadrics[a];
+                    merged += quadrics[b];
+                    const double a_to_b = locked[a] ? std::numeric_limits<double>::max() : merged.error(position(b));
+                    const double b_to_a = locked[b] ? std::numeric_limits<double>::max() : merged.error(position(a));
+                    if (locked[a] and locked[b])
+                        continue;
+                    if (a_to_b <= b_to_a)
+                        collapses.push_back({ a, b, a_to_b });
+                    else
+                        collapses.push_back({ b, a, b_to_a });
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            // a triangle which would turn around when from moves onto to
+            const auto flips = [&](uint32_t from, uint32_t to)
+            {
+                const glm::dvec3 target = position(to);
+                for (uint32_t a = first_adjacent[from]; a < first_adjacent[from + 1]; a++)
+                {
+                    const size_t t = adjacency[a] * 3;
+                    if (current[t] == to or current[t + 1] == to or current[t + 2] == to)
+                        continue;
+
+                    glm::dvec3 corners[3] = { position(current[t]), position(current[t + 1]), position(current[t + 2]) };
+                    const glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        if (current[t + k] == from)
+                            corners[k] = target;
+                    }
+                    const glm::dvec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    if (glm::dot(before, after) <= 0.0)
+                        return true;
+                }
+                return false;
+            };
+
+            std::fill(touched.begin(), touched.end(), 0);
+            std::iota(remap.begin(), remap.end(), 0);
+            const size_t target_triangles = target_index_count / 3;
+            size_t triangles = current.size() / 3;
+            size_t collapsed = 0;
+            for (const auto& collapse : collapses)
+            {
+                if (collapse.error > max_error or triangles <= target_triangles)
+                    break;
+                if (touched[collapse.from] or touched[collapse.to] or flips(collapse.from, collapse.to))
+                    continue;
+
+                // the flip test assumed the neighbourhood of from stays put for the rest of the pass
+                for (uint32_t a = first_adjacent[collapse.from]; a < first_adjacent[collapse.from + 1]; a++)
+                {
+                    const size_t t = adjacency[a] * 3;
+                    if (current[t] == collapse.to or current[t + 1] == collapse.to or current[t + 2] == collapse.to)
+                        triangles--;
+                    for (size_t k = 0; k < 3; k++)
+                        touched[current[t + k]] = 1;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                worst_error = std::max(worst_error, collapse.error);
+                collapsed++;
+            }
+
+            if (collapsed == 0)
+                break;
+
+            size_t kept = 0;
+            for (size_t t = 0; t < current.size(); t += 3)
+            {
+                const uint32_t a = remap[current[t]];
+                const uint32_t b = remap[current[t + 1]];
+                const uint32_t c = remap[current[t + 2]];
+                if (a == b or b == c or a == c)
+                    continue;
+                current[kept++] = a;
+                current[kept++] = b;
+                current[kept++] = c;
+            }
+            current.resize(kept);
+
+            // collapsed edges take their opposite with them, the rest are renamed
+            directed_edges.clear();
+            for (size_t t = 0; t < current.size(); t += 3)
+            {
+                for (size_t k = 0; k < 3; k++)
+                    directed_edges.insert(edge_key(current[t + k], current[t + (k + 1) % 3]));
+            }
+        }
+
+        if (result_error)
+            *result_error = static_cast<float>(std::sqrt(worst_error));
+        return current;
+    }
+}
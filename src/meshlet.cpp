@@ -0,0 +1,126 @@
+#include "meshlet.hpp"
+#include "bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yazpgp
+{
+    namespace
+    {
+        // normals spread wider than about 84 degrees leave too narrow a cone to ever cull
+        constexpr float MIN_CONE_SPREAD = 0.1f;
+        constexpr float NEVER_CULLED = 2.0f;
+
+        glm::vec3 position_of(const float* positions, size_t stride_bytes, uint32_t vertex)
+        {
+            const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * stride_bytes);
+            return glm::vec3(position[0], position[1], position[2]);
+        }
+
+        Meshlet meshlet_of(std::span<const uint32_t> indices, size_t first_index, size_t index_count, const float* positions, size_t stride_bytes)
+        {
+            Meshlet meshlet{
+                .first_index = static_cast<uint32_t>(first_index),
+                .index_count = static_cast<uint32_t>(index_count),
+                .center = glm::vec3(0.0f),
+                .radius = 0.0f,
+                .cone_apex = glm::vec3(0.0f),
+                .cone_axis = glm::vec3(0.0f, 0.0f, 1.0f),
+                .cone_cutoff = NEVER_CULLED
+            };
+
+            AABB bounds;
+            for (size_t i = first_index; i < first_index + index_count; i++)
+                bounds.expand(position_of(positions, stride_bytes, indices[i]));
+            meshlet.center = bounds.center();
+            for (size_t i = first_index; i < first_index + index_count; i++)
+                meshlet.radius = std::max(meshlet.radius, glm::length(position_of(positions, stride_bytes, indices[i]) - meshlet.center));
+
+            // area weighted mean normal as the axis, the least aligned normal sets the angle
+            std::vector<glm::vec3> normals;
+            normals.reserve(index_count / 3);
+            glm::vec3 axis(0.0f);
+            for (size_t t = first_index; t < first_index + index_count; t += 3)
+            {
+                const glm::vec3 a = position_of(positions, stride_bytes, indices[t]);
+                const glm::vec3 cross = glm::cross(position_of(positions, stride_bytes, indices[t + 1]) - a, position_of(positions, stride_bytes, indices[t + 2]) - a);
+                const float length = glm::length(cross);
+                axis += cross;
+                normals.push_back(length > 0.0f ? cross / length : glm::vec3(0.0f));
+            }
+
+            const float axis_length = glm::length(axis);
+            if (axis_length <= 0.0f)
+                return meshlet;
+            axis /= axis_length;
+
+            float min_alignment = 1.0f;
+            for (const auto& normal : normals)
+            {
+                if (normal != glm::vec3(0.0f))
+                    min_alignment = std::min(min_alignment, glm::dot(normal, axis));
+            }
+            meshlet.cone_axis = axis;
+            if (min_alignment <= MIN_CONE_SPREAD)
+                return meshlet;
+
+            // the apex lies on the axis behind every triangle plane, cameras in the cone behind it see only back faces
+            float apex_distance = 0.0f;
+            for (size_t t = first_index, n = 0; t < first_index + index_count; t += 3, n++)
+            {
+                const float alignment = glm::dot(normals[n], axis);
+                if (alignment <= 0.0f)
+                    continue;
+                const glm::vec3 corner = position_of(positions, stride_bytes, indices[t]);
+                apex_distance = std::max(apex_distance, glm::dot(meshlet.center - corner, normals[n]) / alignment);
+            }
+            meshlet.cone_apex = meshlet.center - axis * apex_distance;
+            meshlet.cone_cutoff = std::sqrt(1.0f - min_alignment * min_alignment);
+            return meshlet;
+        }
+    }
+
+    std::vector<Meshlet> build_meshlets(
+        std::span<const uint32_t> indices,
+        const float* positions,
+        size_t vertex_count,
+        size_t stride_bytes,
+        size_t max_vertices,
+        size_t max_triangles
+    )
+    {
+        std::vector<Meshlet> meshlets;
+        // meshlet each vertex was last added to, the id of the current one marks it as already counted
+        std::vector<uint32_t> added_to(vertex_count, ~0u);
+        size_t first_index = 0;
+        size_t vertices = 0;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            const uint32_t a = indices[t];
+            const uint32_t b = indices[t + 1];
+            const uint32_t c = indices[t + 2];
+            const auto new_vertices = [&](uint32_t current) -> size_t
+            {
+                return (added_to[a] != current) + (added_to[b] != current and b != a) + (added_to[c] != current and c != a and c != b);
+            };
+
+            uint32_t current = static_cast<uint32_t>(meshlets.size());
+            if (vertices + new_vertices(current) > max_vertices or (t - first_index) / 3 >= max_triangles)
+            {
+                meshlets.push_back(meshlet_of(indices, first_index, t - first_index, positions, stride_bytes));
+                current = static_cast<uint32_t>(meshlets.size());
+                first_index = t;
+                vertices = 0;
+            }
+
+            vertices += new_vertices(current);
+            added_to[a] = added_to[b] = added_to[c] = current;
+        }
+
+        const size_t end = indices.size() - indices.size() % 3;
+        if (end > first_index)
+            meshlets.push_back(meshlet_of(indices, first_index, end - first_index, positions, stride_bytes));
+        return meshlets;
+    }
+}
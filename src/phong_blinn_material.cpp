@@ -13,17 +13,20 @@ namespace yazpgp
     , m_specular_color(specular_color)
     , m_specular_shininess(specular_shininess) {}
 
-    void PhongBlinnMaterial::use(const Shader& shader)
+    MaterialParameters PhongBlinnMaterial::parameters() const
     {
-        shader.set_uniform("material.ambient_color", m_ambient_color);
-        shader.set_uniform("material.diffuse_color", m_diffuse_color);
-        shader.set_uniform("material.specular_color", m_specular_color);
-        shader.set_uniform("material.specular_shininess", m_specular_shininess);
+        return MaterialParameters{
+            .ambient_color = m_ambient_color,
+            .diffuse_color = m_diffuse_color,
+            .specular_color = m_specular_color,
+            .specular_shininess = m_specular_shininess
+        };
     }
 
     std::shared_ptr<PhongBlinnMaterial> PhongBlinnMaterial::default_material()
     {
-        return std::make_shared<PhongBlinnMaterial>();
+        static const auto material = std::make_shared<PhongBlinnMaterial>();
+        return material;
     }
 
     std::shared_ptr<PhongBlinnMaterial> PhongBlinnMaterial::create_shared(
@@ -0,0 +1,155 @@
+#include "render_queue.hpp"
+#include "entity_storage.hpp"
+#include "shader.hpp"
+#include "mesh.hpp"
+#include "texture.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace yazpgp
+{
+    namespace
+    {
+        constexpr int SHADER_BITS = 12;
+        constexpr int MESH_BITS = 16;
+        constexpr int TEXTURE_SET_BITS = 20;
+        constexpr int LOD_BITS = 3;
+        constexpr int DEPTH_BITS = 13;
+        static_assert(SHADER_BITS + MESH_BITS + TEXTURE_SET_BITS + LOD_BITS + DEPTH_BITS == 64);
+        static_assert(Mesh::MAX_LODS <= 1u << LOD_BITS);
+
+        constexpr int LOD_SHIFT = DEPTH_BITS;
+        constexpr int MESH_SHIFT = LOD_SHIFT + LOD_BITS;
+        constexpr int TEXTURE_SET_SHIFT = MESH_SHIFT + MESH_BITS;
+        constexpr int SHADER_SHIFT = TEXTURE_SET_SHIFT + TEXTURE_SET_BITS;
+
+        uint64_t saturated(uint32_t id, int bits)
+        {
+            return std::min<uint32_t>(id, (1u << bits) - 1);
+        }
+    }
+
+    bool RenderState::bind_shader(const Shader* next)
+    {
+        if (gbuffer_pass and next->gbuffer_variant())
+            next = next->gbuffer_variant().get();
+
+        if (shader == next)
+            return false;
+
+        shader = next;
+        shader->use();
+        program_binds++;
+        return true;
+    }
+
+    bool RenderState::bind_mesh(const Mesh* next)
+    {
+        return bind_vertex_array(next->vertex_array());
+    }
+
+    bool RenderState::bind_vertex_array(GLuint next)
+    {
+        if (vertex_array == next)
+            return false;
+
+        vertex_array = next;
+        glBindVertexArray(vertex_array);
+        vao_binds++;
+        return true;
+    }
+
+    bool RenderState::bind_texture(size_t slot, const Texture* next)
+    {
+        if (textures[slot] == next)
+            return false;
+
+        textures[slot] = next;
+        next->use(slot);
+        texture_binds++;
+        return true;
+    }
+
+    void RenderQueue::begin(const glm::mat4& view_matrix, const glm::mat4& projection_matrix)
+    {
+        m_items.clear();
+
+        m_view_depth_row = -glm::vec4(view_matrix[0][2], view_matrix[1][2], view_matrix[2][2], view_matrix[3][2]);
+
+        // near and far planes of a glm::perspective matrix
+        const float near = projection_matrix[3][2] / (projection_matrix[2][2] - 1.0f);
+        const float far = projection_matrix[3][2] / (projection_matrix[2][2] + 1.0f);
+        m_near = near > 0.0f ? near : 0.1f;
+        const float depth_range = far > m_near ? std::log(far / m_near) : 1.0f;
+        m_inverse_log_depth_range = 1.0f / depth_range;
+    }
+
+    uint16_t RenderQueue::quantize_depth(const glm::vec3& world_position) const
+    {
+        const float depth = glm::dot(m_view_depth_row, glm::vec4(world_position, 1.0f));
+        if (depth <= m_near)
+            return 0;
+
+        // logarithmic, so nearby objects which overlap the most get the most precision
+        const float t = std::log(depth / m_near) * m_inverse_log_depth_range;
+        return static_cast<uint16_t>(std::clamp(t, 0.0f, 1.0f) * float((1 << DEPTH_BITS) - 1));
+    }
+
+    void RenderQueue::push(const RenderHandles& handles, const glm::vec3& center, uint32_t entity_index, uint32_t lod)
+    {
+        const uint64_t key =
+            saturated(handles.shader, SHADER_BITS) << SHADER_SHIFT
+            | saturated(handles.mesh, MESH_BITS) << MESH_SHIFT
+            | saturated(handles.texture_set, TEXTURE_SET_BITS) << TEXTURE_SET_SHIFT
+            | saturated(lod, LOD_BITS) << LOD_SHIFT
+            | quantize_depth(center);
+
+        m_items.push_back({key, entity_index, lod});
+    }
+
+    void RenderQueue::sort()
+    {
+        const size_t count = m_items.size();
+        if (count < 2)
+            return;
+
+        std::array<std::array<size_t, 256>, 8> histograms = {};
+        for (const auto& item : m_items)
+        {
+            for (int byte = 0; byte < 8; byte++)
+                histograms[byte][(item.key >> (byte * 8)) & 0xFF]++;
+        }
+
+        m_scratch.resize(count);
+        for (int byte = 0; byte < 8; byte++)
+        {
+            auto& histogram = histograms[byte];
+            if (histogram[(m_items.front().key >> (byte * 8)) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (auto& bucket : histogram)
+            {
+                const size_t bucket_count = bucket;
+                bucket = offset;
+                offset += bucket_count;
+            }
+
+            for (const auto& item : m_items)
+                m_scratch[histogram[(item.key >> (byte * 8)) & 0xFF]++] = item;
+
+            m_items.swap(m_scratch);
+        }
+    }
+
+    const std::vector<RenderQueue::DrawItem>& RenderQueue::items() const
+    {
+        return m_items;
+    }
+
+    size_t RenderQueue::size() const
+    {
+        return m_items.size();
+    }
+}
@@ -1,8 +1,10 @@
 #include "scene.hpp"
+#include "uniform_block_bindings.hpp"
 #include <imgui/imgui.h>
 #include <glm/gtc/type_ptr.hpp>
 #include "logger.hpp"
 #include <iostream>
+#include <algorithm>
 
 template<class... Ts>
 struct overloaded : Ts... { using Ts::operator()...; };
@@ -13,6 +15,24 @@ overloaded(Ts...) -> overloaded<Ts...>;
 
 namespace yazpgp
 {
+    namespace
+    {
+        struct DrawElementsIndirectCommand
+        {
+            uint32_t count;
+            uint32_t instance_count;
+            uint32_t first_index;
+            int32_t base_vertex;
+            uint32_t base_instance;
+        };
+
+        // moved entities handled by one job, a multiple of every SIMD width of compute_normal_matrices
+        constexpr uint32_t ENTITIES_PER_JOB = 256;
+
+        // smaller meshes are cheaper drawn whole than culled cluster by cluster
+        constexpr size_t MIN_CULLED_MESHLETS = 8;
+    }
+
     Scene::Scene() 
     : m_point_lights(std::make_unique<std::vector<PointLight>>())
     , m_spot_lights(std::make_unique<std::vector<SpotLight>>())
@@ -21,13 +41,24 @@ namespace yazpgp
     , m_point_light_event_distributor(std::make_unique<EventDistributor<PointLight>>())
     , m_spot_light_event_distributor(std::make_unique<EventDistributor<SpotLight>>())
     , m_directional_light_event_distributor(std::make_unique<EventDistributor<DirectionalLight>>())
-    , m_light_count_event_distributor(std::make_unique<EventDistributor<LightCountData>>())
+    , m_light_buffer(std::make_unique<LightBuffer>())
+    , m_frame_buffer(std::make_unique<UniformBuffer>(UniformBlockBinding::FRAME, sizeof(FrameBlockData)))
+    , m_material_registry(std::make_unique<MaterialRegistry>())
+    , m_entity_buffer(std::make_unique<StreamBuffer>())
+    , m_draw_entity_buffer(std::make_unique<StreamBuffer>())
+    , m_indirect_buffer(std::make_unique<StreamBuffer>())
+    , m_geometry_pool(std::make_unique<GeometryPool>())
+    , m_gbuffer(std::make_unique<GBuffer>())
     {
         m_camera.set_notify_callback([event_distributor = m_camera_event_distributor.get()](const Camera& camera)
         {
             event_distributor->notify(camera);
         });
 
+        m_point_light_event_distributor->subscribe([light_buffer = m_light_buffer.get()](const PointLight&) { light_buffer->mark_dirty(); });
+        m_spot_light_event_distributor->subscribe([light_buffer = m_light_buffer.get()](const SpotLight&) { light_buffer->mark_dirty(); });
+        m_directional_light_event_distributor->subscribe([light_buffer = m_light_buffer.get()](const DirectionalLight&) { light_buffer->mark_dirty(); });
+
         m_camera.move_forward(-10.0f);
     }
 
@@ -35,103 +66,523 @@ namespace yazpgp
     {
         auto view_projection_matrix = projection_matrix * m_camera.view_matrix();
 
+        const FrameBlockData frame{
+            .view_matrix = m_camera.view_matrix(),
+            .projection_matrix = projection_matrix,
+            .view_projection_matrix = view_projection_matrix,
+            .inverse_view_projection_matrix = glm::inverse(view_projection_matrix),
+            .camera_position = m_camera.position(),
+            .time = static_cast<float>(m_time)
+        };
+        m_frame_buffer->upload(&frame, sizeof(frame));
+        m_frame_buffer->bind();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        m_material_registry->upload_and_bind();
+
         glStencilMask(0x00);
         if (m_skybox)
             m_skybox->render(projection_matrix, m_camera.view_matrix());
 
 
-        // for (const auto& entity : m_entities)
-        //     entity->render(view_projection_matrix);
+        m_render_stats = {};
+        m_visible_inside.clear();
+        m_visible_intersecting.clear();
+        const Frustum frustum(view_projection_matrix);
+        if (m_frustum_culling)
+        {
+            m_bvh.query_frustum(frustum, m_visible_inside, m_visible_intersecting);
+
+            // fat AABBs on the boundary are refined with the tighter bounding spheres
+            m_cull_spheres.clear();
+            m_cull_spheres.reserve(m_visible_intersecting.size());
+            for (auto index : m_visible_intersecting)
+                m_cull_spheres.push_back(m_entities.world_bounding_sphere(index));
+
+            frustum.test_spheres(m_cull_spheres, m_cull_visibility);
+            m_render_stats.sphere_tests = m_visible_intersecting.size();
+            for (size_t i = 0; i < m_visible_intersecting.size(); i++)
+            {
+                if (m_cull_visibility[i])
+                    m_visible_inside.push_back(m_visible_intersecting[i]);
+            }
+
+        }
+        else
+        {
+            m_visible_inside.resize(m_entities.size());
+            for (size_t i = 0; i < m_entities.size(); i++)
+                m_visible_inside[i] = i;
+        }
+
+        m_render_queue.begin(m_camera.view_matrix(), projection_matrix);
+        for (auto index : m_visible_inside)
+        {
+            const uint32_t lod = select_lod(index, projection_matrix, static_cast<float>(viewport[3]));
+            m_render_stats.reduced_lods += lod > 0 ? 1 : 0;
+            m_render_queue.push(m_entities.handles(index), m_entities.world_bounding_sphere(index).center, index, lod);
+        }
+        m_render_queue.sort();
+
+        // light lists only for the drawn entities, rebuilt every frame since lights and entities move
+        m_light_buffer->assign_entity_lights(*m_point_lights, *m_spot_lights, m_bvh, m_entities.world_aabbs(), m_visible_inside, m_bvh_proxies.size());
+        m_light_buffer->upload_and_bind(
+            *m_point_lights,
+            *m_spot_lights,
+            *m_directional_lights,
+            m_camera.view_matrix(),
+            projection_matrix,
+            glm::vec2(viewport[2], viewport[3])
+        );
+
+        upload_entity_data();
+
+        // draw entities follow the queue order, so every batch is a contiguous range of instances
+        const auto& items = m_render_queue.items();
+        m_draw_entity_buffer->begin_frame(items.size() * sizeof(DrawEntityData));
+        auto* draw_entities = reinterpret_cast<DrawEntityData*>(m_draw_entity_buffer->data());
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            const auto lights = m_light_buffer->entity_lights(items[i].entity_index);
+            draw_entities[i] = DrawEntityData{
+                .entity_index = items[i].entity_index,
+                .light_offset = lights.offset,
+                .point_light_count = lights.point_count,
+                .spot_light_count = lights.spot_count
+            };
+        }
+
+        m_entity_buffer->bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::ENTITIES);
+        m_draw_entity_buffer->bind_range(GL_SHADER_STORAGE_BUFFER, StorageBlockBinding::DRAW_ENTITIES);
+
+        m_draw_runs.clear();
+        for (size_t first = 0; first < items.size();)
+        {
+            const auto& handles = m_entities.handles(items[first].entity_index);
+            size_t last = first + 1;
+            while (last < items.size() and items[last].lod == items[first].lod and handles.can_batch_with(m_entities.handles(items[last].entity_index)))
+                last++;
+
+            m_draw_runs.push_back({static_cast<uint32_t>(first), static_cast<uint32_t>(last - first)});
+            first = last;
+        }
+
+        if (m_deferred_shading)
+            m_gbuffer->resize(viewport[2], viewport[3]);
+        const bool deferred = m_deferred_shading and m_gbuffer->is_valid();
+
+        // G-buffer runs go first, the partition keeps the queue order on both sides
+        size_t deferred_run_count = 0;
+        if (deferred)
+        {
+            const auto forward_runs = std::stable_partition(m_draw_runs.begin(), m_draw_runs.end(), [&](const DrawRun& run)
+            {
+                return m_entities.shader(items[run.first].entity_index).gbuffer_variant() != nullptr;
+            });
+            deferred_run_count = forward_runs - m_draw_runs.begin();
+        }
+
+        m_visible_meshlets.clear();
+        if (m_meshlet_culling)
+            cull_meshlets(m_frustum_culling ? &frustum : nullptr);
+
+        // every run owns the command slot at its index, visible meshlets follow, both passes share the region
+        m_meshlet_command_base = m_multi_draw_indirect ? m_draw_runs.size() : 0;
+        const bool indirect = m_multi_draw_indirect or not m_visible_meshlets.empty();
+        if (indirect)
+        {
+            m_indirect_buffer->begin_frame((m_meshlet_command_base + m_visible_meshlets.size()) * sizeof(DrawElementsIndirectCommand));
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect_buffer->id());
+
+            auto* commands = reinterpret_cast<DrawElementsIndirectCommand*>(m_indirect_buffer->data()) + m_meshlet_command_base;
+            for (const auto& run : m_draw_runs)
+            {
+                if (run.meshlet_command_count == 0)
+                    continue;
+
+                // the same vertex array render_meshlets picks, the pool one when multi draws use it
+                const Mesh& mesh = m_entities.mesh(items[run.first].entity_index);
+                const auto range = m_multi_draw_indirect ? m_geometry_pool->range_of(&mesh) : std::nullopt;
+                for (uint32_t i = 0; i < run.meshlet_command_count; i++)
+                {
+                    const Meshlet& meshlet = mesh.meshlets()[m_visible_meshlets[run.first_meshlet_command + i]];
+                    commands[run.first_meshlet_command + i] = DrawElementsIndirectCommand{
+                        .count = meshlet.index_count,
+                        .instance_count = 1,
+                        .first_index = (range ? range->first_index : 0) + meshlet.first_index,
+                        .base_vertex = range ? range->base_vertex : 0,
+                        .base_instance = run.first
+                    };
+                }
+            }
+        }
 
         glStencilMask(0xFF);
-        for (size_t i = 0; i < m_entities.size(); i++)
+        if (deferred)
         {
-            auto& entity = m_entities[i];
-            glStencilFunc(GL_ALWAYS, i + 1, 0xFF);
-            entity->render(view_projection_matrix);
+            m_gbuffer->begin_geometry_pass();
+            render_runs(0, deferred_run_count, true);
+            m_render_stats.gbuffer_draw_calls = m_render_stats.draw_calls;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            render_deferred_lighting();
         }
+        render_runs(deferred_run_count, m_draw_runs.size(), false);
+
+        if (indirect)
+            m_indirect_buffer->end_frame();
+        m_entity_buffer->end_frame();
+        m_draw_entity_buffer->end_frame();
+        m_light_buffer->end_frame();
+
+        m_render_stats.drawn = m_visible_inside.size();
+        m_render_stats.culled = m_entities.size() - m_visible_inside.size();
     }    
 
-    void Scene::update(const InputManager& input_manager, double delta_time)
+    void Scene::upload_entity_data() const
     {
-        m_camera.update(input_manager, delta_time);
-        for (const auto& entity : m_entities)
-            entity->update(*this, delta_time);
+        // material indices move when the registry deduplicates again
+        if (m_material_registry->upload_count() != m_material_upload_count)
+        {
+            m_material_upload_count = m_material_registry->upload_count();
+            m_entity_upload_frames.assign(m_entities.size(), StreamBuffer::REGION_COUNT);
+        }
+
+        if (m_entity_upload_frames.size() != m_entities.size())
+            m_entity_upload_frames.assign(m_entities.size(), StreamBuffer::REGION_COUNT);
+
+        if (m_entity_buffer->begin_frame(m_entities.size() * sizeof(EntityData)))
+            std::fill(m_entity_upload_frames.begin(), m_entity_upload_frames.end(), StreamBuffer::REGION_COUNT);
+
+        auto* entity_data = reinterpret_cast<EntityData*>(m_entity_buffer->data());
+        for (size_t i = 0; i < m_entities.size(); i++)
+        {
+            if (m_entity_upload_frames[i] == 0)
+                continue;
+
+            entity_data[i] = EntityData{
+                .model_matrix = m_entities.model_matrix(i),
+                .normal_matrix = glm::mat3x4(m_entities.normal_matrix(i)),
+                .material_index = static_cast<int32_t>(m_material_registry->index_of(m_entities.material(i).get())),
+                .padding = {}
+            };
+            m_entity_upload_frames[i]--;
+            m_render_stats.entity_uploads++;
+        }
     }
 
-    Scene& Scene::add_entity(std::unique_ptr<RenderableEntity> entity)
+    uint32_t Scene::select_lod(uint32_t entity, const glm::mat4& projection_matrix, float viewport_height) const
     {
-        m_entities.push_back(std::move(entity));
-        return *this;
+        const Mesh& mesh = m_entities.mesh(entity);
+        if (mesh.lods().size() < 2 or m_lod_pixel_error <= 0.0f)
+            return m_entity_lods[entity] = 0;
+
+        // the nearest point of the bounds decides, inside of them the entity is as close as it gets
+        const BoundingSphere& sphere = m_entities.world_bounding_sphere(entity);
+        const float distance = glm::length(sphere.center - m_camera.position()) - sphere.radius;
+        if (distance <= 0.0f)
+            return m_entity_lods[entity] = 0;
+
+        // world radius over mesh radius is the largest scale of the model matrix
+        const float mesh_radius = mesh.bounding_sphere().radius;
+        const float scale = mesh_radius > 0.0f ? sphere.radius / mesh_radius : 1.0f;
+        const float pixels_per_unit = scale * projection_matrix[1][1] * 0.5f * viewport_height / distance;
+        m_entity_lods[entity] = static_cast<uint8_t>(mesh.select_lod(pixels_per_unit, m_lod_pixel_error, m_entity_lods[entity]));
+        return m_entity_lods[entity];
+    }
+
+    uint32_t Scene::stencil_of(uint32_t first, uint32_t count) const
+    {
+        // stencil identifies single entities for picking, batches are resolved by pick()
+        const uint32_t entity_index = m_render_queue.items()[first].entity_index;
+        return count == 1 and entity_index + 1 < STENCIL_BATCHED ? entity_index + 1 : STENCIL_BATCHED;
+    }
+
+    void Scene::render_runs(size_t first_run, size_t end_run, bool gbuffer_pass) const
+    {
+        RenderState state;
+        state.gbuffer_pass = gbuffer_pass;
+        if (m_multi_draw_indirect)
+            render_indirect(state, first_run, end_run);
+        else
+            render_direct(state, first_run, end_run);
+
+        m_render_stats.program_binds += state.program_binds;
+        m_render_stats.vao_binds += state.vao_binds;
+        m_render_stats.texture_binds += state.texture_binds;
     }
 
-    Scene& Scene::add_entity(const SceneRenderableEntity& entity, AddEntityOptions options)
+    void Scene::render_direct(RenderState& state, size_t first_run, size_t end_run) const
     {
-        if (options & AddEntityOptions::PassCameraPostitionToShader)
+        const auto& items = m_render_queue.items();
+        for (size_t run_index = first_run; run_index < end_run; run_index++)
         {
-            m_camera_event_distributor->subscribe([shader = entity.shader.get()](const Camera& camera)
+            const auto& run = m_draw_runs[run_index];
+            if (run.meshlet_culled)
             {
-                shader->set_uniform("camera_position", camera.position());
-            });
+                render_meshlets(state, run);
+                continue;
+            }
+
+            const auto& item = items[run.first];
+            glStencilFunc(GL_ALWAYS, stencil_of(run.first, run.count), 0xFF);
+            m_entities.render(item.entity_index, state, run.first, run.count, item.lod);
+            m_render_stats.draw_calls++;
+            m_render_stats.triangles += size_t(m_entities.mesh(item.entity_index).lods()[item.lod].index_count / 3) * run.count;
         }
+    }
 
-        if (options & AddEntityOptions::PassLightToShader)
+    void Scene::render_indirect(RenderState& state, size_t first_run, size_t end_run) const
+    {
+        auto* commands = reinterpret_cast<DrawElementsIndirectCommand*>(m_indirect_buffer->data());
+
+        const auto& items = m_render_queue.items();
+        for (size_t run_index = first_run; run_index < end_run;)
         {
-            m_point_light_event_distributor->subscribe([shader = entity.shader.get(), lights = m_point_lights.get()](const PointLight& light)
+            const auto& run = m_draw_runs[run_index];
+            if (run.meshlet_culled)
             {
-                for (size_t i = 0; i < lights->size(); i++)
-                    LightUseVisitor{ *shader, i }(light);
-                
-                shader->set_uniform("light.num_point_lights", static_cast<int>(lights->size()));
-            });
+                render_meshlets(state, run);
+                run_index++;
+                continue;
+            }
 
-            m_spot_light_event_distributor->subscribe([shader = entity.shader.get(), lights = m_spot_lights.get()](const SpotLight& light)
+            const uint32_t entity = items[run.first].entity_index;
+            const auto range = m_geometry_pool->range_of(&m_entities.mesh(entity));
+            if (not range)
             {
-                for (size_t i = 0; i < lights->size(); i++)
-                    LightUseVisitor{ *shader, i }(light);
-                
-                shader->set_uniform("light.num_spot_lights", static_cast<int>(lights->size()));
-            });
+                glStencilFunc(GL_ALWAYS, stencil_of(run.first, run.count), 0xFF);
+                m_entities.render(entity, state, run.first, run.count, items[run.first].lod);
+                m_render_stats.draw_calls++;
+                m_render_stats.triangles += size_t(m_entities.mesh(entity).lods()[items[run.first].lod].index_count / 3) * run.count;
+                run_index++;
+                continue;
+            }
 
-            m_directional_light_event_distributor->subscribe([shader = entity.shader.get(), lights = m_directional_lights.get()](const DirectionalLight& light)
+            // runs come sorted by shader and textures first, so runs sharing them are adjacent
+            const size_t first_command = run_index;
+            uint32_t instance_count = 0;
+            for (; run_index < end_run; run_index++)
             {
-                for (size_t i = 0; i < lights->size(); i++)
-                    LightUseVisitor{ *shader, i }(light);
-                
-                shader->set_uniform("light.num_directional_lights", static_cast<int>(lights->size()));
-            });
+                const auto& next_run = m_draw_runs[run_index];
+                const uint32_t next_entity = items[next_run.first].entity_index;
+                const auto next_range = m_geometry_pool->range_of(&m_entities.mesh(next_entity));
+                if (not next_range or next_run.meshlet_culled or next_range->arena != range->arena or not m_entities.handles(entity).can_share_resources_with(m_entities.handles(next_entity)))
+                    break;
+
+                const MeshLod& lod = m_entities.mesh(next_entity).lods()[items[next_run.first].lod];
+                commands[run_index] = DrawElementsIndirectCommand{
+                    .count = lod.index_count,
+                    .instance_count = next_run.count,
+                    .first_index = next_range->first_index + lod.first_index,
+                    .base_vertex = next_range->base_vertex,
+                    .base_instance = next_run.first
+                };
+                instance_count += next_run.count;
+                m_render_stats.triangles += size_t(lod.index_count / 3) * next_run.count;
+            }
 
-            m_light_count_event_distributor->subscribe([shader = entity.shader.get()](const LightCountData& light_count_data)
+            m_entities.bind_resources(entity, state);
+            state.bind_vertex_array(m_geometry_pool->vertex_array(range->arena));
+            glStencilFunc(GL_ALWAYS, stencil_of(run.first, instance_count), 0xFF);
+            glMultiDrawElementsIndirect(
+                GL_TRIANGLES,
+                range->index_type,
+                reinterpret_cast<const void*>(m_indirect_buffer->offset() + first_command * sizeof(DrawElementsIndirectCommand)),
+                static_cast<GLsizei>(run_index - first_command),
+                0
+            );
+            m_render_stats.draw_calls++;
+            m_render_stats.indirect_commands += run_index - first_command;
+        }
+    }
+
+    void Scene::cull_meshlets(const Frustum* frustum) const
+    {
+        const auto& items = m_render_queue.items();
+        for (auto& run : m_draw_runs)
+        {
+            const uint32_t entity = items[run.first].entity_index;
+            const Mesh& mesh = m_entities.mesh(entity);
+            const auto& meshlets = mesh.meshlets();
+            if (run.count != 1 or items[run.first].lod != 0 or meshlets.size() < MIN_CULLED_MESHLETS)
+                continue;
+
+            const glm::mat4& model_matrix = m_entities.model_matrix(entity);
+            m_meshlet_spheres.clear();
+            m_meshlet_spheres.reserve(meshlets.size());
+            for (const auto& meshlet : meshlets)
+                m_meshlet_spheres.push_back(BoundingSphere{ .center = meshlet.center, .radius = meshlet.radius }.transformed(model_matrix));
+            if (frustum)
+                frustum->test_spheres(m_meshlet_spheres, m_meshlet_visibility);
+            else
+                m_meshlet_visibility.assign(meshlets.size(), 1);
+
+            // cones are tested in mesh space, mirrored entities show their back faces and skip the test
+            const glm::vec3 camera_position = glm::vec3(glm::inverse(model_matrix) * glm::vec4(m_camera.position(), 1.0f));
+            const bool mirrored = glm::determinant(glm::mat3(model_matrix)) < 0.0f;
+
+            run.meshlet_culled = true;
+            run.first_meshlet_command = static_cast<uint32_t>(m_visible_meshlets.size());
+            for (uint32_t i = 0; i < meshlets.size(); i++)
             {
-                shader->set_uniform("light.num_point_lights", static_cast<int>(light_count_data.point_light_count));
-                shader->set_uniform("light.num_spot_lights", static_cast<int>(light_count_data.spot_light_count));
-                shader->set_uniform("light.num_directional_lights", static_cast<int>(light_count_data.directional_light_count));
-            });
+                if (m_meshlet_visibility[i] and (mirrored or not meshlets[i].faces_away(camera_position)))
+                    m_visible_meshlets.push_back(i);
+            }
+            run.meshlet_command_count = static_cast<uint32_t>(m_visible_meshlets.size()) - run.first_meshlet_command;
+            m_render_stats.meshlets_drawn += run.meshlet_command_count;
+            m_render_stats.meshlets_culled += meshlets.size() - run.meshlet_command_count;
+        }
+    }
+
+    void Scene::render_meshlets(RenderState& state, const DrawRun& run) const
+    {
+        if (run.meshlet_command_count == 0)
+            return;
+
+        const uint32_t entity = m_render_queue.items()[run.first].entity_index;
+        const Mesh& mesh = m_entities.mesh(entity);
+        const auto range = m_multi_draw_indirect ? m_geometry_pool->range_of(&mesh) : std::nullopt;
+        m_entities.bind_resources(entity, state);
+        state.bind_vertex_array(range ? m_geometry_pool->vertex_array(range->arena) : mesh.vertex_array());
+        glStencilFunc(GL_ALWAYS, stencil_of(run.first, run.count), 0xFF);
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES,
+            range ? range->index_type : mesh.index_type(),
+            reinterpret_cast<const void*>(m_indirect_buffer->offset() + (m_meshlet_command_base + run.first_meshlet_command) * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(run.meshlet_command_count),
+            0
+        );
+        m_render_stats.draw_calls++;
+        m_render_stats.indirect_commands += run.meshlet_command_count;
+        for (uint32_t i = 0; i < run.meshlet_command_count; i++)
+            m_render_stats.triangles += mesh.meshlets()[m_visible_meshlets[run.first_meshlet_command + i]].index_count / 3;
+    }
+
+    void Scene::render_deferred_lighting() const
+    {
+        // forward draws and picking test against the deferred geometry
+        m_gbuffer->blit_depth_stencil(0);
 
-            entity.shader->set_uniform("light.num_point_lights", static_cast<int>(m_point_lights->size()));
-            entity.shader->set_uniform("light.num_spot_lights", static_cast<int>(m_spot_lights->size()));
-            entity.shader->set_uniform("light.num_directional_lights", static_cast<int>(m_directional_lights->size()));
+        // every entity drawn leaves a non zero stencil value, texels without one keep the skybox
+        glStencilMask(0x00);
+        glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+        glDisable(GL_DEPTH_TEST);
+        m_gbuffer->draw_lighting_pass(*m_deferred_lighting_shader);
+        glEnable(GL_DEPTH_TEST);
+        glStencilMask(0xFF);
+        m_render_stats.draw_calls++;
+    }
+
+    void Scene::update(const InputManager& input_manager, double delta_time)
+    {
+        m_camera.update(input_manager, delta_time);
+        m_time += delta_time;
+
+        // transforms only change through set_transform, static entities cost nothing here
+        for (auto index : m_transform_store.update(m_job_system))
+        {
+            if (not m_animator.animates(index))
+                m_transform_hierarchy.set_local_matrix(index, m_transform_store.model_matrix(index));
         }
 
-        m_entities.push_back(std::make_unique<RenderableEntity>(
-            entity.shader,
-            entity.mesh,
-            entity.textures,
-            entity.transform,
-            entity.material,
-            entity.transform_modifier
-        ));
-        return *this;
+        // every animated entity is sampled in one pass over the track arrays
+        m_animator.sample(m_time, m_transform_store, m_animated_local_matrices, m_job_system);
+        const auto& animated = m_animator.animated();
+        for (size_t i = 0; i < animated.size(); i++)
+            m_transform_hierarchy.set_local_matrix(animated[i], m_animated_local_matrices[i]);
+        m_update_stats.animated_entities = animated.size();
+
+        update_transforms();
+        update_replaced_meshes();
     }
 
-    Scene& Scene::add_light(const PointLight& light)
+    void Scene::update_replaced_meshes()
     {
-        if (m_point_lights->size() >= PointLight::MAX_POINT_LIGHTS)
+        // meshes streamed in by the AssetLoader replace their placeholder geometry between frames
+        m_replaced_meshes.clear();
+        m_remeshed_entities.clear();
+        m_entities.refresh_replaced_meshes(m_replaced_meshes, m_remeshed_entities);
+        for (const auto& mesh : m_replaced_meshes)
+            m_geometry_pool->add(mesh);
+
+        if (not m_remeshed_entities.empty())
+            update_spatial_index(m_remeshed_entities);
+    }
+
+    void Scene::update_transforms()
+    {
+        // only moved entities and their descendants get a new model matrix, upload and bounds
+        // the hierarchy pass stays serial, parents have to be done before their children
+        const auto& moved_entities = m_transform_hierarchy.update();
+        m_moved_model_matrices.resize(moved_entities.size());
+        m_moved_normal_matrices.resize(moved_entities.size());
+
+        // every moved entity writes only its own slots, chunks run in parallel
+        parallel_for(m_job_system, static_cast<uint32_t>(moved_entities.size()), ENTITIES_PER_JOB, [&](uint32_t begin, uint32_t end)
         {
-            YAZPGP_LOG_WARN("Maximum number of lights reached, ignoring light");
-            return *this;
+            for (uint32_t i = begin; i < end; i++)
+                m_moved_model_matrices[i] = m_transform_hierarchy.world_matrix(moved_entities[i]);
+
+            compute_normal_matrices(m_moved_model_matrices.data() + begin, end - begin, m_moved_normal_matrices.data() + begin);
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const auto index = moved_entities[i];
+                m_entities.set_world_matrix(index, m_moved_model_matrices[i], m_moved_normal_matrices[i]);
+                m_entity_upload_frames[index] = StreamBuffer::REGION_COUNT;
+            }
+        });
+        m_update_stats.transform_updates = moved_entities.size();
+
+        update_spatial_index(moved_entities);
+    }
+
+    void Scene::update_spatial_index(const std::vector<uint32_t>& moved_entities)
+    {
+        const size_t indexed_count = m_bvh_proxies.size();
+        const size_t pending_count = m_entities.size() - indexed_count;
+
+        // bulk loads get a full SAH build, a few new entities are inserted one by one
+        if (pending_count > 0 and pending_count >= std::max<size_t>(64, indexed_count))
+        {
+            std::vector<Bvh::Item> items(m_entities.size());
+            for (size_t i = 0; i < m_entities.size(); i++)
+                items[i] = { m_entities.world_aabb(i), static_cast<uint32_t>(i) };
+
+            m_bvh.build(items, m_bvh_proxies, m_job_system);
+            return;
         }
 
+        for (auto index : moved_entities)
+        {
+            if (index < indexed_count)
+                m_bvh.update(m_bvh_proxies[index], m_entities.world_aabb(index));
+        }
+
+        for (size_t i = indexed_count; i < m_entities.size(); i++)
+            m_bvh_proxies.push_back(m_bvh.insert(m_entities.world_aabb(i), static_cast<uint32_t>(i)));
+    }
+
+    Scene& Scene::add_entity(const SceneRenderableEntity& entity)
+    {
+        m_material_registry->add(entity.material);
+        m_geometry_pool->add(entity.mesh);
+        m_entity_upload_frames.push_back(StreamBuffer::REGION_COUNT);
+        m_entity_lods.push_back(0);
+        m_entities.add(entity.shader, entity.mesh, entity.textures, entity.material);
+
+        const auto parent = entity.parent
+            ? static_cast<uint32_t>(*entity.parent)
+            : TransformHierarchy::NO_PARENT;
+        // local and world matrices are composed by the next update
+        m_transform_hierarchy.add(glm::mat4(1.0f), parent);
+        m_transform_store.add(entity.transform);
+        m_animator.add(entity.animation);
+        return *this;
+    }
+
+    Scene& Scene::add_light(const PointLight& light)
+    {
         auto copy = light;
         copy.set_notify_callback([event_distributor = m_point_light_event_distributor.get()](const PointLight& light)
         {
@@ -146,12 +597,6 @@ namespace yazpgp
 
     Scene& Scene::add_light(const SpotLight& light)
     {
-        if (m_spot_lights->size() >= SpotLight::MAX_SPOT_LIGHTS)
-        {
-            YAZPGP_LOG_WARN("Maximum number of lights reached, ignoring light");
-            return *this;
-        }
-
         auto copy = light;
 
         copy.set_notify_callback([event_distributor = m_spot_light_event_distributor.get()](const SpotLight& light)
@@ -194,6 +639,155 @@ namespace yazpgp
         return *this;
     }
 
+    Scene& Scene::set_frustum_culling(bool enabled)
+    {
+        m_frustum_culling = enabled;
+        return *this;
+    }
+
+    Scene& Scene::set_deferred_shading(std::shared_ptr<Shader> lighting_shader)
+    {
+        m_deferred_lighting_shader = std::move(lighting_shader);
+        m_deferred_shading = m_deferred_lighting_shader != nullptr;
+        return *this;
+    }
+
+    Scene& Scene::set_lod_pixel_error(float pixels)
+    {
+        m_lod_pixel_error = pixels;
+        return *this;
+    }
+
+    Scene& Scene::set_meshlet_culling(bool enabled)
+    {
+        m_meshlet_culling = enabled;
+        return *this;
+    }
+
+    Scene& Scene::set_job_system(JobSystem* job_system)
+    {
+        m_job_system = job_system;
+        return *this;
+    }
+
+    Scene& Scene::set_multi_draw_indirect(bool enabled)
+    {
+        m_multi_draw_indirect = enabled;
+        return *this;
+    }
+
+    Scene& Scene::remove_entity(size_t index)
+    {
+        if (index >= m_entities.size())
+        {
+            YAZPGP_LOG_ERROR("Entity index %zu out of range", index);
+            return *this;
+        }
+
+        m_entities.remove(static_cast<uint32_t>(index));
+        m_transform_hierarchy.remove(static_cast<uint32_t>(index));
+        m_transform_store.remove(static_cast<uint32_t>(index));
+        m_animator.remove(static_cast<uint32_t>(index));
+        // every entity behind the removed one moved to a new slot of the entity buffer
+        m_entity_upload_frames.resize(m_entities.size());
+        std::fill(m_entity_upload_frames.begin() + index, m_entity_upload_frames.end(), StreamBuffer::REGION_COUNT);
+        m_entity_lods.erase(m_entity_lods.begin() + index);
+        if (index < m_bvh_proxies.size())
+        {
+            m_bvh.remove(m_bvh_proxies[index]);
+            m_bvh_proxies.erase(m_bvh_proxies.begin() + index);
+            for (size_t i = index; i < m_bvh_proxies.size(); i++)
+                m_bvh.set_user_data(m_bvh_proxies[i], static_cast<uint32_t>(i));
+        }
+        return *this;
+    }
+
+    Scene& Scene::set_animation(size_t index, const Animation& animation)
+    {
+        if (index >= m_entities.size())
+        {
+            YAZPGP_LOG_ERROR("Entity index %zu out of range", index);
+            return *this;
+        }
+
+        m_animator.set(static_cast<uint32_t>(index), animation);
+        // a dropped animation leaves the entity at its plain transform
+        if (animation.empty())
+            m_transform_hierarchy.set_local_matrix(index, m_transform_store.model_matrix(index));
+        return *this;
+    }
+
+    Scene& Scene::set_transform(size_t index, const Transform& transform)
+    {
+        if (index >= m_entities.size())
+        {
+            YAZPGP_LOG_ERROR("Entity index %zu out of range", index);
+            return *this;
+        }
+
+        m_transform_store.set(static_cast<uint32_t>(index), transform);
+        return *this;
+    }
+
+    Scene& Scene::rebuild_spatial_index()
+    {
+        m_bvh.clear();
+        m_bvh_proxies.clear();
+        return *this;
+    }
+
+    std::optional<size_t> Scene::pick(uint32_t stencil_value, const glm::vec3& world_position) const
+    {
+        if (stencil_value == 0)
+            return std::nullopt;
+
+        if (stencil_value < STENCIL_BATCHED)
+            return stencil_value - 1;
+
+        // instanced draws share one stencil value, find the tightest box around the point under the cursor
+        constexpr float tolerance = 1e-3f;
+        const AABB probe{ world_position - glm::vec3(tolerance), world_position + glm::vec3(tolerance) };
+        std::vector<uint32_t> candidates;
+        m_bvh.query_aabb(probe, candidates);
+
+        std::optional<size_t> result;
+        float best_area = std::numeric_limits<float>::max();
+        for (auto index : candidates)
+        {
+            const AABB& aabb = m_entities.world_aabb(index);
+            if (not aabb.intersects(probe))
+                continue;
+
+            const float area = aabb.surface_area();
+            if (area < best_area)
+            {
+                best_area = area;
+                result = index;
+            }
+        }
+        return result;
+    }
+
+    const Bvh& Scene::spatial_index() const
+    {
+        return m_bvh;
+    }
+
+    const Scene::RenderStats& Scene::render_stats() const
+    {
+        return m_render_stats;
+    }
+
+    const Scene::UpdateStats& Scene::update_stats() const
+    {
+        return m_update_stats;
+    }
+
+    const TransformHierarchy& Scene::transform_hierarchy() const
+    {
+        return m_transform_hierarchy;
+    }
+
     Camera& Scene::camera()
     {
         return m_camera;
@@ -211,14 +805,6 @@ namespace yazpgp
         for (const auto& light : *m_directional_lights)
             m_directional_light_event_distributor->notify(light);
 
-        m_light_count_event_distributor->notify(
-            LightCountData{ 
-                m_point_lights->size(),
-                m_spot_lights->size(),
-                m_directional_lights->size()
-            }
-        );
-            
         return *this;
     }
 
@@ -234,8 +820,13 @@ namespace yazpgp
         return *this;
     }
 
-    std::vector<std::unique_ptr<RenderableEntity>>& Scene::entities()
+    size_t Scene::entity_count() const
+    {
+        return m_entities.size();
+    }
+
+    Transform Scene::transform(size_t index) const
     {
-        return m_entities;
+        return m_transform_store.transform(static_cast<uint32_t>(index));
     }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "shader.hpp"
 #include "logger.hpp"
+#include "uniform_block_bindings.hpp"
 #include <memory>
+#include <cstring>
+#include <algorithm>
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -79,12 +82,26 @@ namespace yazpgp
     std::shared_ptr<Shader> Shader::create_default_shader(float r, float g, float b, float a)
     {
         const std::string default_vertex_shader =
-            "#version 330\n"
+            "#version 460\n"
             "layout(location=0) in vec3 vp;"
-            "uniform mat4 view_projection_matrix;"
-            "uniform mat4 mvp_matrix;"
+            "struct EntityData {"
+            "    mat4 model_matrix;"
+            "    mat3 normal_matrix;"
+            "    int material_index;"
+            "};"
+            "layout(std430) readonly buffer EntityBlock { EntityData entities[]; };"
+            "layout(std430) readonly buffer DrawEntityBlock { uvec4 draw_entities[]; };"
+            "layout(std140) uniform FrameBlock {"
+            "    mat4 view_matrix;"
+            "    mat4 projection_matrix;"
+            "    mat4 view_projection_matrix;"
+            "    mat4 inverse_view_projection_matrix;"
+            "    vec3 camera_position;"
+            "    float time;"
+            "};"
             "void main () {"
-            "     gl_Position = mvp_matrix * vec4 (vp, 1.0);"
+            "     mat4 model_matrix = entities[draw_entities[gl_BaseInstance + gl_InstanceID].x].model_matrix;"
+            "     gl_Position = view_projection_matrix * model_matrix * vec4 (vp, 1.0);"
             "}";
 
 
@@ -97,6 +114,13 @@ namespace yazpgp
         return create_shader(default_vertex_shader, default_fragment_shader);
     }
 
+    Shader::Shader(ShaderProgramId linked_program)
+        : m_program(linked_program)
+    {
+        reflect_uniforms();
+        bind_blocks();
+    }
+
     void Shader::use() const
     {
         glUseProgram(m_program);
@@ -108,46 +132,219 @@ namespace yazpgp
         YAZPGP_LOG_DEBUG("Shader deleted id: %d", m_program);
     }
 
-    void Shader::set_uniform(const std::string& name, const glm::mat4& value) const
+    void Shader::reflect_uniforms()
+    {
+        GLint uniform_count = 0;
+        GLint max_name_length = 0;
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &uniform_count);
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+        auto add_slot = [&](const std::string& name, GLenum type) {
+            const GLint location = glGetUniformLocation(m_program, name.c_str());
+            // uniforms in blocks have no location
+            if (location < 0)
+                return;
+
+            m_slot_by_name.emplace(name, static_cast<int32_t>(m_slots.size()));
+            m_slots.push_back(UniformSlot{ .location = location, .type = type });
+
+            // samplers get the texture unit from their name, texture_1 -> 1, fs_tex0 -> 0, skybox -> 0
+            const bool is_sampler = type == GL_SAMPLER_2D or type == GL_SAMPLER_CUBE or type == GL_UNSIGNED_INT_SAMPLER_2D;
+            if (is_sampler)
+            {
+                const size_t digits = name.find_last_not_of("0123456789") + 1;
+                const int unit = digits < name.size() ? std::stoi(name.substr(digits)) : 0;
+                upload(m_slots.size() - 1, unit);
+            }
+        };
+
+        std::string name_buffer(max_name_length, '\0');
+        for (GLint i = 0; i < uniform_count; i++)
+        {
+            GLint array_size = 0;
+            GLenum type = 0;
+            GLsizei name_length = 0;
+            glGetActiveUniform(m_program, i, max_name_length, &name_length, &array_size, &type, name_buffer.data());
+            std::string name(name_buffer.data(), name_length);
+
+            // arrays of basic types are reported once as name[0], every element gets its own slot
+            if (array_size > 1 and name.ends_with("[0]"))
+            {
+                const std::string base_name = name.substr(0, name.size() - 3);
+                for (GLint element = 0; element < array_size; element++)
+                    add_slot(base_name + "[" + std::to_string(element) + "]", type);
+                // the bare name is the first element, sharing its slot keeps a single shadow copy
+                const auto first_element = m_slot_by_name.find(name);
+                if (first_element != m_slot_by_name.end())
+                    m_slot_by_name.emplace(base_name, first_element->second);
+                continue;
+            }
+
+            add_slot(name, type);
+        }
+
+        YAZPGP_LOG_DEBUG("Shader %d has %zu active uniforms", m_program, m_slots.size());
+    }
+
+    void Shader::bind_blocks()
+    {
+        GLint block_count = 0;
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+        for (GLint i = 0; i < block_count; i++)
+        {
+            GLchar name[128];
+            GLsizei name_length = 0;
+            glGetActiveUniformBlockName(m_program, i, sizeof(name), &name_length, name);
+
+            const std::string_view block_name(name, name_length);
+            auto it = std::find_if(UniformBlockBinding::BLOCKS.begin(), UniformBlockBinding::BLOCKS.end(), [&](const auto& block) {
+                return block.first == block_name;
+            });
+
+            if (it == UniformBlockBinding::BLOCKS.end())
+            {
+                YAZPGP_LOG_WARN("Shader %d has unknown uniform block %s", m_program, name);
+                continue;
+            }
+
+            glUniformBlockBinding(m_program, i, it->second);
+        }
+
+        GLint storage_block_count = 0;
+        glGetProgramInterfaceiv(m_program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &storage_block_count);
+        for (GLint i = 0; i < storage_block_count; i++)
+        {
+            GLchar name[128];
+            GLsizei name_length = 0;
+            glGetProgramResourceName(m_program, GL_SHADER_STORAGE_BLOCK, i, sizeof(name), &name_length, name);
+
+            const std::string_view block_name(name, name_length);
+            auto it = std::find_if(StorageBlockBinding::BLOCKS.begin(), StorageBlockBinding::BLOCKS.end(), [&](const auto& block) {
+                return block.first == block_name;
+            });
+
+            if (it == StorageBlockBinding::BLOCKS.end())
+            {
+                YAZPGP_LOG_WARN("Shader %d has unknown storage block %s", m_program, name);
+                continue;
+            }
+
+            glShaderStorageBlockBinding(m_program, i, it->second);
+        }
+    }
+
+    int32_t Shader::find_slot(std::string_view name) const
+    {
+        auto it = m_slot_by_name.find(name);
+        return it == m_slot_by_name.end() ? -1 : it->second;
+    }
+
+    int32_t Shader::resolve(std::string_view name, GLenum type) const
+    {
+        const int32_t slot = find_slot(name);
+        if (slot < 0)
+            return -1;
+
+        const GLenum slot_type = m_slots[slot].type;
+        const bool int_like = type == GL_INT and (slot_type == GL_BOOL or slot_type == GL_SAMPLER_2D or slot_type == GL_SAMPLER_CUBE or slot_type == GL_UNSIGNED_INT_SAMPLER_2D);
+        if (slot_type != type and not int_like)
+        {
+            YAZPGP_LOG_WARN("Uniform %.*s of shader %d has a different type than requested", static_cast<int>(name.size()), name.data(), m_program);
+            return -1;
+        }
+        return slot;
+    }
+
+    bool Shader::has_uniform(std::string_view name) const
+    {
+        return find_slot(name) >= 0;
+    }
+
+    void Shader::set_gbuffer_variant(std::shared_ptr<Shader> variant)
+    {
+        m_gbuffer_variant = std::move(variant);
+    }
+
+    const std::shared_ptr<Shader>& Shader::gbuffer_variant() const
+    {
+        return m_gbuffer_variant;
+    }
+
+    bool Shader::shadow_changed(int32_t slot, const void* value, size_t size_bytes) const
+    {
+        auto& uniform = m_slots[slot];
+        if (uniform.initialized and std::memcmp(uniform.shadow.data(), value, size_bytes) == 0)
+            return false;
+
+        std::memcpy(uniform.shadow.data(), value, size_bytes);
+        uniform.initialized = true;
+        return true;
+    }
+
+    void Shader::upload(int32_t slot, const glm::mat4& value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, glm::value_ptr(value), sizeof(value)))
+            glProgramUniformMatrix4fv(m_program, m_slots[slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void Shader::upload(int32_t slot, const glm::mat3& value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, glm::value_ptr(value), sizeof(value)))
+            glProgramUniformMatrix3fv(m_program, m_slots[slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void Shader::upload(int32_t slot, const glm::vec3& value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, glm::value_ptr(value), sizeof(value)))
+            glProgramUniform3fv(m_program, m_slots[slot].location, 1, glm::value_ptr(value));
+    }
+
+    void Shader::upload(int32_t slot, const glm::vec4& value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, glm::value_ptr(value), sizeof(value)))
+            glProgramUniform4fv(m_program, m_slots[slot].location, 1, glm::value_ptr(value));
+    }
+
+    void Shader::upload(int32_t slot, const float value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, &value, sizeof(value)))
+            glProgramUniform1f(m_program, m_slots[slot].location, value);
+    }
+
+    void Shader::upload(int32_t slot, const int value) const
+    {
+        if (slot >= 0 and shadow_changed(slot, &value, sizeof(value)))
+            glProgramUniform1i(m_program, m_slots[slot].location, value);
+    }
+
+    void Shader::set_uniform(std::string_view name, const glm::mat4& value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
-        glProgramUniformMatrix4fv(m_program, location, 1, GL_FALSE, glm::value_ptr(value));
+        upload(find_slot(name), value);
     }
 
-    void Shader::set_uniform(const std::string& name, const glm::mat3& value) const
+    void Shader::set_uniform(std::string_view name, const glm::mat3& value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
-        glProgramUniformMatrix3fv(m_program, location, 1, GL_FALSE, glm::value_ptr(value));
+        upload(find_slot(name), value);
     }
 
-    void Shader::set_uniform(const std::string& name, const glm::vec3& value) const
+    void Shader::set_uniform(std::string_view name, const glm::vec3& value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniform3fv(location, 1, glm::value_ptr(value));
-        glProgramUniform3fv(m_program, location, 1, glm::value_ptr(value));
+        upload(find_slot(name), value);
     }
 
-    void Shader::set_uniform(const std::string& name, const glm::vec4& value) const
+    void Shader::set_uniform(std::string_view name, const glm::vec4& value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniform4fv(location, 1, glm::value_ptr(value));
-        glProgramUniform4fv(m_program, location, 1, glm::value_ptr(value));
+        upload(find_slot(name), value);
     }
 
-    void Shader::set_uniform(const std::string& name, const float value) const
+    void Shader::set_uniform(std::string_view name, const float value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniform1f(location, value);
-        glProgramUniform1f(m_program, location, value);
+        upload(find_slot(name), value);
     }
 
-    void Shader::set_uniform(const std::string& name, const int value) const
+    void Shader::set_uniform(std::string_view name, const int value) const
     {
-        auto location = glGetUniformLocation(m_program, name.c_str());
-        // glUniform1i(location, value);
-        glProgramUniform1i(m_program, location, value);
+        upload(find_slot(name), value);
     }
 
     void Shader::unuse()
@@ -5,6 +5,7 @@ namespace yazpgp
         : m_cubemap(cubemap)
         , m_shader(shader)
         , m_cube_mesh(Mesh::create_cube())
+        , m_view_projection_uniform(shader->uniform<glm::mat4>("view_projection_matrix"))
     {
     }
     
@@ -18,10 +19,10 @@ namespace yazpgp
         auto view_only_rotation = glm::mat4(glm::mat3(view_matrix));
         glDepthMask(GL_FALSE);
         m_shader->use();
-        m_shader->set_uniform("view_projection_matrix", projection_matrix * view_only_rotation);
+        m_view_projection_uniform.set(projection_matrix * view_only_rotation);
         m_cubemap->use(0);
         m_cube_mesh->use();
-        glDrawArrays(GL_TRIANGLES, 0, m_cube_mesh->get_vert_count());
+        glDrawElements(GL_TRIANGLES, m_cube_mesh->get_index_count(), m_cube_mesh->index_type(), 0);
         glDepthMask(GL_TRUE);
     }
 
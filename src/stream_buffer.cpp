@@ -0,0 +1,124 @@
+#include "stream_buffer.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+
+namespace yazpgp
+{
+    namespace
+    {
+        constexpr GLbitfield MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        constexpr GLuint64 WAIT_TIMEOUT_NS = 1'000'000'000;
+
+        size_t region_alignment()
+        {
+            GLint uniform_alignment = 0;
+            GLint storage_alignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+            return std::max<size_t>({256, static_cast<size_t>(uniform_alignment), static_cast<size_t>(storage_alignment)});
+        }
+    }
+
+    StreamBuffer::~StreamBuffer()
+    {
+        for (auto& fence : m_fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+
+        if (m_buffer)
+        {
+            glUnmapNamedBuffer(m_buffer);
+            glDeleteBuffers(1, &m_buffer);
+        }
+    }
+
+    bool StreamBuffer::begin_frame(size_t region_size_bytes)
+    {
+        if (region_size_bytes > m_region_size or not m_buffer)
+        {
+            allocate(std::max(region_size_bytes, m_region_size * 2));
+            return true;
+        }
+
+        wait(m_region);
+        return false;
+    }
+
+    void StreamBuffer::end_frame()
+    {
+        if (m_fences[m_region])
+            glDeleteSync(m_fences[m_region]);
+
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_region = (m_region + 1) % REGION_COUNT;
+    }
+
+    std::byte* StreamBuffer::data() const
+    {
+        return m_mapped + offset();
+    }
+
+    size_t StreamBuffer::offset() const
+    {
+        return m_region * m_region_size;
+    }
+
+    GLuint StreamBuffer::id() const
+    {
+        return m_buffer;
+    }
+
+    void StreamBuffer::bind_range(GLenum target, GLuint index) const
+    {
+        glBindBufferRange(target, index, m_buffer, offset(), m_region_size);
+    }
+
+    void StreamBuffer::allocate(size_t region_size_bytes)
+    {
+        for (size_t region = 0; region < REGION_COUNT; region++)
+            wait(region);
+
+        if (m_buffer)
+        {
+            glUnmapNamedBuffer(m_buffer);
+            glDeleteBuffers(1, &m_buffer);
+        }
+
+        // regions are bound as uniform or storage ranges, so their offsets have to be aligned
+        const size_t alignment = region_alignment();
+        m_region_size = (std::max<size_t>(region_size_bytes, 1) + alignment - 1) / alignment * alignment;
+        m_region = 0;
+
+        glCreateBuffers(1, &m_buffer);
+        glNamedBufferStorage(m_buffer, m_region_size * REGION_COUNT, nullptr, MAP_FLAGS);
+        m_mapped = static_cast<std::byte*>(glMapNamedBufferRange(m_buffer, 0, m_region_size * REGION_COUNT, MAP_FLAGS));
+        YAZPGP_LOG_ERROR_IF(not m_mapped, "Failed to map stream buffer %d", m_buffer);
+        YAZPGP_LOG_DEBUG("Stream buffer %d allocated with %zu regions of %zu bytes", m_buffer, REGION_COUNT, m_region_size);
+    }
+
+    void StreamBuffer::wait(size_t region)
+    {
+        GLsync& fence = m_fences[region];
+        if (not fence)
+            return;
+
+        while (true)
+        {
+            const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+            if (result == GL_ALREADY_SIGNALED or result == GL_CONDITION_SATISFIED)
+                break;
+
+            if (result == GL_WAIT_FAILED)
+            {
+                YAZPGP_LOG_ERROR("Waiting for stream buffer %d region %zu failed", m_buffer, region);
+                break;
+            }
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -6,6 +6,28 @@ namespace yazpgp
     Texture2D::Texture2D(const char* bytes, uint32_t width, uint32_t height, uint32_t channels)
     {
         glGenTextures(1, &m_texture);
+        upload(bytes, width, height, channels);
+    }
+
+    Texture2D::Texture2D(GLenum internal_format, GLenum format, std::span<const TextureLevel> levels)
+    {
+        glGenTextures(1, &m_texture);
+        upload_levels(internal_format, format, levels);
+    }
+
+    void Texture2D::reset_immutable()
+    {
+        if (not m_immutable)
+            return;
+
+        glDeleteTextures(1, &m_texture);
+        glGenTextures(1, &m_texture);
+        m_immutable = false;
+    }
+
+    void Texture2D::upload(const char* bytes, uint32_t width, uint32_t height, uint32_t channels)
+    {
+        reset_immutable();
         glBindTexture(GL_TEXTURE_2D, m_texture);
         auto mode = channels == 4 ? GL_RGBA : GL_RGB;
         glTexImage2D(GL_TEXTURE_2D, 0, mode, width, height, 0, mode, GL_UNSIGNED_BYTE, bytes);
@@ -35,6 +57,24 @@ namespace yazpgp
 
     }
 
+    void Texture2D::upload_levels(GLenum internal_format, GLenum format, std::span<const TextureLevel> levels)
+    {
+        reset_immutable();
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        glTexStorage2D(GL_TEXTURE_2D, levels.size(), internal_format, levels[0].width, levels[0].height);
+        for (size_t level = 0; level < levels.size(); level++)
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levels[level].width, levels[level].height, format, GL_UNSIGNED_BYTE, levels[level].bytes);
+        m_immutable = true;
+
+        // the chain is complete, so minification can blend between levels
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        YAZPGP_LOG_DEBUG("Texture loaded: %d (%dx%d, %zu levels)", m_texture, levels[0].width, levels[0].height, levels.size());
+    }
+
     void Texture2D::use(uint32_t texture_slot) const
     {
         YAZPGP_LOG_FATAL_IF(texture_slot > 31, "Texture slot must be between 0 and 31");
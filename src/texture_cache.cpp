@@ -0,0 +1,324 @@
+#include "texture_cache.hpp"
+#include "io.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+namespace yazpgp
+{
+    namespace io
+    {
+        namespace
+        {
+            constexpr char MAGIC[4] = { 'Y', 'Z', 'T', 'X' };
+            // bumped whenever the layout of the file or the cooking changes
+            constexpr uint32_t FORMAT_VERSION = 1;
+            constexpr uint64_t LEVEL_ALIGNMENT = 16;
+
+            struct TextureCacheHeader
+            {
+                char magic[4];
+                uint32_t version;
+                uint64_t source_hash;
+                uint64_t source_size;
+                uint32_t internal_format;
+                uint32_t format;
+                uint32_t face_count;
+                uint32_t level_count;
+            };
+
+            // followed by face_count * level_count of these, then the level data
+            struct CachedLevel
+            {
+                uint64_t offset;
+                int32_t width;
+                int32_t height;
+            };
+            static_assert(std::is_trivially_copyable_v<TextureCacheHeader> and std::is_trivially_copyable_v<CachedLevel>);
+
+            struct SourceKey
+            {
+                uint64_t hash;
+                uint64_t size;
+            };
+
+            size_t row_stride(int32_t width, uint32_t channels)
+            {
+                return (static_cast<size_t>(width) * channels + 3) & ~size_t(3);
+            }
+
+            uint64_t align_up(uint64_t offset)
+            {
+                return (offset + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+            }
+
+            std::optional<SourceKey> source_key(const std::string& path)
+            {
+                auto source = MappedFile::create(path);
+                if (not source)
+                {
+                    YAZPGP_LOG_ERROR("Failed to open image file: %s", path.c_str());
+                    return std::nullopt;
+                }
+                return SourceKey{ source->hash(), source->size() };
+            }
+
+            std::string cache_file_path(const std::string& cache_directory, uint64_t source_hash, const char* kind)
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "%016llx-%s.tex", static_cast<unsigned long long>(source_hash), kind);
+                return (std::filesystem::path(cache_directory) / name).string();
+            }
+
+            // 2x2 box filter, odd sizes reuse their last row or column
+            ImageData downsample(const ImageData& image)
+            {
+                ImageData half{
+                    .bytes = {},
+                    .width = std::max(image.width / 2, 1),
+                    .height = std::max(image.height / 2, 1),
+                    .channels = image.channels
+                };
+                const size_t source_stride = row_stride(image.width, image.channels);
+                const size_t half_stride = row_stride(half.width, half.channels);
+                half.bytes.resize(half_stride * half.height);
+
+                const auto* source = reinterpret_cast<const unsigned char*>(image.bytes.data());
+                auto* target = reinterpret_cast<unsigned char*>(half.bytes.data());
+                for (int32_t y = 0; y < half.height; y++)
+                {
+                    const unsigned char* row0 = source + std::min(2 * y, image.height - 1) * source_stride;
+                    const unsigned char* row1 = source + std::min(2 * y + 1, image.height - 1) * source_stride;
+                    for (int32_t x = 0; x < half.width; x++)
+                    {
+                        const size_t x0 = std::min(2 * x, image.width - 1) * image.channels;
+                        const size_t x1 = std::min(2 * x + 1, image.width - 1) * image.channels;
+                        for (uint32_t c = 0; c < image.channels; c++)
+                        {
+                            const uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                            target[y * half_stride + x * half.channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                        }
+                    }
+                }
+                return half;
+            }
+
+            // drops or adds channels, added ones are opaque
+            ImageData with_channels(ImageData image, uint32_t channels)
+            {
+                if (image.channels == channels)
+                    return image;
+
+                ImageData converted{
+                    .bytes = std::vector<char>(row_stride(image.width, channels) * image.height),
+                    .width = image.width,
+                    .height = image.height,
+                    .channels = channels
+                };
+                const size_t source_stride = row_stride(image.width, image.channels);
+                const size_t converted_stride = row_stride(image.width, channels);
+                for (int32_t y = 0; y < image.height; y++)
+                {
+                    for (int32_t x = 0; x < image.width; x++)
+                    {
+                        for (uint32_t c = 0; c < channels; c++)
+                        {
+                            converted.bytes[y * converted_stride + x * channels + c] = c < image.channels
+                                ? image.bytes[y * source_stride + x * image.channels + c]
+                                : '\xff';
+                        }
+                    }
+                }
+                return converted;
+            }
+
+            std::vector<ImageData> mip_chain(ImageData image)
+            {
+                std::vector<ImageData> levels;
+                levels.push_back(std::move(image));
+                while (levels.back().width > 1 or levels.back().height > 1)
+                    levels.push_back(downsample(levels.back()));
+                return levels;
+            }
+
+            std::optional<CookedTexture> parse(const std::byte* data, size_t size, const SourceKey& key)
+            {
+                if (size < sizeof(TextureCacheHeader))
+                    return std::nullopt;
+
+                TextureCacheHeader header;
+                std::memcpy(&header, data, sizeof(header));
+                const bool matches = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+                    and header.version == FORMAT_VERSION
+                    and header.source_hash == key.hash
+                    and header.source_size == key.size
+                    and header.level_count > 0;
+                if (not matches)
+                    return std::nullopt;
+
+                const uint32_t channels = header.format == GL_RGBA ? 4 : 3;
+                const uint64_t level_count = uint64_t(header.face_count) * header.level_count;
+                if (sizeof(header) + level_count * sizeof(CachedLevel) > size)
+                    return std::nullopt;
+
+                CookedTexture cooked{
+                    .internal_format = header.internal_format,
+                    .format = header.format,
+                    .face_count = header.face_count,
+                    .level_count = header.level_count,
+                    .levels = std::vector<TextureLevel>(level_count),
+                    .file = nullptr,
+                    .bytes = {}
+                };
+                for (size_t i = 0; i < level_count; i++)
+                {
+                    CachedLevel level;
+                    std::memcpy(&level, data + sizeof(header) + i * sizeof(CachedLevel), sizeof(level));
+                    const uint64_t level_size = row_stride(level.width, channels) * uint64_t(level.height);
+                    if (level.width <= 0 or level.height <= 0 or level.offset > size or level_size > size - level.offset)
+                        return std::nullopt;
+
+                    cooked.levels[i] = TextureLevel{ reinterpret_cast<const char*>(data + level.offset), level.width, level.height };
+                }
+                return cooked;
+            }
+
+            std::optional<CookedTexture> map_cache_file(const std::string& cache_path, const SourceKey& key)
+            {
+                auto file = MappedFile::create(cache_path);
+                if (not file)
+                    return std::nullopt;
+
+                auto cooked = parse(file->data(), file->size(), key);
+                if (not cooked.has_value())
+                {
+                    YAZPGP_LOG_DEBUG("Texture cache %s is stale", cache_path.c_str());
+                    return std::nullopt;
+                }
+                cooked->file = std::move(file);
+                return cooked;
+            }
+
+            /**
+             * @brief lays the levels out like the cache file, writes it and keeps the bytes for the upload
+             *
+             * @param faces every face holds its whole mip chain
+             */
+            CookedTexture cook(const std::vector<std::vector<ImageData>>& faces, GLenum internal_format, GLenum format, const SourceKey& key, const std::string& cache_path)
+            {
+                const uint32_t level_count = static_cast<uint32_t>(faces[0].size());
+                const size_t total_levels = faces.size() * level_count;
+
+                std::vector<CachedLevel> levels(total_levels);
+                uint64_t offset = align_up(sizeof(TextureCacheHeader) + total_levels * sizeof(CachedLevel));
+                for (size_t face = 0; face < faces.size(); face++)
+                {
+                    for (size_t level = 0; level < level_count; level++)
+                    {
+                        const ImageData& image = faces[face][level];
+                        levels[face * level_count + level] = CachedLevel{ offset, image.width, image.height };
+                        offset = align_up(offset + image.bytes.size());
+                    }
+                }
+
+                TextureCacheHeader header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = FORMAT_VERSION;
+                header.source_hash = key.hash;
+                header.source_size = key.size;
+                header.internal_format = internal_format;
+                header.format = format;
+                header.face_count = static_cast<uint32_t>(faces.size());
+                header.level_count = level_count;
+
+                std::vector<char> bytes(offset);
+                std::memcpy(bytes.data(), &header, sizeof(header));
+                std::memcpy(bytes.data() + sizeof(header), levels.data(), levels.size() * sizeof(CachedLevel));
+                for (size_t face = 0; face < faces.size(); face++)
+                {
+                    for (size_t level = 0; level < level_count; level++)
+                    {
+                        const ImageData& image = faces[face][level];
+                        std::memcpy(bytes.data() + levels[face * level_count + level].offset, image.bytes.data(), image.bytes.size());
+                    }
+                }
+
+                if (replace_file(cache_path, bytes))
+                    YAZPGP_LOG_INFO("Cooked texture cached as %s", cache_path.c_str());
+                else
+                    YAZPGP_LOG_ERROR("Failed to write texture cache: %s", cache_path.c_str());
+
+                auto cooked = parse(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size(), key).value();
+                // moving the vector keeps its buffer, the levels stay valid
+                cooked.bytes = std::move(bytes);
+                return cooked;
+            }
+        }
+
+        std::optional<CookedTexture> read_cooked_texture(const std::string& path, const std::string& cache_directory)
+        {
+            const auto key = source_key(path);
+            if (not key.has_value())
+                return std::nullopt;
+
+            const std::string cache_path = cache_file_path(cache_directory, key->hash, "2d");
+            if (auto cooked = map_cache_file(cache_path, key.value()))
+                return cooked;
+
+            auto image = read_image(path, true);
+            if (not image.has_value())
+                return std::nullopt;
+            if (image->channels != 3 and image->channels != 4)
+            {
+                YAZPGP_LOG_ERROR("Unsupported channel count %u of texture %s", image->channels, path.c_str());
+                return std::nullopt;
+            }
+
+            const bool has_alpha = image->channels == 4;
+            std::vector<std::vector<ImageData>> faces;
+            faces.push_back(mip_chain(std::move(image.value())));
+            return cook(faces, has_alpha ? GL_RGBA8 : GL_RGB8, has_alpha ? GL_RGBA : GL_RGB, key.value(), cache_path);
+        }
+
+        std::optional<CookedTexture> read_cooked_cubemap(const std::array<std::string, 6>& paths, const std::string& cache_directory)
+        {
+            // the six sources hash into one key
+            SourceKey key{ 0, 0 };
+            for (const auto& path : paths)
+            {
+                const auto face_key = source_key(path);
+                if (not face_key.has_value())
+                    return std::nullopt;
+
+                key.hash = (key.hash ^ face_key->hash) * 0x100000001b3ull;
+                key.size += face_key->size;
+            }
+
+            const std::string cache_path = cache_file_path(cache_directory, key.hash, "cube");
+            if (auto cooked = map_cache_file(cache_path, key))
+                return cooked;
+
+            std::vector<std::vector<ImageData>> faces;
+            for (const auto& path : paths)
+            {
+                auto image = read_image(path, false);
+                if (not image.has_value())
+                    return std::nullopt;
+
+                // faces are stored as RGB like CubeMap::upload does
+                faces.push_back({});
+                faces.back().push_back(with_channels(std::move(image.value()), 3));
+                if (faces.back()[0].width != faces[0][0].width or faces.back()[0].height != faces[0][0].height)
+                {
+                    YAZPGP_LOG_ERROR("Cubemap face %s differs in size from the first face", path.c_str());
+                    return std::nullopt;
+                }
+            }
+            return cook(faces, GL_RGB8, GL_RGB, key, cache_path);
+        }
+    }
+}
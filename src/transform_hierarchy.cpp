@@ -0,0 +1,112 @@
+#include "transform_hierarchy.hpp"
+#include "logger.hpp"
+
+namespace yazpgp
+{
+    uint32_t TransformHierarchy::add(const glm::mat4& local_matrix, uint32_t parent)
+    {
+        const uint32_t node = static_cast<uint32_t>(m_parents.size());
+        if (parent != NO_PARENT and parent >= node)
+        {
+            YAZPGP_LOG_WARN("Parent %u of transform node %u does not exist, adding it as a root", parent, node);
+            parent = NO_PARENT;
+        }
+
+        m_parents.push_back(parent);
+        m_local_matrices.push_back(local_matrix);
+        m_world_matrices.push_back(local_matrix);
+        m_dirty.push_back(1);
+        return node;
+    }
+
+    void TransformHierarchy::remove(uint32_t node)
+    {
+        if (node >= m_parents.size())
+            return;
+
+        // children keep their local matrix, so they jump to where the new parent puts them
+        const uint32_t parent = m_parents[node];
+        for (size_t i = node + 1; i < m_parents.size(); i++)
+        {
+            if (m_parents[i] == node)
+            {
+                m_parents[i] = parent;
+                m_dirty[i] = 1;
+            }
+        }
+
+        m_parents.erase(m_parents.begin() + node);
+        m_local_matrices.erase(m_local_matrices.begin() + node);
+        m_world_matrices.erase(m_world_matrices.begin() + node);
+        m_dirty.erase(m_dirty.begin() + node);
+
+        for (size_t i = node; i < m_parents.size(); i++)
+        {
+            if (m_parents[i] != NO_PARENT and m_parents[i] > node)
+                m_parents[i]--;
+        }
+    }
+
+    void TransformHierarchy::clear()
+    {
+        m_parents.clear();
+        m_local_matrices.clear();
+        m_world_matrices.clear();
+        m_dirty.clear();
+        m_updated.clear();
+    }
+
+    void TransformHierarchy::set_local_matrix(uint32_t node, const glm::mat4& local_matrix)
+    {
+        if (m_local_matrices[node] == local_matrix)
+            return;
+
+        m_local_matrices[node] = local_matrix;
+        m_dirty[node] = 1;
+    }
+
+    const std::vector<uint32_t>& TransformHierarchy::update()
+    {
+        m_updated.clear();
+        for (size_t i = 0; i < m_parents.size(); i++)
+        {
+            const uint32_t parent = m_parents[i];
+            if (parent != NO_PARENT and m_dirty[parent])
+                m_dirty[i] = 1;
+
+            if (not m_dirty[i])
+                continue;
+
+            m_world_matrices[i] = parent == NO_PARENT
+                ? m_local_matrices[i]
+                : m_world_matrices[parent] * m_local_matrices[i];
+            m_updated.push_back(static_cast<uint32_t>(i));
+        }
+
+        // flags are cleared only after the pass, children read the flag of their parent
+        for (auto node : m_updated)
+            m_dirty[node] = 0;
+
+        return m_updated;
+    }
+
+    const glm::mat4& TransformHierarchy::local_matrix(uint32_t node) const
+    {
+        return m_local_matrices[node];
+    }
+
+    const glm::mat4& TransformHierarchy::world_matrix(uint32_t node) const
+    {
+        return m_world_matrices[node];
+    }
+
+    uint32_t TransformHierarchy::parent(uint32_t node) const
+    {
+        return m_parents[node];
+    }
+
+    size_t TransformHierarchy::size() const
+    {
+        return m_parents.size();
+    }
+}
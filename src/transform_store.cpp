@@ -0,0 +1,335 @@
+#include "transform_store.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__AVX2__) or defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace yazpgp
+{
+    namespace
+    {
+        // the kernels below are written once against Lanes, the widest instruction set enabled at compile time picks its width
+#if defined(__AVX2__)
+        struct Lanes
+        {
+            constexpr static size_t COUNT = 8;
+            __m256 v;
+
+            static Lanes load(const float* p) { return { _mm256_load_ps(p) }; }
+            static Lanes set(float x) { return { _mm256_set1_ps(x) }; }
+            void store(float* p) const { _mm256_store_ps(p, v); }
+
+            friend Lanes operator+(Lanes a, Lanes b) { return { _mm256_add_ps(a.v, b.v) }; }
+            friend Lanes operator-(Lanes a, Lanes b) { return { _mm256_sub_ps(a.v, b.v) }; }
+            friend Lanes operator*(Lanes a, Lanes b) { return { _mm256_mul_ps(a.v, b.v) }; }
+            friend Lanes operator/(Lanes a, Lanes b) { return { _mm256_div_ps(a.v, b.v) }; }
+            friend Lanes absolute(Lanes a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+            friend bool all_less_equal(Lanes a, Lanes b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)) == 0xFF; }
+        };
+#elif defined(__SSE2__)
+        struct Lanes
+        {
+            constexpr static size_t COUNT = 4;
+            __m128 v;
+
+            static Lanes load(const float* p) { return { _mm_load_ps(p) }; }
+            static Lanes set(float x) { return { _mm_set1_ps(x) }; }
+            void store(float* p) const { _mm_store_ps(p, v); }
+
+            friend Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.v, b.v) }; }
+            friend Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+            friend Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+            friend Lanes operator/(Lanes a, Lanes b) { return { _mm_div_ps(a.v, b.v) }; }
+            friend Lanes absolute(Lanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+            friend bool all_less_equal(Lanes a, Lanes b) { return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v)) == 0xF; }
+        };
+#else
+        struct Lanes
+        {
+            constexpr static size_t COUNT = 1;
+            float v;
+
+            static Lanes load(const float* p) { return { *p }; }
+            static Lanes set(float x) { return { x }; }
+            void store(float* p) const { *p = v; }
+
+            friend Lanes operator+(Lanes a, Lanes b) { return { a.v + b.v }; }
+            friend Lanes operator-(Lanes a, Lanes b) { return { a.v - b.v }; }
+            friend Lanes operator*(Lanes a, Lanes b) { return { a.v * b.v }; }
+            friend Lanes operator/(Lanes a, Lanes b) { return { a.v / b.v }; }
+            friend Lanes absolute(Lanes a) { return { std::fabs(a.v) }; }
+            friend bool all_less_equal(Lanes a, Lanes b) { return a.v <= b.v; }
+        };
+#endif
+
+        using LaneArray = float[Lanes::COUNT];
+
+        // SIMD batches composed by one job, 256 entries with SSE2
+        constexpr uint32_t BATCHES_PER_JOB = 64;
+
+        struct Vec3Lanes
+        {
+            Lanes x, y, z;
+
+            static Vec3Lanes load(const LaneArray (&p)[3]) { return { Lanes::load(p[0]), Lanes::load(p[1]), Lanes::load(p[2]) }; }
+            void store(LaneArray (&p)[3]) const { x.store(p[0]); y.store(p[1]); z.store(p[2]); }
+
+            friend Vec3Lanes operator*(Vec3Lanes a, Lanes s) { return { a.x * s, a.y * s, a.z * s }; }
+            friend Lanes dot(Vec3Lanes a, Vec3Lanes b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+            friend Vec3Lanes cross(Vec3Lanes a, Vec3Lanes b)
+            {
+                return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+            }
+        };
+
+        /**
+         * @brief rotation from euler half angles times scale, the same matrix glm::toMat4(glm::quat(angles)) * scale gives
+         */
+        void compose_rotation_scale(
+            const LaneArray (&sines)[3],
+            const LaneArray (&cosines)[3],
+            const LaneArray (&scales)[3],
+            LaneArray (&columns)[3][3]
+        )
+        {
+            const Lanes sx = Lanes::load(sines[0]), sy = Lanes::load(sines[1]), sz = Lanes::load(sines[2]);
+            const Lanes cx = Lanes::load(cosines[0]), cy = Lanes::load(cosines[1]), cz = Lanes::load(cosines[2]);
+
+            const Lanes w = cx * cy * cz + sx * sy * sz;
+            const Lanes x = sx * cy * cz - cx * sy * sz;
+            const Lanes y = cx * sy * cz + sx * cy * sz;
+            const Lanes z = cx * cy * sz - sx * sy * cz;
+
+            const Lanes xx = x * x, yy = y * y, zz = z * z;
+            const Lanes xy = x * y, xz = x * z, yz = y * z;
+            const Lanes wx = w * x, wy = w * y, wz = w * z;
+            const Lanes one = Lanes::set(1.0f);
+            const Lanes two = Lanes::set(2.0f);
+
+            const Vec3Lanes column0{ one - two * (yy + zz), two * (xy + wz), two * (xz - wy) };
+            const Vec3Lanes column1{ two * (xy - wz), one - two * (xx + zz), two * (yz + wx) };
+            const Vec3Lanes column2{ two * (xz + wy), two * (yz - wx), one - two * (xx + yy) };
+
+            (column0 * Lanes::load(scales[0])).store(columns[0]);
+            (column1 * Lanes::load(scales[1])).store(columns[1]);
+            (column2 * Lanes::load(scales[2])).store(columns[2]);
+        }
+
+        void invert_transpose(const LaneArray (&matrix)[3][3], LaneArray (&normal)[3][3])
+        {
+            const Vec3Lanes a = Vec3Lanes::load(matrix[0]);
+            const Vec3Lanes b = Vec3Lanes::load(matrix[1]);
+            const Vec3Lanes c = Vec3Lanes::load(matrix[2]);
+
+            // uniform scale s: the columns are orthogonal with squared length s^2 and (sR)^-T = sR / s^2
+            const Lanes length_squared = dot(a, a);
+            const Lanes tolerance = length_squared * Lanes::set(1e-4f);
+            const bool uniform_scale = all_less_equal(absolute(dot(b, b) - length_squared), tolerance)
+                and all_less_equal(absolute(dot(c, c) - length_squared), tolerance)
+                and all_less_equal(absolute(dot(a, b)), tolerance)
+                and all_less_equal(absolute(dot(b, c)), tolerance)
+                and all_less_equal(absolute(dot(c, a)), tolerance);
+
+            if (uniform_scale)
+            {
+                const Lanes inverse_length_squared = Lanes::set(1.0f) / length_squared;
+                (a * inverse_length_squared).store(normal[0]);
+                (b * inverse_length_squared).store(normal[1]);
+                (c * inverse_length_squared).store(normal[2]);
+                return;
+            }
+
+            // rows of the inverse are the cross products of the columns over the determinant
+            const Vec3Lanes bc = cross(b, c);
+            const Lanes inverse_determinant = Lanes::set(1.0f) / dot(a, bc);
+            (bc * inverse_determinant).store(normal[0]);
+            (cross(c, a) * inverse_determinant).store(normal[1]);
+            (cross(a, b) * inverse_determinant).store(normal[2]);
+        }
+    }
+
+    const size_t TransformStore::LANES = Lanes::COUNT;
+
+    uint32_t TransformStore::add(const Transform& transform)
+    {
+        const uint32_t index = static_cast<uint32_t>(m_dirty.size());
+        m_position_x.push_back(transform.position_data.x);
+        m_position_y.push_back(transform.position_data.y);
+        m_position_z.push_back(transform.position_data.z);
+        m_rotation_x.push_back(transform.rotation_data.x);
+        m_rotation_y.push_back(transform.rotation_data.y);
+        m_rotation_z.push_back(transform.rotation_data.z);
+        m_scale_x.push_back(transform.scale_data.x);
+        m_scale_y.push_back(transform.scale_data.y);
+        m_scale_z.push_back(transform.scale_data.z);
+        m_model_matrices.push_back(glm::mat4(1.0f));
+        m_dirty.push_back(1);
+        return index;
+    }
+
+    void TransformStore::remove(uint32_t index)
+    {
+        if (index >= m_dirty.size())
+            return;
+
+        for (auto* component : {
+            &m_position_x, &m_position_y, &m_position_z,
+            &m_rotation_x, &m_rotation_y, &m_rotation_z,
+            &m_scale_x, &m_scale_y, &m_scale_z })
+        {
+            component->erase(component->begin() + index);
+        }
+        m_model_matrices.erase(m_model_matrices.begin() + index);
+        m_dirty.erase(m_dirty.begin() + index);
+    }
+
+    void TransformStore::clear()
+    {
+        for (auto* component : {
+            &m_position_x, &m_position_y, &m_position_z,
+            &m_rotation_x, &m_rotation_y, &m_rotation_z,
+            &m_scale_x, &m_scale_y, &m_scale_z })
+        {
+            component->clear();
+        }
+        m_model_matrices.clear();
+        m_dirty.clear();
+        m_updated.clear();
+    }
+
+    void TransformStore::set(uint32_t index, const Transform& transform)
+    {
+        const auto assign = [this, index](std::vector<float>& component, float value)
+        {
+            if (component[index] == value)
+                return;
+
+            component[index] = value;
+            m_dirty[index] = 1;
+        };
+
+        assign(m_position_x, transform.position_data.x);
+        assign(m_position_y, transform.position_data.y);
+        assign(m_position_z, transform.position_data.z);
+        assign(m_rotation_x, transform.rotation_data.x);
+        assign(m_rotation_y, transform.rotation_data.y);
+        assign(m_rotation_z, transform.rotation_data.z);
+        assign(m_scale_x, transform.scale_data.x);
+        assign(m_scale_y, transform.scale_data.y);
+        assign(m_scale_z, transform.scale_data.z);
+    }
+
+    const std::vector<uint32_t>& TransformStore::update(JobSystem* jobs)
+    {
+        m_updated.clear();
+        for (size_t i = 0; i < m_dirty.size(); i++)
+        {
+            if (m_dirty[i])
+                m_updated.push_back(static_cast<uint32_t>(i));
+        }
+
+        // batches write disjoint entries, chunks of them are composed in parallel
+        const uint32_t batch_count = static_cast<uint32_t>((m_updated.size() + Lanes::COUNT - 1) / Lanes::COUNT);
+        parallel_for(jobs, batch_count, BATCHES_PER_JOB, [this](uint32_t first_batch, uint32_t end_batch)
+        {
+            const size_t end = std::min<size_t>(end_batch * Lanes::COUNT, m_updated.size());
+            for (size_t first = first_batch * Lanes::COUNT; first < end; first += Lanes::COUNT)
+            {
+                const size_t count = std::min(Lanes::COUNT, m_updated.size() - first);
+
+                // trigonometry stays scalar, lanes past count compose an identity matrix
+                alignas(32) LaneArray sines[3];
+                alignas(32) LaneArray cosines[3];
+                alignas(32) LaneArray scales[3];
+                alignas(32) LaneArray columns[3][3];
+                for (size_t lane = 0; lane < Lanes::COUNT; lane++)
+                {
+                    const bool used = lane < count;
+                    const uint32_t index = used ? m_updated[first + lane] : 0;
+                    const glm::vec3 half_angles = used
+                        ? glm::radians(glm::vec3(m_rotation_x[index], m_rotation_y[index], m_rotation_z[index])) * 0.5f
+                        : glm::vec3(0.0f);
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        sines[axis][lane] = std::sin(half_angles[axis]);
+                        cosines[axis][lane] = std::cos(half_angles[axis]);
+                    }
+                    scales[0][lane] = used ? m_scale_x[index] : 1.0f;
+                    scales[1][lane] = used ? m_scale_y[index] : 1.0f;
+                    scales[2][lane] = used ? m_scale_z[index] : 1.0f;
+                }
+
+                compose_rotation_scale(sines, cosines, scales, columns);
+
+                for (size_t lane = 0; lane < count; lane++)
+                {
+                    const uint32_t index = m_updated[first + lane];
+                    auto& model_matrix = m_model_matrices[index];
+                    for (int column = 0; column < 3; column++)
+                        model_matrix[column] = glm::vec4(columns[column][0][lane], columns[column][1][lane], columns[column][2][lane], 0.0f);
+                    model_matrix[3] = glm::vec4(m_position_x[index], m_position_y[index], m_position_z[index], 1.0f);
+                    m_dirty[index] = 0;
+                }
+            }
+        });
+
+        return m_updated;
+    }
+
+    Transform TransformStore::transform(uint32_t index) const
+    {
+        return Transform(
+            glm::vec3(m_position_x[index], m_position_y[index], m_position_z[index]),
+            glm::vec3(m_rotation_x[index], m_rotation_y[index], m_rotation_z[index]),
+            glm::vec3(m_scale_x[index], m_scale_y[index], m_scale_z[index])
+        );
+    }
+
+    const glm::mat4& TransformStore::model_matrix(uint32_t index) const
+    {
+        return m_model_matrices[index];
+    }
+
+    size_t TransformStore::size() const
+    {
+        return m_dirty.size();
+    }
+
+    void compute_normal_matrices(const glm::mat4* model_matrices, size_t count, glm::mat3* normal_matrices)
+    {
+        for (size_t first = 0; first < count; first += Lanes::COUNT)
+        {
+            const size_t batch_count = std::min(Lanes::COUNT, count - first);
+
+            // lanes past batch_count invert an identity matrix
+            alignas(32) LaneArray matrix[3][3];
+            alignas(32) LaneArray normal[3][3];
+            for (size_t lane = 0; lane < Lanes::COUNT; lane++)
+            {
+                const glm::mat3 upper = lane < batch_count ? glm::mat3(model_matrices[first + lane]) : glm::mat3(1.0f);
+                for (int column = 0; column < 3; column++)
+                {
+                    for (int row = 0; row < 3; row++)
+                        matrix[column][row][lane] = upper[column][row];
+                }
+            }
+
+            invert_transpose(matrix, normal);
+
+            for (size_t lane = 0; lane < batch_count; lane++)
+            {
+                auto& normal_matrix = normal_matrices[first + lane];
+                for (int column = 0; column < 3; column++)
+                {
+                    for (int row = 0; row < 3; row++)
+                        normal_matrix[column][row] = normal[column][row][lane];
+                }
+            }
+        }
+    }
+}
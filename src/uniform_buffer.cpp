@@ -0,0 +1,40 @@
+#include "uniform_buffer.hpp"
+#include "logger.hpp"
+
+namespace yazpgp
+{
+    UniformBuffer::UniformBuffer(GLuint binding, size_t size_bytes)
+        : m_binding(binding)
+        , m_size_bytes(size_bytes)
+    {
+    }
+
+    UniformBuffer::~UniformBuffer()
+    {
+        if (m_buffer)
+            glDeleteBuffers(1, &m_buffer);
+    }
+
+    void UniformBuffer::upload(const void* data, size_t size_bytes, size_t offset_bytes)
+    {
+        if (offset_bytes + size_bytes > m_size_bytes)
+        {
+            YAZPGP_LOG_ERROR("Uniform buffer upload of %zu bytes at %zu overflows %zu bytes", size_bytes, offset_bytes, m_size_bytes);
+            return;
+        }
+
+        if (not m_buffer)
+        {
+            glCreateBuffers(1, &m_buffer);
+            glNamedBufferStorage(m_buffer, m_size_bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        }
+
+        glNamedBufferSubData(m_buffer, offset_bytes, size_bytes, data);
+    }
+
+    void UniformBuffer::bind() const
+    {
+        if (m_buffer)
+            glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+    }
+}
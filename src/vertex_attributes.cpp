@@ -3,41 +3,91 @@
 #include <algorithm>
 namespace yazpgp
 {
+    namespace
+    {
+        bool is_packed(GLenum type)
+        {
+            return type == GL_INT_2_10_10_10_REV or type == GL_UNSIGNED_INT_2_10_10_10_REV;
+        }
+
+        // 0 for types the layout does not support
+        size_t size_bytes_of(const VertexAttribute& attribute)
+        {
+            if (is_packed(attribute.type))
+                return attribute.size == 4 ? 4 : 0;
+
+            switch (attribute.type)
+            {
+            case GL_FLOAT:
+                return attribute.size * sizeof(GLfloat);
+            case GL_HALF_FLOAT:
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+                return attribute.size * sizeof(GLushort);
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return attribute.size * sizeof(GLubyte);
+            default:
+                return 0;
+            }
+        }
+    }
+
     VertexAttributeLayout::VertexAttributeLayout(const std::vector<VertexAttribute>& attributes)
         : m_attributes(attributes)
     {
         if (m_attributes.empty())
             YAZPGP_LOG_WARN("VertexAttributeLayout created with no attributes");
-        
+
         if (std::any_of(m_attributes.begin(), m_attributes.end(), [](const auto& attribute) { return attribute.size == 0; }))
             YAZPGP_LOG_WARN("VertexAttributeLayout created with an attribute with size 0");
-        
-        if (std::any_of(m_attributes.begin(), m_attributes.end(), [](const auto& attribute) { return attribute.type != GL_FLOAT; }))
-            YAZPGP_LOG_FATAL("VertexAttributeLayout supports only GL_FLOAT attributes for now");
+
+        if (std::any_of(m_attributes.begin(), m_attributes.end(), [](const auto& attribute) { return size_bytes_of(attribute) == 0 and attribute.size != 0; }))
+            YAZPGP_LOG_FATAL("VertexAttributeLayout supports float, half float, 8 and 16-bit integer and packed 2_10_10_10 attributes");
 
         m_stride = 0;
+        m_offsets.reserve(m_attributes.size());
         for (const auto& attribute : m_attributes)
-            m_stride += attribute.size * sizeof(float);
+        {
+            m_offsets.push_back(m_stride);
+            // GL wants every attribute 4 byte aligned, smaller ones are padded
+            m_stride += (size_bytes_of(attribute) + 3) & ~size_t(3);
+        }
     }
 
     void VertexAttributeLayout::use() const
     {
-        size_t offset = 0;
         for (size_t i = 0; i < m_attributes.size(); i++)
         {
             const auto& attribute = m_attributes[i];
-            glVertexAttribPointer(i, attribute.size, attribute.type, attribute.normalized, m_stride, (void*)offset);
+            glVertexAttribPointer(i, attribute.size, attribute.type, attribute.normalized, m_stride, (void*)m_offsets[i]);
             glEnableVertexAttribArray(i);
-            offset += attribute.size * sizeof(float);
         }
-        // glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        // glEnableVertexAttribArray(0);
-        // glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)12);
-        // glEnableVertexAttribArray(1);
+    }
+
+    void VertexAttributeLayout::apply(GLuint vertex_array, GLuint binding_index) const
+    {
+        for (GLuint i = 0; i < m_attributes.size(); i++)
+        {
+            const auto& attribute = m_attributes[i];
+            glEnableVertexArrayAttrib(vertex_array, i);
+            glVertexArrayAttribFormat(vertex_array, i, attribute.size, attribute.type, attribute.normalized, m_offsets[i]);
+            glVertexArrayAttribBinding(vertex_array, i, binding_index);
+        }
     }
 
     size_t VertexAttributeLayout::get_stride() const
     {
         return m_stride;
     }
-}
\ No newline at end of file
+
+    const std::vector<VertexAttribute>& VertexAttributeLayout::attributes() const
+    {
+        return m_attributes;
+    }
+
+    bool VertexAttributeLayout::operator==(const VertexAttributeLayout& other) const
+    {
+        return m_attributes == other.m_attributes;
+    }
+}
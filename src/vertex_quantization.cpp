@@ -0,0 +1,202 @@
+#include "vertex_quantization.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace yazpgp
+{
+    namespace
+    {
+        // largest finite half float
+        constexpr float HALF_MAX = 65504.0f;
+        // positions may be off by this fraction of the largest mesh dimension
+        constexpr float POSITION_TOLERANCE = 1.0f / 1024.0f;
+        // half floats resolve texture coordinates up to here to about a texel of a 1024 texture
+        constexpr float HALF_TEXCOORD_LIMIT = 2.0f;
+
+        enum class PositionFormat { HALF, FLOAT };
+        enum class TexcoordFormat { UNORM16, HALF, FLOAT };
+
+        // distance between adjacent half floats around value
+        float half_spacing(float value)
+        {
+            int exponent = 0;
+            std::frexp(value, &exponent);
+            // 10 explicit mantissa bits, subnormals below 2^-14 are evenly spaced
+            return std::ldexp(1.0f, std::max(exponent - 1, -14) - 10);
+        }
+
+        PositionFormat position_format(const AABB& bounds)
+        {
+            if (bounds.is_empty())
+                return PositionFormat::HALF;
+
+            const glm::vec3 largest = glm::max(glm::abs(bounds.min), glm::abs(bounds.max));
+            const float largest_coordinate = std::max({ largest.x, largest.y, largest.z });
+            const glm::vec3 size = bounds.max - bounds.min;
+            const float largest_size = std::max({ size.x, size.y, size.z });
+            if (largest_coordinate >= HALF_MAX)
+                return PositionFormat::FLOAT;
+            // a mesh far from its origin loses its detail first
+            return half_spacing(largest_coordinate) <= largest_size * POSITION_TOLERANCE ? PositionFormat::HALF : PositionFormat::FLOAT;
+        }
+
+        TexcoordFormat texcoord_format(std::span<const Vertex> vertices)
+        {
+            float lowest = 0.0f;
+            float highest = 0.0f;
+            for (const auto& vertex : vertices)
+            {
+                lowest = std::min({ lowest, vertex.u, vertex.v });
+                highest = std::max({ highest, vertex.u, vertex.v });
+            }
+
+            if (lowest >= 0.0f and highest <= 1.0f)
+                return TexcoordFormat::UNORM16;
+            if (std::max(-lowest, highest) <= HALF_TEXCOORD_LIMIT)
+                return TexcoordFormat::HALF;
+            return TexcoordFormat::FLOAT;
+        }
+
+        uint16_t to_unorm16(float value)
+        {
+            return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        }
+
+        template <typename T>
+        std::byte* write(std::byte* destination, const T& value)
+        {
+            std::memcpy(destination, &value, sizeof(T));
+            return destination + sizeof(T);
+        }
+    }
+
+    uint16_t to_half_float(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const uint32_t float_exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        if (float_exponent == 0xff)
+            return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+        const int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+        if (exponent >= 31)
+            return sign | 0x7c00;
+
+        if (exponent <= 0)
+        {
+            // subnormal, everything below half the smallest one rounds to zero
+            if (exponent < -10)
+                return sign;
+            mantissa |= 0x800000;
+            const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            const uint32_t rest = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway or (rest == halfway and (half & 1)))
+                half++;
+            return sign | static_cast<uint16_t>(half);
+        }
+
+        // a carry out of the mantissa correctly bumps the exponent, up to infinity
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        const uint32_t rest = mantissa & 0x1fff;
+        if (rest > 0x1000 or (rest == 0x1000 and (half & 1)))
+            half++;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint32_t pack_snorm_10_10_10_2(float x, float y, float z, float w)
+    {
+        const auto component = [](float value, float scale, uint32_t mask)
+        {
+            return static_cast<uint32_t>(static_cast<int32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * scale))) & mask;
+        };
+        return component(x, 511.0f, 0x3ff)
+            | component(y, 511.0f, 0x3ff) << 10
+            | component(z, 511.0f, 0x3ff) << 20
+            | component(w, 1.0f, 0x3) << 30;
+    }
+
+    QuantizedVertices quantize_vertices(std::span<const Vertex> vertices, const AABB& bounds)
+    {
+        const PositionFormat positions = position_format(bounds);
+        const TexcoordFormat texcoords = texcoord_format(vertices);
+
+        std::vector<VertexAttribute> attributes;
+        // half positions carry w = 1 to keep the attribute 4 byte aligned without padding
+        attributes.push_back(positions == PositionFormat::HALF
+            ? VertexAttribute{ .size = 4, .type = GL_HALF_FLOAT, .normalized = GL_FALSE }
+            : VertexAttribute{ .size = 3, .type = GL_FLOAT, .normalized = GL_FALSE });
+        attributes.push_back({ .size = 4, .type = GL_INT_2_10_10_10_REV, .normalized = GL_TRUE });
+        switch (texcoords)
+        {
+        case TexcoordFormat::UNORM16:
+            attributes.push_back({ .size = 2, .type = GL_UNSIGNED_SHORT, .normalized = GL_TRUE });
+            break;
+        case TexcoordFormat::HALF:
+            attributes.push_back({ .size = 2, .type = GL_HALF_FLOAT, .normalized = GL_FALSE });
+            break;
+        case TexcoordFormat::FLOAT:
+            attributes.push_back({ .size = 2, .type = GL_FLOAT, .normalized = GL_FALSE });
+            break;
+        }
+        attributes.push_back({ .size = 4, .type = GL_INT_2_10_10_10_REV, .normalized = GL_TRUE });
+
+        QuantizedVertices quantized{ .bytes = {}, .layout = VertexAttributeLayout(attributes) };
+        const size_t stride = quantized.layout.get_stride();
+        quantized.bytes.resize(vertices.size() * stride);
+
+        std::byte* destination = quantized.bytes.data();
+        for (const auto& vertex : vertices)
+        {
+            if (positions == PositionFormat::HALF)
+            {
+                destination = write(destination, to_half_float(vertex.x));
+                destination = write(destination, to_half_float(vertex.y));
+                destination = write(destination, to_half_float(vertex.z));
+                destination = write(destination, to_half_float(1.0f));
+            }
+            else
+            {
+                destination = write(destination, vertex.x);
+                destination = write(destination, vertex.y);
+                destination = write(destination, vertex.z);
+            }
+
+            destination = write(destination, pack_snorm_10_10_10_2(vertex.nx, vertex.ny, vertex.nz, 0.0f));
+
+            switch (texcoords)
+            {
+            case TexcoordFormat::UNORM16:
+                destination = write(destination, to_unorm16(vertex.u));
+                destination = write(destination, to_unorm16(vertex.v));
+                break;
+            case TexcoordFormat::HALF:
+                destination = write(destination, to_half_float(vertex.u));
+                destination = write(destination, to_half_float(vertex.v));
+                break;
+            case TexcoordFormat::FLOAT:
+                destination = write(destination, vertex.u);
+                destination = write(destination, vertex.v);
+                break;
+            }
+
+            destination = write(destination, pack_snorm_10_10_10_2(vertex.tx, vertex.ty, vertex.tz, 0.0f));
+        }
+
+        YAZPGP_LOG_DEBUG(
+            "Quantized %zu vertices: %s positions, %s texture coordinates, %zu bytes per vertex",
+            vertices.size(),
+            positions == PositionFormat::HALF ? "half" : "float",
+            texcoords == TexcoordFormat::UNORM16 ? "unorm16" : texcoords == TexcoordFormat::HALF ? "half" : "float",
+            stride
+        );
+        return quantized;
+    }
+}
@@ -22,6 +22,8 @@ namespace yazpgp
 
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
         SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+        // the G-buffer blits its DEPTH24_STENCIL8 attachment into the default framebuffer, formats have to match
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
         SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 
         auto window = SDL_WindowPtr( 